@@ -120,6 +120,11 @@ if (!current_bc_status->init_monero_blockchain())
     return EXIT_FAILURE;
 }
 
+// websockets subscribed to accounts' events, e.g., new txs found.
+// events are pushed from search threads and the monitoring thread.
+current_bc_status->set_account_events(
+            make_shared<xmreg::AccountEvents>());
+
 // launch the status monitoring thread so that it keeps track of blockchain
 // info, e.g., current height. Information from this thread is used
 // by tx searching threads that are launched for each user independently,
@@ -177,6 +182,7 @@ xmreg::YourMoneroRequests open_monero(mysql_accounts, current_bc_status);
 MAKE_RESOURCE(login);
 MAKE_RESOURCE(get_address_txs);
 MAKE_RESOURCE(get_address_info);
+MAKE_RESOURCE(get_addresses_info);
 MAKE_RESOURCE(get_unspent_outs);
 MAKE_RESOURCE(get_random_outs);
 MAKE_RESOURCE(submit_raw_tx);
@@ -185,6 +191,10 @@ MAKE_RESOURCE(import_recent_wallet_request);
 MAKE_RESOURCE(get_tx);
 MAKE_RESOURCE(get_version);
 
+// push based account updates over websocket
+auto subscribe = open_monero.make_websocket_resource(
+            &xmreg::YourMoneroRequests::subscribe, "/subscribe");
+
 // restbed service
 Service service;
 
@@ -192,6 +202,7 @@ Service service;
 service.publish(login);
 service.publish(get_address_txs);
 service.publish(get_address_info);
+service.publish(get_addresses_info);
 service.publish(get_unspent_outs);
 service.publish(get_random_outs);
 service.publish(submit_raw_tx);
@@ -199,6 +210,7 @@ service.publish(import_wallet_request);
 service.publish(import_recent_wallet_request);
 service.publish(get_tx);
 service.publish(get_version);
+service.publish(subscribe);
 
 OMINFO << "JSON API endpoints published";
 
@@ -229,7 +241,17 @@ if (config_json["ssl"]["enable"])
 else
 {
     settings->set_port(app_port);
-    settings->set_default_header("Connection", "close");
+
+    // not using settings->set_default_header for this, as
+    // websocket upgrade responses must not close the connection.
+    for (auto const& resource: {login, get_address_txs, get_address_info,
+                                get_addresses_info, get_unspent_outs, get_random_outs,
+                                submit_raw_tx, import_wallet_request,
+                                import_recent_wallet_request, get_tx,
+                                get_version})
+    {
+        resource->set_default_header("Connection", "close");
+    }
 
     OMINFO << "Start the service at http://127.0.0.1:" << app_port;
 }
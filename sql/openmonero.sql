@@ -45,6 +45,26 @@ CREATE TABLE IF NOT EXISTS `Accounts` (
 
 -- --------------------------------------------------------
 
+--
+-- Table structure for table `AccountSummaries`
+--
+-- Totals of account's rows in `Transactions`, kept up to date
+-- by the triggers on `Transactions` below, so that they dont
+-- need to be summed up for every request.
+--
+
+DROP TABLE IF EXISTS `AccountSummaries`;
+CREATE TABLE IF NOT EXISTS `AccountSummaries` (
+  `account_id` bigint(20) UNSIGNED NOT NULL,
+  `no_of_txs` bigint(20) UNSIGNED NOT NULL DEFAULT '0',
+  `total_received` bigint(20) UNSIGNED NOT NULL DEFAULT '0',
+  `total_received_unlocked` bigint(20) UNSIGNED NOT NULL DEFAULT '0',
+  `last_tx_id` bigint(20) UNSIGNED NOT NULL DEFAULT '0',
+  PRIMARY KEY (`account_id`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+-- --------------------------------------------------------
+
 --
 -- Table structure for table `Inputs`
 --
@@ -85,6 +105,8 @@ CREATE TABLE IF NOT EXISTS `Outputs` (
   `global_index` bigint(20) UNSIGNED NOT NULL,
   `out_index` bigint(20) UNSIGNED NOT NULL DEFAULT '0',
   `mixin` bigint(20) UNSIGNED NOT NULL DEFAULT '0',
+  `subaddr_major` int(10) UNSIGNED NOT NULL DEFAULT '0',
+  `subaddr_minor` int(10) UNSIGNED NOT NULL DEFAULT '0',
   `timestamp` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,
   PRIMARY KEY (`id`),
   UNIQUE KEY `out_pub_key` (`out_pub_key`),
@@ -141,13 +163,59 @@ CREATE TABLE IF NOT EXISTS `Transactions` (
   `timestamp` timestamp NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP,
   PRIMARY KEY (`id`),
   UNIQUE KEY `hash` (`hash`,`account_id`),
-  KEY `account_id_2` (`account_id`)
+  KEY `account_id_2` (`account_id`),
+  KEY `account_id_blockchain_tx_id` (`account_id`,`blockchain_tx_id`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8;
 
+--
+-- Triggers `Transactions`
+--
+
+DROP TRIGGER IF EXISTS `transactions_summary_insert`;
+CREATE TRIGGER `transactions_summary_insert` AFTER INSERT ON `Transactions`
+ FOR EACH ROW INSERT INTO `AccountSummaries`
+    (`account_id`, `no_of_txs`, `total_received`,
+     `total_received_unlocked`, `last_tx_id`)
+    VALUES (NEW.`account_id`, 1, NEW.`total_received`,
+            IF(NEW.`spendable` = 1, NEW.`total_received`, 0), NEW.`id`)
+    ON DUPLICATE KEY UPDATE
+        `no_of_txs` = `no_of_txs` + 1,
+        `total_received` = `total_received` + NEW.`total_received`,
+        `total_received_unlocked` = `total_received_unlocked`
+                + VALUES(`total_received_unlocked`),
+        `last_tx_id` = GREATEST(`last_tx_id`, NEW.`id`);
+
+DROP TRIGGER IF EXISTS `transactions_summary_update`;
+CREATE TRIGGER `transactions_summary_update` AFTER UPDATE ON `Transactions`
+ FOR EACH ROW UPDATE `AccountSummaries` SET
+        `total_received` = `total_received` + NEW.`total_received`
+                - OLD.`total_received`,
+        `total_received_unlocked` = `total_received_unlocked`
+                + IF(NEW.`spendable` = 1, NEW.`total_received`, 0)
+                - IF(OLD.`spendable` = 1, OLD.`total_received`, 0)
+    WHERE `account_id` = NEW.`account_id`;
+
+DROP TRIGGER IF EXISTS `transactions_summary_delete`;
+CREATE TRIGGER `transactions_summary_delete` AFTER DELETE ON `Transactions`
+ FOR EACH ROW UPDATE `AccountSummaries` SET
+        `no_of_txs` = `no_of_txs` - 1,
+        `total_received` = `total_received` - OLD.`total_received`,
+        `total_received_unlocked` = `total_received_unlocked`
+                - IF(OLD.`spendable` = 1, OLD.`total_received`, 0),
+        `last_tx_id` = (SELECT COALESCE(MAX(`id`), 0) FROM `Transactions`
+                        WHERE `account_id` = OLD.`account_id`)
+    WHERE `account_id` = OLD.`account_id`;
+
 --
 -- Constraints for dumped tables
 --
 
+--
+-- Constraints for table `AccountSummaries`
+--
+ALTER TABLE `AccountSummaries`
+  ADD CONSTRAINT `account_id_FK4` FOREIGN KEY (`account_id`) REFERENCES `Accounts` (`id`) ON DELETE CASCADE;
+
 --
 -- Constraints for table `Inputs`
 --
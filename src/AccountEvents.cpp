@@ -0,0 +1,177 @@
+#include "AccountEvents.h"
+
+#include "monero_headers.h"
+#include "om_log.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "openmonero"
+
+namespace xmreg
+{
+
+void
+AccountEvents::subscribe(string const& address, socket_ptr const& socket)
+{
+    std::lock_guard<std::mutex> lck (subscriptions_mtx);
+
+    string const& key = socket->get_key();
+
+    // socket can be subscribed to only one address. so
+    // if it was subscribed before, remove old subscription.
+    auto it = socket_addresses.find(key);
+
+    if (it != socket_addresses.end())
+    {
+        subscriptions[it->second].erase(key);
+
+        if (subscriptions[it->second].empty())
+            subscriptions.erase(it->second);
+    }
+
+    subscriptions[address][key] = socket;
+    socket_addresses[key] = address;
+
+    OMINFO << "Websocket " << key << " subscribed to " << address;
+}
+
+void
+AccountEvents::unsubscribe(socket_ptr const& socket)
+{
+    std::lock_guard<std::mutex> lck (subscriptions_mtx);
+
+    string const& key = socket->get_key();
+
+    auto it = socket_addresses.find(key);
+
+    if (it == socket_addresses.end())
+        return;
+
+    auto sub_it = subscriptions.find(it->second);
+
+    if (sub_it != subscriptions.end())
+    {
+        sub_it->second.erase(key);
+
+        if (sub_it->second.empty())
+            subscriptions.erase(sub_it);
+    }
+
+    socket_addresses.erase(it);
+}
+
+bool
+AccountEvents::has_subscribers(string const& address) const
+{
+    std::lock_guard<std::mutex> lck (subscriptions_mtx);
+    return subscriptions.count(address) > 0;
+}
+
+vector<string>
+AccountEvents::get_subscribed_addresses() const
+{
+    std::lock_guard<std::mutex> lck (subscriptions_mtx);
+
+    vector<string> addresses;
+    addresses.reserve(subscriptions.size());
+
+    for (auto const& sub: subscriptions)
+        addresses.push_back(sub.first);
+
+    return addresses;
+}
+
+size_t
+AccountEvents::no_of_subscribers() const
+{
+    std::lock_guard<std::mutex> lck (subscriptions_mtx);
+    return socket_addresses.size();
+}
+
+void
+AccountEvents::publish(string const& address, json const& event)
+{
+    vector<socket_ptr> sockets;
+
+    {
+        std::lock_guard<std::mutex> lck (subscriptions_mtx);
+
+        auto sub_it = subscriptions.find(address);
+
+        if (sub_it == subscriptions.end())
+            return;
+
+        auto& address_sockets = sub_it->second;
+
+        for (auto it = address_sockets.begin(); it != address_sockets.end(); )
+        {
+            socket_ptr socket = it->second.lock();
+
+            if (!socket || socket->is_closed())
+            {
+                socket_addresses.erase(it->first);
+                it = address_sockets.erase(it);
+                continue;
+            }
+
+            sockets.push_back(std::move(socket));
+            ++it;
+        }
+
+        if (address_sockets.empty())
+            subscriptions.erase(sub_it);
+    }
+
+    if (sockets.empty())
+        return;
+
+    // sending is done without holding the lock, as
+    // writing to a slow socket should not block
+    // other publishers.
+    string const event_str = event.dump();
+
+    for (auto const& socket: sockets)
+        socket->send(event_str);
+}
+
+void
+AccountEvents::close_subscriptions(string const& address, json const& event)
+{
+    vector<socket_ptr> sockets;
+
+    {
+        std::lock_guard<std::mutex> lck (subscriptions_mtx);
+
+        auto sub_it = subscriptions.find(address);
+
+        if (sub_it == subscriptions.end())
+            return;
+
+        for (auto const& sub: sub_it->second)
+        {
+            socket_addresses.erase(sub.first);
+
+            socket_ptr socket = sub.second.lock();
+
+            if (socket && !socket->is_closed())
+                sockets.push_back(std::move(socket));
+        }
+
+        subscriptions.erase(sub_it);
+    }
+
+    if (sockets.empty())
+        return;
+
+    string const event_str = event.dump();
+
+    for (auto const& socket: sockets)
+    {
+        socket->send(event_str);
+        socket->close();
+    }
+
+    OMINFO << "Closed " << sockets.size()
+           << " websockets subscribed to " << address;
+}
+
+}
@@ -0,0 +1,93 @@
+#ifndef OPENMONERO_ACCOUNTEVENTS_H
+#define OPENMONERO_ACCOUNTEVENTS_H
+
+#include "../ext/json.hpp"
+#include "../ext/restbed/source/restbed"
+
+#include <memory>
+#include <mutex>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+namespace xmreg
+{
+
+using namespace std;
+using namespace nlohmann;
+
+/**
+ * Keeps track of websockets subscribed to events of
+ * given accounts, and pushes events to them.
+ *
+ * Events are produced by TxSearch threads (new txs found,
+ * txs unlocked, scan progress) and by the blockchain
+ * monitoring thread (txs seen in the mempool). Sockets are
+ * added by YourMoneroRequests::subscribe once a wallet
+ * proves the knowledge of its viewkey.
+ *
+ * All methods are thread safe.
+ */
+class AccountEvents
+{
+public:
+
+    using socket_ptr = std::shared_ptr<restbed::WebSocket>;
+
+    AccountEvents() = default;
+
+    virtual void
+    subscribe(string const& address, socket_ptr const& socket);
+
+    virtual void
+    unsubscribe(socket_ptr const& socket);
+
+    virtual bool
+    has_subscribers(string const& address) const;
+
+    virtual vector<string>
+    get_subscribed_addresses() const;
+
+    virtual size_t
+    no_of_subscribers() const;
+
+    /**
+     * Send event to all sockets subscribed to the address.
+     *
+     * Closed sockets are removed.
+     *
+     * @param address account's address
+     * @param event json with "event" field describing its type
+     */
+    virtual void
+    publish(string const& address, json const& event);
+
+    /**
+     * Send last event to all sockets subscribed to the address,
+     * and close them, e.g., when the account's search thread
+     * is gone. Clients can subscribe again.
+     *
+     * @param address account's address
+     * @param event json with "event" field describing its type
+     */
+    virtual void
+    close_subscriptions(string const& address, json const& event);
+
+    virtual ~AccountEvents() = default;
+
+private:
+
+    mutable mutex subscriptions_mtx;
+
+    //                  address, <socket key, socket>
+    unordered_map<string, map<string, std::weak_ptr<restbed::WebSocket>>>
+            subscriptions;
+
+    // socket key -> address. each socket subscribes to one address.
+    unordered_map<string, string> socket_addresses;
+};
+
+}
+
+#endif //OPENMONERO_ACCOUNTEVENTS_H
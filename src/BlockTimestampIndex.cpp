@@ -0,0 +1,115 @@
+#include "BlockTimestampIndex.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace xmreg
+{
+
+uint64_t
+BlockTimestampIndex::size() const
+{
+    std::lock_guard<std::mutex> lck (mtx);
+    return max_timestamps.size();
+}
+
+void
+BlockTimestampIndex::update(uint64_t from_height,
+                            vector<uint64_t> const& timestamps)
+{
+    std::lock_guard<std::mutex> lck (mtx);
+
+    if (from_height < max_timestamps.size())
+        max_timestamps.resize(from_height);
+
+    // cant have gaps in the index
+    if (from_height > max_timestamps.size())
+        return;
+
+    uint64_t max_timestamp = max_timestamps.empty()
+                             ? 0 : max_timestamps.back();
+
+    max_timestamps.reserve(max_timestamps.size() + timestamps.size());
+
+    for (uint64_t timestamp: timestamps)
+    {
+        max_timestamp = std::max(max_timestamp, timestamp);
+        max_timestamps.push_back(max_timestamp);
+    }
+}
+
+bool
+BlockTimestampIndex::get_height(uint64_t timestamp, uint64_t& height) const
+{
+    std::lock_guard<std::mutex> lck (mtx);
+
+    auto it = std::lower_bound(max_timestamps.begin(),
+                               max_timestamps.end(),
+                               timestamp);
+
+    if (it == max_timestamps.end())
+        return false;
+
+    height = static_cast<uint64_t>(it - max_timestamps.begin());
+
+    return true;
+}
+
+bool
+BlockTimestampIndex::load(string const& path)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+
+    if (!in)
+        return false;
+
+    std::streamoff const file_size = in.tellg();
+
+    if (file_size < 0 || file_size % sizeof(uint64_t) != 0)
+        return false;
+
+    vector<uint64_t> loaded(static_cast<size_t>(file_size)
+                            / sizeof(uint64_t));
+
+    in.seekg(0);
+
+    if (!in.read(reinterpret_cast<char*>(loaded.data()), file_size))
+        return false;
+
+    if (!std::is_sorted(loaded.begin(), loaded.end()))
+        return false;
+
+    std::lock_guard<std::mutex> lck (mtx);
+
+    max_timestamps = std::move(loaded);
+
+    return true;
+}
+
+bool
+BlockTimestampIndex::save(string const& path) const
+{
+    // write to temporary file first, so that crash during
+    // writing does not leave half of the index
+    string const tmp_path = path + ".tmp";
+
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+
+        if (!out)
+            return false;
+
+        std::lock_guard<std::mutex> lck (mtx);
+
+        out.write(reinterpret_cast<char const*>(max_timestamps.data()),
+                  max_timestamps.size() * sizeof(uint64_t));
+
+        if (!out)
+            return false;
+    }
+
+    return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+}
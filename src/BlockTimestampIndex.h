@@ -0,0 +1,63 @@
+#ifndef OPENMONERO_BLOCKTIMESTAMPINDEX_H
+#define OPENMONERO_BLOCKTIMESTAMPINDEX_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace xmreg
+{
+
+using namespace std;
+
+/**
+ * Maps dates to block heights, so that wallets can be
+ * imported from a given date, rather than from
+ * a given number of blocks back.
+ *
+ * Block timestamps are not monotonic, so for each height
+ * we keep the max timestamp of all blocks up to that height.
+ * This is non-decreasing and can be binary searched.
+ *
+ * The index is kept in memory, and can be saved to a file
+ * so that it does not have to be rebuilt from lmdb
+ * on each start.
+ */
+class BlockTimestampIndex
+{
+public:
+
+    // number of indexed blocks, i.e., height of next block to index
+    uint64_t
+    size() const;
+
+    // replaces the index from from_height with timestamps
+    // of blocks from_height, from_height + 1, ...
+    void
+    update(uint64_t from_height, vector<uint64_t> const& timestamps);
+
+    // height of the first block which could have been mined
+    // at or after the given timestamp. all blocks before it are
+    // older than the timestamp. false if there is no such block.
+    bool
+    get_height(uint64_t timestamp, uint64_t& height) const;
+
+    bool
+    load(string const& path);
+
+    bool
+    save(string const& path) const;
+
+private:
+
+    // max timestamp of all blocks up to and including given height
+    vector<uint64_t> max_timestamps;
+
+    // to synchronize access to max_timestamps
+    mutable mutex mtx;
+};
+
+}
+
+#endif //OPENMONERO_BLOCKTIMESTAMPINDEX_H
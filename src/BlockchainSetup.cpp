@@ -167,11 +167,21 @@ BlockchainSetup::_init()
             = config_json["max_number_of_blocks_to_import"];
     search_thread_life_in_seconds
             = config_json["search_thread_life_in_seconds"];
+    output_key_cache_size
+            = config_json.value("output_key_cache_size", 200000);
+    subaddress_lookahead_major
+            = config_json.value("subaddress_lookahead_major", 5);
+    subaddress_lookahead_minor
+            = config_json.value("subaddress_lookahead_minor", 200);
     import_fee
             = config_json["wallet_import"]["fee"];
 
     get_blockchain_path();
 
+    if (config_json.count("block-timestamps-file"))
+        block_timestamps_file = config_json["block-timestamps-file"]
+                .value(get_network_name(net_type), string {});
+
     parse_addr_and_viewkey();
 }
 
@@ -47,6 +47,19 @@ public:
 
     uint64_t search_thread_life_in_seconds;
 
+    // max number of outputs kept in CurrentBlockchainStatus's
+    // output key cache
+    uint64_t output_key_cache_size;
+
+    // subaddresses (major, minor) below these are
+    // recognized by search threads
+    uint32_t subaddress_lookahead_major;
+    uint32_t subaddress_lookahead_minor;
+
+    // file where block timestamp index is saved.
+    // if empty, the index is rebuilt on each start.
+    string block_timestamps_file;
+
     string   import_payment_address_str;
     string   import_payment_viewkey_str;
 
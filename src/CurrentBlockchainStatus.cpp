@@ -3,6 +3,7 @@
 //
 
 #include "CurrentBlockchainStatus.h"
+#include "TxSearch.h"
 
 
 
@@ -13,13 +14,77 @@
 namespace xmreg
 {
 
+namespace
+{
+
+// parameters of gamma distribution of decoys' ages (in seconds,
+// log scale), as used by wallet2
+constexpr double GAMMA_SHAPE {19.28};
+constexpr double GAMMA_SCALE {1 / 1.61};
+
+// rounds of repicking decoys which turned out to be locked
+constexpr size_t MAX_DECOY_PICK_ROUNDS {10};
+
+// number of block ranges which ring members are kept
+// for other search threads
+constexpr size_t MAX_SHARED_RING_MEMBERS_RANGES {4};
+
+// number of block ranges which precomputed tx pub keys are
+// kept for other search threads. each tx takes about 1.5 kB.
+constexpr size_t MAX_PRECOMPUTED_TX_PUB_KEYS_RANGES {4};
+
+// ring members of block ranges with more of them are not read
+// at once, so that few large ranges (e.g., during initial scans
+// of big blocks) dont keep lots of memory in the shared cache
+constexpr size_t MAX_RING_MEMBERS_PER_RANGE {200000};
+
+// number of blocks below the top, at the start of the monitor
+// thread, which are scanned for import payments. so that payments
+// made while openmonero was not running are not missed.
+constexpr uint64_t IMPORT_PAYMENTS_INITIAL_SCAN_BLOCKS {720};
+
+// number of top blocks which are scanned again for import
+// payments, after the last scanned block got orphaned
+constexpr uint64_t IMPORT_PAYMENTS_REORG_DEPTH {
+        CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE};
+
+// number of reads after which long batch reads are renewed
+constexpr uint64_t BATCH_READ_RENEW_EVERY {10000};
+
+// block timestamp index is saved after this many new blocks
+constexpr uint64_t BLOCK_TIMESTAMPS_SAVE_EVERY {100};
+
+// number of top blocks of cached rct output
+// distribution which are re-counted on each update
+constexpr uint64_t RCT_DISTRIBUTION_REORG_DEPTH {
+        CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE};
+
+// buffers of get_output_keys which grew larger than this
+// are freed by its next call, rather than reused
+constexpr size_t MAX_REUSED_OUTPUT_KEYS {4096};
+
+template <typename T>
+void
+clear_for_reuse(vector<T>& buffer)
+{
+    if (buffer.capacity() > MAX_REUSED_OUTPUT_KEYS)
+        vector<T>().swap(buffer);
+    else
+        buffer.clear();
+}
+
+}
+
 CurrentBlockchainStatus::CurrentBlockchainStatus(
         BlockchainSetup _bc_setup,
         std::unique_ptr<MicroCore> _mcore,
         std::unique_ptr<RPCCalls> _rpc)
     : bc_setup {_bc_setup},
       mcore {std::move(_mcore)},
-      rpc {std::move(_rpc)}
+      rpc {std::move(_rpc)},
+      output_key_cache {std::make_unique<OutputKeyCache>(
+                            bc_setup.output_key_cache_size)},
+      known_outputs_index {std::make_unique<KnownOutputsIndex>()}
 {
 
 }
@@ -36,10 +101,31 @@ CurrentBlockchainStatus::start_monitor_blockchain_thread()
            {
                while (true)
                {
-                   update_current_blockchain_height();
+                   // mempool is read before the height, so that
+                   // txs which left it for a new block are in the
+                   // blocks scanned by update_import_payments,
+                   // and their payments are not dropped.
                    read_mempool();
+                   update_current_blockchain_height();
+                   update_blockchain_snapshot();
+                   update_rct_output_distribution();
+
+                   // importing is free, so nobody waits for payments
+                   if (bc_setup.import_fee > 0)
+                       update_import_payments();
+
                    OMINFO << "Current blockchain height: " << current_height
-                          << ", no of mempool txs: " << mempool_txs.size();
+                          << ", no of mempool txs: "
+                          << std::atomic_load(&mempool_txs)->size()
+                          << ", output key cache size: "
+                          << output_key_cache->size()
+                          << ", hit rate: "
+                          << output_key_cache->get_hit_rate()
+                          << ", known outputs: "
+                          << known_outputs_index->size()
+                          << " (" << known_outputs_index->memory_usage() / 1024
+                          << " kB)";
+                   notify_subscribers();
                    clean_search_thread_map();
                    std::this_thread::sleep_for(
                            std::chrono::seconds(
@@ -48,6 +134,27 @@ CurrentBlockchainStatus::start_monitor_blockchain_thread()
                }
            }};
 
+        // first build of block timestamp index reads all blocks,
+        // which takes a while. so its done in its own thread, not
+        // to delay mempool and other updates of the monitor thread.
+        block_timestamps_thread = std::thread{[this]()
+           {
+               while (true)
+               {
+                   update_block_timestamp_index();
+                   std::this_thread::sleep_for(
+                           std::chrono::seconds(
+                            bc_setup
+                             .refresh_block_status_every_seconds));
+               }
+           }};
+
+        reaper_thread = std::thread{[this]()
+           {
+               while (true)
+                   reap_search_threads();
+           }};
+
         is_running = true;
     }
 }
@@ -66,6 +173,136 @@ CurrentBlockchainStatus::update_current_blockchain_height()
     current_height = mcore->get_current_blockchain_height() - 1;
 }
 
+bool
+CurrentBlockchainStatus::update_blockchain_snapshot()
+{
+    uint64_t const height = current_height;
+
+    block tip;
+
+    if (!mcore->get_block_from_height(height, tip))
+    {
+        OMERROR << "Cant get top block at height " << height;
+        return false;
+    }
+
+    crypto::hash const tip_hash = get_block_hash(tip);
+
+    auto old_snapshot = get_blockchain_snapshot();
+
+    // same top block, e.g., no new blocks since last update
+    if (old_snapshot && old_snapshot->height == height
+            && old_snapshot->tip_hash == tip_hash)
+        return true;
+
+    auto snapshot = std::make_shared<BlockchainSnapshot>();
+
+    snapshot->height     = height;
+    snapshot->tip_hash   = tip_hash;
+    snapshot->per_kb_fee = mcore->get_dynamic_per_kb_fee_estimate(
+                                FEE_ESTIMATE_GRACE_BLOCKS);
+
+    std::atomic_store(&blockchain_snapshot,
+                      std::shared_ptr<BlockchainSnapshot const> {
+                          std::move(snapshot)});
+
+    return true;
+}
+
+bool
+CurrentBlockchainStatus::update_block_timestamp_index()
+{
+    string const& path = bc_setup.block_timestamps_file;
+
+    if (!block_timestamps_loaded)
+    {
+        block_timestamps_loaded = true;
+
+        if (!path.empty() && block_timestamps.load(path))
+        {
+            block_timestamps_saved_size = block_timestamps.size();
+            OMINFO << "Block timestamps loaded from " << path
+                   << " for " << block_timestamps_saved_size << " blocks";
+        }
+    }
+
+    uint64_t const height = current_height;
+
+    // top blocks are re-read in case they got reorganized. also,
+    // saved index can be longer than the blockchain, e.g.,
+    // after popping blocks.
+    uint64_t const from_height = std::min(
+                block_timestamps.size() > CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE
+                ? block_timestamps.size() - CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE
+                : 0,
+                height);
+
+    vector<uint64_t> timestamps;
+    timestamps.reserve(height - from_height + 1);
+
+    try
+    {
+        BatchRead batch_read {mcore.get()};
+
+        for (uint64_t h = from_height; h <= height; ++h)
+        {
+            // first build reads whole blockchain. dont keep
+            // one read transaction open for all of it.
+            if ((h - from_height + 1) % BATCH_READ_RENEW_EVERY == 0)
+                batch_read.renew();
+
+            timestamps.push_back(mcore->get_block_timestamp(h));
+        }
+    }
+    catch (std::exception const& e)
+    {
+        OMERROR << "Cant get block timestamps: " << e.what();
+        return false;
+    }
+
+    block_timestamps.update(from_height, timestamps);
+
+    if (!path.empty() && block_timestamps.size()
+            >= block_timestamps_saved_size + BLOCK_TIMESTAMPS_SAVE_EVERY)
+    {
+        if (!block_timestamps.save(path))
+        {
+            OMERROR << "Cant save block timestamps to " << path;
+            return false;
+        }
+
+        block_timestamps_saved_size = block_timestamps.size();
+    }
+
+    return true;
+}
+
+bool
+CurrentBlockchainStatus::get_height_for_timestamp(
+        uint64_t timestamp, uint64_t& height) const
+{
+    if (block_timestamps.size() == 0)
+        return false;
+
+    // date newer than all blocks, so only next blocks can be from it
+    if (!block_timestamps.get_height(timestamp, height))
+        height = block_timestamps.size();
+
+    return true;
+}
+
+std::shared_ptr<CurrentBlockchainStatus::BlockchainSnapshot const>
+CurrentBlockchainStatus::get_blockchain_snapshot() const
+{
+    return std::atomic_load(&blockchain_snapshot);
+}
+
+BatchRead
+CurrentBlockchainStatus::make_batch_read()
+{
+    return BatchRead {mcore.get()};
+}
+
 bool
 CurrentBlockchainStatus::init_monero_blockchain()
 {
@@ -148,6 +385,33 @@ CurrentBlockchainStatus::get_txs(
     return true;
 }
 
+bool
+CurrentBlockchainStatus::get_txs_for_scanning(
+        vector<crypto::hash> const& txs_to_get,
+        vector<transaction>& txs)
+{
+    txs.clear();
+    txs.reserve(txs_to_get.size());
+
+    BatchRead batch_read {mcore.get()};
+
+    string tx_blob;
+
+    for (crypto::hash const& tx_hash: txs_to_get)
+    {
+        txs.emplace_back();
+
+        if (!mcore->get_tx_blob(tx_hash, tx_blob)
+                || !parse_and_validate_tx_base_from_blob(tx_blob, txs.back()))
+        {
+            OMERROR << "Cant get tx for scanning: " << pod_to_hex(tx_hash);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool
 CurrentBlockchainStatus::tx_exist(const crypto::hash& tx_hash)
 {
@@ -222,17 +486,73 @@ CurrentBlockchainStatus::get_output_keys(const uint64_t& amount,
             const vector<uint64_t>& absolute_offsets,
             vector<cryptonote::output_data_t>& outputs)
 {
-    try
+    outputs.clear();
+    outputs.resize(absolute_offsets.size());
+
+    // positions in outputs of the outputs not found in the cache.
+    // thread local, so that their memory is reused by next calls
+    // of the thread, e.g., for next inputs of the tx.
+    static thread_local vector<size_t> missing_positions;
+    static thread_local vector<uint64_t> missing_offsets;
+    static thread_local vector<output_data_t> missing_outputs;
+
+    clear_for_reuse(missing_positions);
+    clear_for_reuse(missing_offsets);
+    clear_for_reuse(missing_outputs);
+
+    for (size_t i = 0; i < absolute_offsets.size(); ++i)
     {
-        mcore->get_output_key(amount, absolute_offsets, outputs);
+        if (output_key_cache->get(amount, absolute_offsets[i], outputs[i]))
+            continue;
+
+        missing_positions.push_back(i);
+        missing_offsets.push_back(absolute_offsets[i]);
+    }
+
+    if (missing_offsets.empty())
         return true;
+
+    try
+    {
+        mcore->get_output_key(amount, missing_offsets, missing_outputs);
     }
     catch (const OUTPUT_DNE& e)
     {
         OMERROR << "get_output_keys: " << e.what();
+        return false;
     }
 
-    return false;
+    if (missing_outputs.size() != missing_offsets.size())
+    {
+        OMERROR << "get_output_keys: not all outputs found for amount "
+                << amount;
+        return false;
+    }
+
+    for (size_t i = 0; i < missing_positions.size(); ++i)
+        outputs[missing_positions[i]] = missing_outputs[i];
+
+    cache_output_keys(amount, missing_offsets, missing_outputs);
+
+    return true;
+}
+
+void
+CurrentBlockchainStatus::cache_output_keys(
+        uint64_t amount,
+        vector<uint64_t> const& global_amount_indices,
+        vector<output_data_t> const& outputs)
+{
+    uint64_t const height = current_height;
+
+    for (size_t i = 0; i < outputs.size(); ++i)
+    {
+        if (outputs[i].height + CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE
+                > height)
+            continue;
+
+        output_key_cache->put(amount, global_amount_indices[i], outputs[i]);
+    }
 }
 
 
@@ -289,24 +609,453 @@ CurrentBlockchainStatus::get_random_outputs(
         vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS
             ::outs_for_amount>& found_outputs)
 {
+    vector<uint64_t> non_rct_amounts;
+
+    for (uint64_t amount: amounts)
+        if (amount != 0)
+            non_rct_amounts.push_back(amount);
+
+    size_t const no_of_rct_amounts = amounts.size() - non_rct_amounts.size();
+
+    // nothing to pick from the cached distribution.
+    // so everything goes to the monero's Blockchain
+    if (no_of_rct_amounts == 0 || !is_rct_output_distribution_ready())
+    {
+        COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request req;
+        COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response res;
+
+        req.outs_count = outs_count;
+        req.amounts = amounts;
+
+        if (!mcore->get_random_outs_for_amounts(req, res))
+        {
+            OMERROR << "mcore->get_random_outs_for_amounts(req, res) failed";
+            return false;
+        }
+
+        found_outputs = res.outs;
+
+        return true;
+    }
+
+    COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response non_rct_res;
+
+    if (!non_rct_amounts.empty())
+    {
+        COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request req;
+
+        req.outs_count = outs_count;
+        req.amounts = non_rct_amounts;
+
+        if (!mcore->get_random_outs_for_amounts(req, non_rct_res)
+                || non_rct_res.outs.size() != non_rct_amounts.size())
+        {
+            OMERROR << "mcore->get_random_outs_for_amounts(req, res) failed";
+            return false;
+        }
+    }
+
+    vector<vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry>>
+            rct_rings;
+
+    if (!get_random_rct_outputs(no_of_rct_amounts, outs_count, rct_rings))
+        return false;
+
+    found_outputs.clear();
+    found_outputs.reserve(amounts.size());
+
+    // keep the order of the requested amounts
+    auto non_rct_it = non_rct_res.outs.begin();
+    auto rct_it = rct_rings.begin();
+
+    for (uint64_t amount: amounts)
+    {
+        if (amount != 0)
+        {
+            found_outputs.push_back(std::move(*non_rct_it++));
+            continue;
+        }
+
+        COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount outs;
+
+        outs.amount = 0;
+        outs.outs = std::move(*rct_it++);
+
+        found_outputs.push_back(std::move(outs));
+    }
+
+    return true;
+}
+
+bool
+CurrentBlockchainStatus::get_random_rct_outputs(
+        size_t no_of_rings,
+        uint64_t outs_count,
+        vector<vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS
+            ::out_entry>>& rings)
+{
+    rings.assign(no_of_rings, {});
+
+    // outputs already picked or found to be locked, per ring
+    vector<unordered_set<uint64_t>> excluded(no_of_rings);
+
+    for (size_t round = 0; round < MAX_DECOY_PICK_ROUNDS; ++round)
+    {
+        vector<uint64_t> picked_indices;
+        vector<size_t> picked_rings;
+
+        {
+            std::lock_guard<std::mutex> lck (rct_distribution_mtx);
+
+            for (size_t ring_i = 0; ring_i < no_of_rings; ++ring_i)
+            {
+                size_t const missing = outs_count - rings[ring_i].size();
+
+                if (missing == 0)
+                    continue;
+
+                vector<uint64_t> picks;
+
+                if (!pick_rct_output_indices(missing, excluded[ring_i], picks))
+                {
+                    OMERROR << "Cant pick " << missing << " ringct decoys";
+                    return false;
+                }
+
+                for (uint64_t pick: picks)
+                {
+                    excluded[ring_i].insert(pick);
+                    picked_indices.push_back(pick);
+                    picked_rings.push_back(ring_i);
+                }
+            }
+        }
+
+        if (picked_indices.empty())
+            break;
+
+        // keys of decoys of all rings are read at once
+        vector<output_data_t> outputs_data;
+
+        try
+        {
+            BatchRead batch_read {mcore.get()};
+
+            mcore->get_output_key(0, picked_indices, outputs_data);
+        }
+        catch (std::exception const& e)
+        {
+            OMERROR << "get_random_rct_outputs: " << e.what();
+            return false;
+        }
+
+        if (outputs_data.size() != picked_indices.size())
+        {
+            OMERROR << "Not all picked ringct decoys found";
+            return false;
+        }
+
+        // locked outputs (e.g., young coinbase outputs) cant be
+        // used as decoys. they stay excluded and get replaced
+        // in the next round.
+        for (size_t i = 0; i < picked_indices.size(); ++i)
+        {
+            output_data_t const& od = outputs_data[i];
+
+            if (!is_tx_unlocked(od.unlock_time, od.height))
+                continue;
+
+            rings[picked_rings[i]].push_back({picked_indices[i], od.pubkey});
+        }
+    }
+
+    for (auto& ring: rings)
+    {
+        if (ring.size() < outs_count)
+        {
+            OMERROR << "Cant find enough unlocked ringct decoys";
+            return false;
+        }
+
+        std::sort(ring.begin(), ring.end(),
+                  [](auto const& l, auto const& r)
+                  {
+                      return l.global_amount_index < r.global_amount_index;
+                  });
+    }
+
+    return true;
+}
+
+bool
+CurrentBlockchainStatus::pick_rct_output_indices(
+        size_t count,
+        unordered_set<uint64_t> const& excluded,
+        vector<uint64_t>& picks) const
+{
+    // based on wallet2::get_outs
+    // https://github.com/monero-project/monero/blob/release-v0.13/src/wallet/wallet2.cpp
+
+    picks.clear();
+
+    size_t const no_of_blocks = rct_output_offsets.size();
+
+    if (no_of_blocks <= CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE)
+        return false;
+
+    // outputs younger than 10 blocks cant be spent
+    uint64_t const num_rct_outputs
+            = rct_output_offsets[no_of_blocks
+                                 - CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE];
+
+    size_t const blocks_in_a_year = 86400 * 365 / DIFFICULTY_TARGET_V2;
+
+    size_t const blocks_to_consider = std::min(no_of_blocks,
+                                               blocks_in_a_year);
+
+    uint64_t const outputs_to_consider
+            = rct_output_offsets.back()
+              - (blocks_to_consider < no_of_blocks
+                 ? rct_output_offsets[no_of_blocks - blocks_to_consider - 1]
+                 : rct_distribution_base);
+
+    if (outputs_to_consider == 0)
+        return false;
+
+    // this assumes constant target over the whole rct range
+    double const average_output_time
+            = DIFFICULTY_TARGET_V2 * blocks_to_consider
+              / static_cast<double>(outputs_to_consider);
+
+    static thread_local std::mt19937_64 engine {std::random_device{}()};
+
+    std::gamma_distribution<double> gamma(GAMMA_SHAPE, GAMMA_SCALE);
+
+    // bad picks (too old, already picked) are just repeated.
+    // this limits how many times, as in small testnets
+    // there may be not enough outputs at all.
+    size_t attempts_left = count * 100;
+
+    while (picks.size() < count && attempts_left-- > 0)
+    {
+        double const output_age = std::exp(gamma(engine))
+                                  / average_output_time;
+
+        if (output_age >= num_rct_outputs)
+            continue;
+
+        uint64_t const output_index
+                = num_rct_outputs - 1 - static_cast<uint64_t>(output_age);
+
+        auto it = std::lower_bound(rct_output_offsets.begin(),
+                                   rct_output_offsets.end(),
+                                   output_index);
+
+        if (it == rct_output_offsets.end())
+            continue;
+
+        size_t const block_i = std::distance(rct_output_offsets.begin(), it);
+
+        uint64_t const first_rct = block_i == 0
+                ? rct_distribution_base : rct_output_offsets[block_i - 1];
+
+        uint64_t const n_rct = rct_output_offsets[block_i] - first_rct;
 
-    COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request req;
-    COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response res;
+        uint64_t pick;
 
-    req.outs_count = outs_count;
-    req.amounts = amounts;
+        if (n_rct == 0)
+            pick = rct_output_offsets[block_i]
+                    ? rct_output_offsets[block_i] - 1 : 0;
+        else
+            pick = first_rct + crypto::rand<uint64_t>() % n_rct;
+
+        if (excluded.count(pick)
+                || std::find(picks.begin(), picks.end(), pick) != picks.end())
+            continue;
+
+        picks.push_back(pick);
+    }
+
+    return picks.size() == count;
+}
+
+bool
+CurrentBlockchainStatus::update_rct_output_distribution()
+{
+    uint64_t from_height {0};
+
+    // number of ringct outputs before from_height
+    uint64_t no_of_outputs {0};
 
-    if (!mcore->get_random_outs_for_amounts(req, res))
     {
-        OMERROR << "mcore->get_random_outs_for_amounts(req, res) failed";
+        std::lock_guard<std::mutex> lck (rct_distribution_mtx);
+
+        // no new blocks since last update
+        if (!rct_output_offsets.empty()
+                && rct_distribution_start_height
+                   + rct_output_offsets.size() == current_height + 1)
+        {
+            return true;
+        }
+
+        if (rct_output_offsets.size() > RCT_DISTRIBUTION_REORG_DEPTH)
+        {
+            from_height = rct_distribution_start_height
+                          + rct_output_offsets.size()
+                          - RCT_DISTRIBUTION_REORG_DEPTH;
+
+            no_of_outputs = rct_output_offsets[from_height
+                                               - rct_distribution_start_height
+                                               - 1];
+        }
+    }
+
+    // reading the distribution from monero goes over all ringct
+    // outputs in lmdb, so it is done only once. afterwards, outputs
+    // are counted only in the new blocks.
+    if (from_height == 0)
+        return read_rct_output_distribution();
+
+    vector<uint64_t> new_offsets;
+
+    if (!count_rct_outputs(from_height, current_height,
+                           no_of_outputs, new_offsets))
+    {
+        // e.g., blockchain got shorter than what we have cached.
+        // get_random_outputs falls back to monero's Blockchain
+        // until the distribution is read again from scratch.
+        std::lock_guard<std::mutex> lck (rct_distribution_mtx);
+        rct_output_offsets.clear();
         return false;
     }
 
-    found_outputs = res.outs;
+    std::lock_guard<std::mutex> lck (rct_distribution_mtx);
+
+    rct_output_offsets.resize(from_height - rct_distribution_start_height);
+
+    rct_output_offsets.insert(rct_output_offsets.end(),
+                              new_offsets.begin(), new_offsets.end());
+
+    return true;
+}
+
+bool
+CurrentBlockchainStatus::read_rct_output_distribution()
+{
+    uint64_t start_height {0};
+    uint64_t base {0};
+    vector<uint64_t> distribution;
+
+    try
+    {
+        if (!mcore->get_output_distribution(0, 0, start_height,
+                                            distribution, base))
+        {
+            OMERROR << "Cant get rct output distribution";
+        }
+    }
+    catch (std::exception const& e)
+    {
+        OMERROR << "read_rct_output_distribution: " << e.what();
+        distribution.clear();
+    }
+
+    std::lock_guard<std::mutex> lck (rct_distribution_mtx);
+
+    rct_output_offsets.clear();
+
+    if (distribution.empty())
+        return false;
+
+    rct_distribution_start_height = start_height;
+    rct_distribution_base = base;
+
+    // distribution has number of outputs in each block,
+    // but we need cumulative numbers
+    uint64_t no_of_outputs = base;
+
+    rct_output_offsets.reserve(distribution.size());
+
+    for (uint64_t block_outputs: distribution)
+    {
+        no_of_outputs += block_outputs;
+        rct_output_offsets.push_back(no_of_outputs);
+    }
+
+    return true;
+}
+
+bool
+CurrentBlockchainStatus::count_rct_outputs(
+        uint64_t h1, uint64_t h2,
+        uint64_t no_of_outputs,
+        vector<uint64_t>& offsets)
+{
+    offsets.clear();
+
+    if (h2 < h1)
+        return false;
+
+    vector<block> blocks = get_blocks_range(h1, h2);
+
+    if (blocks.size() != h2 - h1 + 1)
+    {
+        OMERROR << "Cant get blocks from " << h1 << " to " << h2
+                << " for rct output distribution";
+        return false;
+    }
+
+    offsets.reserve(blocks.size());
+
+    try
+    {
+        BatchRead batch_read {mcore.get()};
+
+        string tx_blob;
+        transaction tx;
+
+        for (block const& blk: blocks)
+        {
+            // lmdb keeps outputs of ringct coinbase txs as ringct
+            // outputs as well, with identity masks.
+            if (blk.miner_tx.version > 1)
+                no_of_outputs += blk.miner_tx.vout.size();
+
+            // all outputs of ringct txs are ringct outputs, so
+            // only tx prefixes are needed, not amount indices.
+            for (crypto::hash const& tx_hash: blk.tx_hashes)
+            {
+                if (!mcore->get_tx_blob(tx_hash, tx_blob)
+                        || !parse_and_validate_tx_base_from_blob(tx_blob, tx))
+                {
+                    OMERROR << "Cant get tx for rct output distribution: "
+                            << pod_to_hex(tx_hash);
+                    return false;
+                }
+
+                if (tx.version > 1)
+                    no_of_outputs += tx.vout.size();
+            }
+
+            offsets.push_back(no_of_outputs);
+        }
+    }
+    catch (std::exception const& e)
+    {
+        OMERROR << "count_rct_outputs: " << e.what();
+        return false;
+    }
 
     return true;
 }
 
+bool
+CurrentBlockchainStatus::is_rct_output_distribution_ready() const
+{
+    std::lock_guard<std::mutex> lck (rct_distribution_mtx);
+    return rct_output_offsets.size() > CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE;
+}
+
 bool
 CurrentBlockchainStatus::get_output(
         const uint64_t amount,
@@ -332,6 +1081,10 @@ CurrentBlockchainStatus::get_output(
 uint64_t
 CurrentBlockchainStatus::get_dynamic_per_kb_fee_estimate() const
 {
+    // fee estimate changes only with new blocks
+    if (auto snapshot = get_blockchain_snapshot())
+        return snapshot->per_kb_fee;
+
     return mcore->get_dynamic_per_kb_fee_estimate(
                 FEE_ESTIMATE_GRACE_BLOCKS);
 }
@@ -371,10 +1124,16 @@ CurrentBlockchainStatus::read_mempool()
 
     std::lock_guard<std::mutex> lck (getting_mempool_txs);
 
-    // clear current mempool txs vector
-    // repopulate it with each execution of read_mempool()
+    // repopulate mempool txs with each execution of read_mempool().
     // not very efficient but good enough for now.
-    mempool_txs.clear();
+    // readers can still use the previous ones.
+    auto current_mempool_txs = std::make_shared<mempool_txs_t>();
+
+    current_mempool_txs->reserve(mempool_tx_info.size());
+
+    new_mempool_txs.clear();
+
+    unordered_set<crypto::hash> current_mempool_tx_hashes;
 
     // if dont have tx_blob member, construct tx
     // from json obtained from the rpc call
@@ -395,259 +1154,457 @@ CurrentBlockchainStatus::read_mempool()
             return false;
         }
 
-        (void) tx_hash;
         (void) tx_prefix_hash;
 
-        mempool_txs.emplace_back(_tx_info.receive_time, tx);
+        if (mempool_tx_hashes.count(tx_hash) == 0)
+            new_mempool_txs.emplace_back(_tx_info.receive_time, tx);
+
+        current_mempool_tx_hashes.insert(tx_hash);
+
+        current_mempool_txs->emplace_back(_tx_info.receive_time, tx);
 
     } // for (size_t i = 0; i < mempool_tx_info.size(); ++i)
 
+    // no new txs and none left, so the current snapshot is kept.
+    // search threads compare snapshots, and search only changed ones.
+    bool const mempool_changed
+            = !new_mempool_txs.empty()
+              || current_mempool_tx_hashes.size() != mempool_tx_hashes.size();
+
+    mempool_tx_hashes = std::move(current_mempool_tx_hashes);
+
+    if (!mempool_changed)
+        return true;
+
+    std::atomic_store(&mempool_txs,
+                      std::shared_ptr<mempool_txs_t const>(
+                              std::move(current_mempool_txs)));
+
     return true;
 }
 
+void
+CurrentBlockchainStatus::set_account_events(
+        std::shared_ptr<AccountEvents> _account_events)
+{
+    account_events = _account_events;
+}
+
+std::shared_ptr<AccountEvents>
+CurrentBlockchainStatus::get_account_events()
+{
+    return account_events;
+}
+
+void
+CurrentBlockchainStatus::notify_subscribers()
+{
+    if (!account_events)
+        return;
+
+    mempool_txs_t fresh_mempool_txs;
+
+    {
+        std::lock_guard<std::mutex> lck (getting_mempool_txs);
+        fresh_mempool_txs.swap(new_mempool_txs);
+    }
+
+    for (string const& address: account_events->get_subscribed_addresses())
+    {
+        address_parse_info address_info;
+
+        if (!parse_str_address(address, address_info, bc_setup.net_type))
+            continue;
+
+        auto search_thread = get_search_thread(address_info.address);
+
+        if (!search_thread)
+        {
+            // thread stopped, e.g., due to an error. its sockets
+            // would not get any events, so they are closed, and
+            // their wallets can subscribe again, which starts
+            // a new thread.
+            account_events->close_subscriptions(
+                        address, json {{"event" , "unsubscribed"},
+                                       {"reason", "search thread stopped"}});
+            continue;
+        }
+
+        TxSearch& tx_search = search_thread->get_functor();
+
+        // subscribed accounts dont poll our api, which
+        // normally keeps their search threads alive.
+        tx_search.ping();
+
+        if (fresh_mempool_txs.empty())
+            continue;
+
+        json j_txs = tx_search.find_txs_in_mempool(fresh_mempool_txs);
+
+        for (json& j_tx: j_txs)
+        {
+            account_events->publish(address, json {{"event", "mempool_tx"},
+                                                   {"tx"   , j_tx}});
+        }
+    }
+}
+
 CurrentBlockchainStatus::mempool_txs_t
 CurrentBlockchainStatus::get_mempool_txs()
 {
-    std::lock_guard<std::mutex> lck (getting_mempool_txs);
-    return mempool_txs;
+    return *get_mempool_txs_snapshot();
+}
+
+std::shared_ptr<CurrentBlockchainStatus::mempool_txs_t const>
+CurrentBlockchainStatus::get_mempool_txs_snapshot()
+{
+    return std::atomic_load(&mempool_txs);
 }
 
 bool
-CurrentBlockchainStatus::search_if_payment_made(
-        const string& payment_id_str,
-        const uint64_t& desired_amount,
-        string& tx_hash_with_payment)
+CurrentBlockchainStatus::update_import_payments()
 {
+    // mempool txs first, as new payments are most likely there
+    unordered_set<crypto::hash> current_mempool_tx_hashes;
 
-    mempool_txs_t mempool_transactions = get_mempool_txs();
+    std::shared_ptr<mempool_txs_t const> current_mempool_txs
+            = get_mempool_txs_snapshot();
 
-    uint64_t current_blockchain_height = current_height;
+    for (auto const& mtx: *current_mempool_txs)
+    {
+        transaction const& tx = mtx.second;
+        crypto::hash const tx_hash = get_transaction_hash(tx);
 
-    vector<transaction> txs_to_check;
+        current_mempool_tx_hashes.insert(tx_hash);
 
-    for (auto& mtx: mempool_transactions)
-    {
-        txs_to_check.push_back(mtx.second);
+        if (import_payments_mempool_tx_hashes.count(tx_hash) > 0)
+            continue;
+
+        string payment_id_str;
+        uint64_t total_received {0};
+
+        if (identify_import_payment(tx, payment_id_str, total_received))
+            add_import_payment(payment_id_str, tx_hash, total_received,
+                               true, 0);
     }
 
-    // apend txs in last to blocks into the txs_to_check vector
-    for (uint64_t blk_i = current_blockchain_height - 10;
-         blk_i <= current_blockchain_height;
-         ++blk_i)
+    import_payments_mempool_tx_hashes
+            = std::move(current_mempool_tx_hashes);
+
+    uint64_t const height = current_height;
+
+    if (!import_payments_started)
     {
-        // get block cointaining this tx
-        block blk;
+        import_payments_next_height
+                = height > IMPORT_PAYMENTS_INITIAL_SCAN_BLOCKS
+                  ? height - IMPORT_PAYMENTS_INITIAL_SCAN_BLOCKS : 0;
 
-        if (!get_block(blk_i, blk)) {
-            OMERROR << "Cant get block of height: " << blk_i;
-            return false;
+        import_payments_started = true;
+    }
+    else if (import_payments_next_height > 0)
+    {
+        // if the last scanned block got orphaned, payments found in
+        // the top blocks are dropped, and the blocks are scanned
+        // again. payments which are still in the blockchain, or are
+        // back in the mempool, are found again.
+        block last_blk;
+
+        if (!mcore->get_block_from_height(import_payments_next_height - 1,
+                                          last_blk)
+                || get_block_hash(last_blk) != import_payments_last_hash)
+        {
+            uint64_t const from_height = std::min(
+                        import_payments_next_height, height + 1);
+
+            import_payments_next_height
+                    = from_height > IMPORT_PAYMENTS_REORG_DEPTH
+                      ? from_height - IMPORT_PAYMENTS_REORG_DEPTH : 0;
+
+            OMINFO << "Rescanning blocks from "
+                   << import_payments_next_height
+                   << " for import payments after reorg";
+
+            remove_import_payments(
+                    [this](import_payment_t const& payment)
+                    {
+                        return !payment.in_mempool
+                                && payment.height
+                                   >= import_payments_next_height;
+                    });
         }
+    }
 
-        vector<cryptonote::transaction> blk_txs;
-        vector<crypto::hash> missed_txs;
+    while (import_payments_next_height <= height)
+    {
+        uint64_t const h1 = import_payments_next_height;
+        uint64_t const h2 = std::min(
+                    h1 + bc_setup.blocks_search_lookahead - 1, height);
 
-        if (!get_block_txs(blk, blk_txs, missed_txs))
+        vector<block> blocks = get_blocks_range(h1, h2);
+
+        vector<txs_tuple_t> txs_data;
+
+        if (blocks.empty() || !get_txs_in_blocks(blocks, txs_data))
         {
-            OMERROR << "Cant get transactions from block: " << blk_i;
+            OMERROR << "Cant scan blocks from " << h1 << " to " << h2
+                    << " for import payments";
             return false;
         }
 
-        // combine mempool txs and txs from given number of
-        // last blocks
-        txs_to_check.insert(txs_to_check.end(),
-                            blk_txs.begin(), blk_txs.end());
-    }
-
-    for (transaction& tx: txs_to_check)
-    {
-        if (is_coinbase(tx))
+        for (auto const& tx_tuple: txs_data)
         {
             // not interested in coinbase txs
-            continue;
+            if (std::get<4>(tx_tuple))
+                continue;
+
+            string payment_id_str;
+            uint64_t total_received {0};
+
+            if (identify_import_payment(std::get<1>(tx_tuple),
+                                        payment_id_str, total_received))
+            {
+                add_import_payment(payment_id_str, std::get<0>(tx_tuple),
+                                   total_received, false,
+                                   std::get<2>(tx_tuple));
+            }
         }
 
-        string tx_payment_id_str = get_payment_id_as_string(tx);
+        import_payments_next_height = h2 + 1;
+        import_payments_last_hash   = get_block_hash(blocks.back());
+    }
+
+    // txs which left the mempool without being mined, e.g.,
+    // double spends or txs dropped after a timeout. mined ones
+    // have been already moved to their blocks above.
+    remove_import_payments(
+            [this](import_payment_t const& payment)
+            {
+                return payment.in_mempool
+                        && import_payments_mempool_tx_hashes.count(
+                                payment.tx_hash) == 0;
+            });
+
+    return true;
+}
+
+bool
+CurrentBlockchainStatus::search_if_payment_made(
+        const string& payment_id_str,
+        const uint64_t& desired_amount,
+        string& tx_hash_with_payment)
+{
+    std::lock_guard<std::mutex> lck (import_payments_mtx);
+
+    auto it = import_payments.find(payment_id_str);
 
-        // we are interested only in txs with encrypted payments id8
-        // they have length of 16 characters.
+    if (it == import_payments.end())
+        return false;
 
-        if (tx_payment_id_str.length() != 16)
+    for (import_payment_t const& payment: it->second)
+    {
+        if (payment.amount >= desired_amount)
         {
-            continue;
+            // the payment has been made.
+            tx_hash_with_payment = pod_to_hex(payment.tx_hash);
+            OMINFO << "Import payment done";
+            return true;
         }
+    }
+
+    return false;
+}
+
+void
+CurrentBlockchainStatus::add_import_payment(
+        string const& payment_id_str,
+        crypto::hash const& tx_hash,
+        uint64_t amount,
+        bool in_mempool,
+        uint64_t height)
+{
+    OMINFO << " Payment id check in tx: "
+           << pod_to_hex(tx_hash)
+           << " found: " << amount;
 
-        // we have some tx with encrypted payment_id8
-        // need to decode it using tx public key, and our
-        // private view key, before we can comapre it is
-        // what we are after.
+    std::lock_guard<std::mutex> lck (import_payments_mtx);
 
-        crypto::hash8 encrypted_payment_id8;
+    vector<import_payment_t>& payments = import_payments[payment_id_str];
 
-        if (!hex_to_pod(tx_payment_id_str, encrypted_payment_id8))
+    // txs found in the mempool are found again when mined
+    for (import_payment_t& payment: payments)
+    {
+        if (payment.tx_hash == tx_hash)
         {
-            OMERROR << "Failed parsing hex to pod for encrypted_payment_id8";
-            continue;
-        }
+            if (!in_mempool)
+            {
+                payment.in_mempool = false;
+                payment.height     = height;
+            }
 
-        // decrypt the encrypted_payment_id8
+            return;
+        }
+    }
 
-        public_key tx_pub_key
-                = xmreg::get_tx_pub_key_from_received_outs(tx);
+    payments.push_back({tx_hash, amount, in_mempool, height});
+}
 
+void
+CurrentBlockchainStatus::remove_import_payments(
+        std::function<bool(import_payment_t const&)> const& to_remove)
+{
+    std::lock_guard<std::mutex> lck (import_payments_mtx);
 
-        // public transaction key is combined with our viewkey
-        // to create, so called, derived key.
-        key_derivation derivation;
+    for (auto it = import_payments.begin(); it != import_payments.end();)
+    {
+        vector<import_payment_t>& payments = it->second;
 
-        if (!generate_key_derivation(tx_pub_key,
-                                     bc_setup.import_payment_viewkey,
-                                     derivation))
-        {
-            OMERROR << "Cant get derived key for: "  << "\n"
-                    << "pub_tx_key: " << tx_pub_key << " and "
-                    << "prv_view_key" << bc_setup.import_payment_viewkey;
+        payments.erase(std::remove_if(payments.begin(), payments.end(),
+                                      to_remove),
+                       payments.end());
 
-            return false;
-        }
+        if (payments.empty())
+            it = import_payments.erase(it);
+        else
+            ++it;
+    }
+}
 
-        // decrypt encrypted payment id, as used in integreated addresses
-        crypto::hash8 decrypted_payment_id8 = encrypted_payment_id8;
+bool
+CurrentBlockchainStatus::identify_import_payment(
+        transaction const& tx,
+        string& payment_id_str,
+        uint64_t& total_received)
+{
+    if (is_coinbase(tx))
+    {
+        // not interested in coinbase txs
+        return false;
+    }
 
-        if (decrypted_payment_id8 != null_hash8)
-        {
-            if (!mcore->decrypt_payment_id(
-                    decrypted_payment_id8, tx_pub_key,
-                        bc_setup.import_payment_viewkey))
-            {
-                OMERROR << "Cant decrypt decrypted_payment_id8: "
-                        << pod_to_hex(decrypted_payment_id8);
-                continue;
-            }
-        }
+    tx_extra_info const extra_info = xmreg::parse_tx_extra_info(tx.extra);
 
-        string decrypted_tx_payment_id_str
-                = pod_to_hex(decrypted_payment_id8);
+    // we are interested only in txs with encrypted payments id8
+    if (extra_info.payment_id8 == null_hash8)
+    {
+        return false;
+    }
 
-        // check if decrypted payment id matches what we have stored
-        // in mysql.
-        if (payment_id_str != decrypted_tx_payment_id_str)
-        {
-            // check tx having specific payment id only
-            continue;
-        }
+    // we have some tx with encrypted payment_id8
+    // need to decode it using tx public key, and our
+    // private view key, before we can comapre it is
+    // what we are after.
 
-        // if everything ok with payment id, we proceed with
-        // checking if the amount transfered is correct.
+    crypto::hash8 encrypted_payment_id8 = extra_info.payment_id8;
 
-        // for each output, in a tx, check if it belongs
-        // to the given account of specific address and viewkey
+    // decrypt the encrypted_payment_id8
 
+    public_key tx_pub_key = extra_info.tx_pub_key;
 
-        //          <public_key  , amount  , out idx>
-        vector<tuple<txout_to_key, uint64_t, uint64_t>> outputs;
 
-        outputs = get_ouputs_tuple(tx);
+    // public transaction key is combined with our viewkey
+    // to create, so called, derived key.
+    key_derivation derivation;
 
-        string tx_hash_str = pod_to_hex(get_transaction_hash(tx));
+    if (!generate_key_derivation(tx_pub_key,
+                                 bc_setup.import_payment_viewkey,
+                                 derivation))
+    {
+        OMERROR << "Cant get derived key for: "  << "\n"
+                << "pub_tx_key: " << tx_pub_key << " and "
+                << "prv_view_key" << bc_setup.import_payment_viewkey;
 
+        return false;
+    }
 
-        uint64_t total_received {0};
+    // decrypt encrypted payment id, as used in integreated addresses
+    crypto::hash8 decrypted_payment_id8 = encrypted_payment_id8;
 
-        for (auto& out: outputs)
+    if (decrypted_payment_id8 != null_hash8)
+    {
+        if (!mcore->decrypt_payment_id(
+                decrypted_payment_id8, tx_pub_key,
+                    bc_setup.import_payment_viewkey))
         {
-            txout_to_key txout_k = std::get<0>(out);
-            uint64_t amount = std::get<1>(out);
-            uint64_t output_idx_in_tx = std::get<2>(out);
-
-            // get the tx output public key
-            // that normally would be generated for us,
-            // if someone had sent us some xmr.
-            public_key generated_tx_pubkey;
+            OMERROR << "Cant decrypt decrypted_payment_id8: "
+                    << pod_to_hex(decrypted_payment_id8);
+            return false;
+        }
+    }
 
-            derive_public_key(derivation,
-                              output_idx_in_tx,
-                              bc_setup.import_payment_address
-                                .address.m_spend_public_key,
-                              generated_tx_pubkey);
+    // for each output, in a tx, check if it belongs
+    // to the import wallet
 
-            // check if generated public key matches the current
-            // output's key
-            bool mine_output = (txout_k.key == generated_tx_pubkey);
 
-            // if mine output has RingCT, i.e., tx version is 2
-            // need to decode its amount. otherwise its zero.
-            if (mine_output && tx.version == 2)
-            {
-                // initialize with regular amount
-                uint64_t rct_amount = amount;
+    total_received = 0;
 
-                // cointbase txs have amounts in plain sight.
-                // so use amount from ringct, only for non-coinbase txs
-                if (!is_coinbase(tx))
-                {
-                    bool r;
+    bool found_mine_output {false};
 
-                    r = decode_ringct(tx.rct_signatures,
-                                      tx_pub_key,
-                                      bc_setup.import_payment_viewkey,
-                                      output_idx_in_tx,
-                                      tx.rct_signatures
-                                        .ecdhInfo[output_idx_in_tx].mask,
-                                      rct_amount);
+    for (output_to_key_ref const& out: outputs_to_key(tx))
+    {
+        txout_to_key const& txout_k = out.txout_k;
+        uint64_t amount = out.amount;
+        uint64_t output_idx_in_tx = out.idx_in_tx;
+
+        // get the tx output public key
+        // that normally would be generated for us,
+        // if someone had sent us some xmr.
+        public_key generated_tx_pubkey;
+
+        derive_public_key(derivation,
+                          output_idx_in_tx,
+                          bc_setup.import_payment_address
+                            .address.m_spend_public_key,
+                          generated_tx_pubkey);
+
+        // check if generated public key matches the current
+        // output's key
+        bool mine_output = (txout_k.key == generated_tx_pubkey);
+
+        // if mine output has RingCT, i.e., tx version is 2
+        // need to decode its amount. otherwise its zero.
+        if (mine_output && tx.version == 2)
+        {
+            // initialize with regular amount
+            uint64_t rct_amount = amount;
 
-                    if (!r)
-                    {
-                        OMERROR << "Cant decode ringCT!";
-                        return false;
-                    }
+            bool r;
 
-                    amount = rct_amount;
-                }
+            r = decode_ringct(tx.rct_signatures,
+                              tx_pub_key,
+                              bc_setup.import_payment_viewkey,
+                              output_idx_in_tx,
+                              tx.rct_signatures
+                                .ecdhInfo[output_idx_in_tx].mask,
+                              rct_amount);
 
-            } // if (mine_output && tx.version == 2)
+            if (!r)
+            {
+                OMERROR << "Cant decode ringCT!";
+                return false;
+            }
 
+            amount = rct_amount;
 
-            if (mine_output)
-                total_received += amount;            
-        }
+        } // if (mine_output && tx.version == 2)
 
-        OMINFO << " Payment id check in tx: "
-               << tx_hash_str
-               << " found: " << total_received;
 
-        if (total_received >= desired_amount)
+        if (mine_output)
         {
-            // the payment has been made.
-            tx_hash_with_payment = tx_hash_str;
-            OMINFO << "Import payment done";
-            return true;
+            total_received += amount;
+            found_mine_output = true;
         }
     }
 
-    return false;
+    payment_id_str = pod_to_hex(decrypted_payment_id8);
+
+    return found_mine_output;
 }
 
 
 string
 CurrentBlockchainStatus::get_payment_id_as_string(const transaction& tx)
 {
-    crypto::hash payment_id = null_hash;
-    crypto::hash8 payment_id8 = null_hash8;
-
-    get_payment_id(tx, payment_id, payment_id8);
-
-    string payment_id_str{""};
-
-    if (payment_id != null_hash)
-    {
-        payment_id_str = pod_to_hex(payment_id);
-    }
-    else if (payment_id8 != null_hash8)
-    {
-        payment_id_str = pod_to_hex(payment_id8);
-    }
-
-    return payment_id_str;
+    return xmreg::parse_tx_extra_info(tx.extra).get_payment_id_str();
 }
 
 
@@ -656,28 +1613,53 @@ CurrentBlockchainStatus::get_output_key(
         uint64_t amount,
         uint64_t global_amount_index)
 {
-    return mcore->get_output_key(amount, global_amount_index);
+    output_data_t output_data;
+
+    if (output_key_cache->get(amount, global_amount_index, output_data))
+        return output_data;
+
+    output_data = mcore->get_output_key(amount, global_amount_index);
+
+    cache_output_keys(amount, {global_amount_index}, {output_data});
+
+    return output_data;
 }
 
 bool
 CurrentBlockchainStatus::start_tx_search_thread(
         XmrAccount acc, std::unique_ptr<TxSearch> tx_search)
 {
-    std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
+    address_parse_info address_info;
 
-    if (search_thread_exist(acc.address))
+    if (!parse_str_address(acc.address, address_info, bc_setup.net_type))
     {
-        // thread for this address exist, dont make new one
-        //cout << "Thread exists, dont make new one\n";
-        return true; // this is still OK, so return true.
+        OMERROR << "Cant parse string address: " << acc.address;
+        return false;
     }
 
     try
     {
-        // launch SearchTx thread for the given xmr account
+        // launch SearchTx thread for the given xmr account,
+        // unless the address already has one
+
+        auto const result = searching_threads.insert(
+                    address_info.address, std::move(tx_search));
+
+        if (result == SearchThreadRegistry::insert_result::exists)
+        {
+            // thread for this address exist, dont make new one
+            //cout << "Thread exists, dont make new one\n";
+            return true; // this is still OK, so return true.
+        }
 
-        searching_threads.insert(
-            {acc.address, ThreadRAII2<TxSearch>(std::move(tx_search))});
+        if (result == SearchThreadRegistry::insert_result::stopping)
+        {
+            // previous thread may still be scanning. new one
+            // can be started once the reaper joins it.
+            OMWARN << "Previous search thread still stopping for: "
+                   << acc.address;
+            return false;
+        }
 
         OMINFO << "Search thread created for address: " << acc.address;
     }
@@ -693,106 +1675,119 @@ CurrentBlockchainStatus::start_tx_search_thread(
 
 
 bool
-CurrentBlockchainStatus::ping_search_thread(const string& address)
+CurrentBlockchainStatus::ping_search_thread(
+        account_public_address const& address)
 {
-    std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
+    auto search_thread = get_search_thread(address);
 
-    if (!search_thread_exist(address))
+    if (!search_thread)
     {
         // thread does not exist
-        OMERROR << "thread for " << address << " does not exist";
+        OMERROR << "thread for "
+                << get_account_address_as_str(bc_setup.net_type,
+                                              false, address)
+                << " does not exist";
         return false;
     }
 
-    get_search_thread(address).ping();
+    search_thread->get_functor().ping();
 
     return true;
 }
 
 bool
-CurrentBlockchainStatus::get_searched_blk_no(const string& address,
-                                             uint64_t& searched_blk_no)
+CurrentBlockchainStatus::get_searched_blk_no(
+        account_public_address const& address,
+        uint64_t& searched_blk_no)
 {
-    std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
+    auto search_thread = get_search_thread(address);
 
-    if (!search_thread_exist(address))
+    if (!search_thread)
     {
         // thread does not exist
-        OMERROR << "thread for " << address << " does not exist";
+        OMERROR << "thread for "
+                << get_account_address_as_str(bc_setup.net_type,
+                                              false, address)
+                << " does not exist";
         return false;
     }
 
-    searched_blk_no = get_search_thread(address).get_searched_blk_no();
+    searched_blk_no = search_thread->get_functor().get_searched_blk_no();
 
     return true;
 }
 
 bool
-CurrentBlockchainStatus::get_known_outputs_keys(
-        string const& address,
-        unordered_map<public_key, uint64_t>& known_outputs_keys)
+CurrentBlockchainStatus::search_thread_exist(
+        account_public_address const& address)
 {
-    std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
-
-    if (!search_thread_exist(address))
-    {
-        // thread does not exist
-        OMERROR << "thread for " << address << " does not exist";
-        return false;
-    }
-
-
-    known_outputs_keys = get_search_thread(address).get_known_outputs_keys();
-
-    return true;
-}
-
-bool
-CurrentBlockchainStatus::search_thread_exist(const string& address)
-{
-    // no mutex here, as this will be executed
-    // from other methods, which do use mutex.
-    // so if you put mutex here, you will get into deadlock.
-    return searching_threads.count(address) > 0;
+    return get_search_thread(address) != nullptr;
 }
 
 bool
 CurrentBlockchainStatus::get_xmr_address_viewkey(
-        const string& address_str,
+        account_public_address const& acc_address,
         address_parse_info& address,
         secret_key& viewkey)
 {
-    std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
+    auto search_thread = get_search_thread(acc_address);
 
-    if (!search_thread_exist(address_str))
+    if (!search_thread)
     {
         // thread does not exist
-        OMERROR << "thread for " << address_str << " does not exist";
+        OMERROR << "thread for "
+                << get_account_address_as_str(bc_setup.net_type,
+                                              false, acc_address)
+                << " does not exist";
         return false;
     }
 
-    address = get_search_thread(address_str).get_xmr_address_viewkey().first;
-    viewkey = get_search_thread(address_str).get_xmr_address_viewkey().second;
+    TxSearch::addr_view_t const address_viewkey
+            = search_thread->get_functor().get_xmr_address_viewkey();
+
+    address = address_viewkey.first;
+    viewkey = address_viewkey.second;
 
     return true;
 }
 
 bool
 CurrentBlockchainStatus::find_txs_in_mempool(
-        const string& address_str,
+        account_public_address const& address,
         json& transactions)
 {
-    std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
+    auto search_thread = get_search_thread(address);
 
-    if (searching_threads.count(address_str) == 0)
+    if (!search_thread)
     {
         // thread does not exist
-        OMERROR << "thread for " << address_str << " does not exist";
+        OMERROR << "thread for "
+                << get_account_address_as_str(bc_setup.net_type,
+                                              false, address)
+                << " does not exist";
         return false;
     }
 
-    transactions = get_search_thread(address_str)
-            .find_txs_in_mempool(mempool_txs);
+    TxSearch& tx_search = search_thread->get_functor();
+
+    // the mempool is searched by the search thread itself,
+    // so here we only take what it found last time
+    std::shared_ptr<json const> txs_found_in_mempool
+            = tx_search.get_txs_found_in_mempool();
+
+    if (txs_found_in_mempool)
+    {
+        transactions = *txs_found_in_mempool;
+        return true;
+    }
+
+    // the thread has not searched the mempool yet, e.g., right
+    // after login. so search it here, without publishing the
+    // result, which the thread does itself. outputs of the
+    // account are read into the known outputs index by this
+    // call, if the thread has not done it yet.
+    transactions = tx_search.find_txs_in_mempool(
+                *get_mempool_txs_snapshot());
 
     return true;
 }
@@ -802,10 +1797,10 @@ CurrentBlockchainStatus::find_tx_in_mempool(
         crypto::hash const& tx_hash,
         transaction& tx)
 {
+    std::shared_ptr<mempool_txs_t const> current_mempool_txs
+            = get_mempool_txs_snapshot();
 
-    std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
-
-    for (auto const& mtx: mempool_txs)
+    for (auto const& mtx: *current_mempool_txs)
     {
         const transaction &m_tx = mtx.second;
 
@@ -823,14 +1818,10 @@ bool
 CurrentBlockchainStatus::find_key_images_in_mempool(
         std::vector<txin_v> const& vin)
 {
-    mempool_txs_t mempool_tx_cpy;
-
-    {
-        // make local copy of the mempool, so that we dont lock it for
-        // long, as this function can take longer to execute
-        std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
-        mempool_tx_cpy = mempool_txs;
-    }
+    // the snapshot is not modified, so no need to copy
+    // or lock it, even though this can take longer to execute
+    std::shared_ptr<mempool_txs_t const> mempool_tx_cpy
+            = get_mempool_txs_snapshot();
 
     // perform exhostive search to check if any key image in vin vector
     // is in the mempool. This is used to check if a tx generated
@@ -845,14 +1836,11 @@ CurrentBlockchainStatus::find_key_images_in_mempool(
         const txin_to_key& tx_in_to_key
                 = boost::get<cryptonote::txin_to_key>(kin);
 
-        for (auto const& mtx: mempool_tx_cpy)
+        for (auto const& mtx: *mempool_tx_cpy)
         {
             const transaction &m_tx = mtx.second;
 
-            vector<txin_to_key> input_key_imgs
-                    = xmreg::get_key_images(m_tx);
-
-            for (auto const& mki: input_key_imgs)
+            for (txin_to_key const& mki: inputs_to_key(m_tx))
             {
                 // if a matching key image found in the mempool
                 if (mki.k_image == tx_in_to_key.k_image)
@@ -912,54 +1900,88 @@ CurrentBlockchainStatus::get_tx_block_height(
 
 bool
 CurrentBlockchainStatus::set_new_searched_blk_no(
-        const string& address, uint64_t new_value)
+        account_public_address const& address, uint64_t new_value)
 {
-    std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
+    auto search_thread = get_search_thread(address);
 
-    if (searching_threads.count(address) == 0)
+    if (!search_thread)
     {
         // thread does not exist
         OMERROR << " thread does not exist";
         return false;
     }
 
-    get_search_thread(address).set_searched_blk_no(new_value);
+    search_thread->get_functor().set_searched_blk_no(new_value);
 
     return true;
 }
 
-TxSearch&
-CurrentBlockchainStatus::get_search_thread(string const& acc_address)
+std::shared_ptr<SearchThreadRegistry::search_thread_t>
+CurrentBlockchainStatus::get_search_thread(
+        account_public_address const& address)
+{
+    // no locking here. the thread returned is kept alive
+    // by the pointer, even if it is removed meanwhile.
+    return searching_threads.find(address);
+}
+
+void
+CurrentBlockchainStatus::clean_search_thread_map()
 {
-    // do not need locking mutex here, as this function should be only
-    // executed from others that do lock the mutex already.
-    auto it = searching_threads.find(acc_address);
+    auto stopped_threads = searching_threads.remove_stopped();
+
+    for (auto const& st: stopped_threads)
+    {
+        OMERROR << get_account_address_as_str(bc_setup.net_type,
+                                              false, st.first)
+                << " still searching: "
+                << st.second->get_functor().still_searching();
+    }
+
+    if (stopped_threads.empty())
+        return;
 
-    if (it == searching_threads.end())
     {
-        OMERROR << "Search thread does not exisit for addr: " << acc_address;
-        throw std::runtime_error("Trying to accesses "
-                                 "non-existing search thread");
+        std::lock_guard<std::mutex> lck (reaping_mtx);
+
+        for (auto& st: stopped_threads)
+            stopped_search_threads.push_back(std::move(st));
     }
 
-    return searching_threads.find(acc_address)->second.get_functor();
+    reaping_cv.notify_one();
 }
 
-void
-CurrentBlockchainStatus::clean_search_thread_map()
+size_t
+CurrentBlockchainStatus::reap_search_threads()
 {
-    std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
+    vector<pair<account_public_address,
+                std::shared_ptr<SearchThreadRegistry::search_thread_t>>>
+            threads_to_join;
 
-    for (auto& st: searching_threads)
     {
-        if (search_thread_exist(st.first)
-                && st.second.get_functor().still_searching() == false)
-        {
-            OMERROR << st.first << " still searching: "
-                 << st.second.get_functor().still_searching();
-            searching_threads.erase(st.first);
-        }
+        std::unique_lock<std::mutex> lck (reaping_mtx);
+
+        reaping_cv.wait(lck, [this]()
+                        {
+                            return !stopped_search_threads.empty();
+                        });
+
+        threads_to_join.swap(stopped_search_threads);
+    }
+
+    // stopped threads are joined here, outside of the lock. only
+    // then their addresses can get new search threads.
+    for (auto& st: threads_to_join)
+    {
+        std::thread& t = st.second->get();
+
+        if (t.joinable())
+            t.join();
+
+        searching_threads.remove_joined(st.first);
     }
+
+    return threads_to_join.size();
 }
 
 
@@ -968,63 +1990,140 @@ CurrentBlockchainStatus::construct_output_rct_field(
         const uint64_t global_amount_index,
         const uint64_t out_amount)
 {
+    COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount outs;
 
-   transaction random_output_tx;
-    uint64_t output_idx_in_tx;
+    outs.amount = out_amount;
+    outs.outs.push_back({global_amount_index, {}});
 
-    // we got random outputs, but now we need to get rct data of those
-    // outputs, because by default frontend created ringct txs.
+    vector<vector<tuple<string, string, string>>> rct_fields;
 
-    if (!CurrentBlockchainStatus::get_tx_with_output(
-            global_amount_index, out_amount,
-            random_output_tx, output_idx_in_tx))
+    if (!construct_output_rct_fields({outs}, rct_fields))
     {
         OMERROR << "cant get random output transaction";
         return make_tuple(string {}, string {}, string {});
     }
 
-    // placeholder variable for ringct outputs info
-    // that we need to save in database
-    string rtc_outpk;
-    string rtc_mask(64, '0');
-    string rtc_amount(64, '0');
+    return rct_fields.at(0).at(0);
+};
+
+bool
+CurrentBlockchainStatus::construct_output_rct_fields(
+        vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS
+            ::outs_for_amount> const& found_outputs,
+        vector<vector<tuple<string, string, string>>>& rct_fields)
+{
+    rct_fields.clear();
+    rct_fields.reserve(found_outputs.size());
+
+    // random outputs often come from same txs, so
+    // each tx is read and parsed only once.
+    unordered_map<crypto::hash, transaction> output_txs;
 
-    if (random_output_tx.version > 1 && !is_coinbase(random_output_tx))
-    {
-        rtc_outpk  = pod_to_hex(random_output_tx.rct_signatures
-                                .outPk[output_idx_in_tx].mask);
-        rtc_mask   = pod_to_hex(random_output_tx.rct_signatures
-                                .ecdhInfo[output_idx_in_tx].mask);
-        rtc_amount = pod_to_hex(random_output_tx.rct_signatures
-                                .ecdhInfo[output_idx_in_tx].amount);
-    }
-    else
+    try
     {
-        // for non ringct txs, we need to take it rct amount commitment
-        // and sent to the frontend. the mask is zero mask for those,
-        // as frontend will produce identy mask autmatically
-        //for non-ringct outputs
+        BatchRead batch_read {mcore.get()};
 
-        output_data_t od = get_output_key(out_amount, global_amount_index);
+        for (auto const& outs: found_outputs)
+        {
+            vector<uint64_t> global_amount_indices;
+            global_amount_indices.reserve(outs.outs.size());
 
-        rtc_outpk  = pod_to_hex(od.commitment);
+            for (auto const& out: outs.outs)
+                global_amount_indices.push_back(out.global_amount_index);
 
-        if (is_coinbase(random_output_tx))
-        {
-            // commenting this out. think its not needed.
-            // as this function provides keys for mixin outputs
-            // not the ones we actually spend.
-            // ringct coinbase txs are special. they have identity mask.
-            // as suggested by this code:
-            // https://github.com/monero-project/monero/blob/eacf2124b6822d088199179b18d4587404408e0f/src/wallet/wallet2.cpp#L893
-            // https://github.com/monero-project/monero/blob/master/src/blockchain_db/blockchain_db.cpp#L100
-            // rtc_mask   = pod_to_hex(rct::identity());
-        }
+            vector<output_data_t> outputs_data;
+
+            if (!get_output_keys(outs.amount, global_amount_indices,
+                                 outputs_data))
+                return false;
+
+            // only ringct outputs (i.e., zero amount) have encrypted
+            // mask and amount in their txs.
+            vector<tx_out_index> tx_out_indices;
+
+            if (outs.amount == 0)
+            {
+                mcore->get_output_tx_and_index(outs.amount,
+                                               global_amount_indices,
+                                               tx_out_indices);
+            }
+
+            if (outputs_data.size() != global_amount_indices.size()
+                    || (outs.amount == 0 && tx_out_indices.size()
+                                != global_amount_indices.size()))
+            {
+                OMERROR << "Not all random outputs found for amount "
+                        << outs.amount;
+                return false;
+            }
+
+            vector<tuple<string, string, string>> amount_rct_fields;
+            amount_rct_fields.reserve(outputs_data.size());
+
+            for (size_t i = 0; i < outputs_data.size(); ++i)
+            {
+                // for ringct outputs, commitment is same as outPk mask
+                // in their txs. for non-ringct outputs, its zero
+                // commitment of the amount, and the mask is zero mask,
+                // as frontend will produce identy mask autmatically.
+                string rtc_outpk  = pod_to_hex(outputs_data[i].commitment);
+                string rtc_mask(64, '0');
+                string rtc_amount(64, '0');
+
+                if (outs.amount == 0)
+                {
+                    tx_out_index const& tx_out_idx = tx_out_indices[i];
+
+                    auto tx_it = output_txs.find(tx_out_idx.first);
+
+                    if (tx_it == output_txs.end())
+                    {
+                        string tx_blob;
+                        transaction tx;
+
+                        if (!mcore->get_tx_blob(tx_out_idx.first, tx_blob)
+                                || !parse_and_validate_tx_base_from_blob(tx_blob, tx))
+                        {
+                            OMERROR << "Cant get tx: " << tx_out_idx.first;
+                            return false;
+                        }
+
+                        tx_it = output_txs.emplace(tx_out_idx.first,
+                                                   std::move(tx)).first;
+                    }
+
+                    transaction const& tx = tx_it->second;
+
+                    // ringct coinbase txs have identity mask and
+                    // non-encrypted amounts, so zeros are
+                    // sent for them as well.
+                    if (tx.version > 1 && !is_coinbase(tx)
+                            && tx_out_idx.second
+                                < tx.rct_signatures.ecdhInfo.size())
+                    {
+                        rtc_mask   = pod_to_hex(tx.rct_signatures
+                                                .ecdhInfo[tx_out_idx.second].mask);
+                        rtc_amount = pod_to_hex(tx.rct_signatures
+                                                .ecdhInfo[tx_out_idx.second].amount);
+                    }
+                }
+
+                amount_rct_fields.emplace_back(std::move(rtc_outpk),
+                                               std::move(rtc_mask),
+                                               std::move(rtc_amount));
+            }
 
+            rct_fields.push_back(std::move(amount_rct_fields));
+        }
+    }
+    catch (std::exception const& e)
+    {
+        OMERROR << "construct_output_rct_fields: " << e.what();
+        return false;
     }
 
-    return make_tuple(rtc_outpk, rtc_mask, rtc_amount);
-};
+    return true;
+}
 
 
 
@@ -1036,37 +2135,37 @@ CurrentBlockchainStatus::get_txs_in_blocks(
     // get height of the first block
     uint64_t h1 = get_block_height(blocks[0]);
 
+    // hashes of non-coinbase txs to be fetched
+    std::vector<crypto::hash> txs_to_get;
+
     for(uint64_t blk_i = 0; blk_i < blocks.size(); blk_i++)
     {
         block const& blk = blocks[blk_i];
         uint64_t blk_height = h1 + blk_i;
 
-        // first insert miner_tx
+        // miner_tx is already in the block, so
+        // no need to read it again
         txs_data.emplace_back(get_transaction_hash(blk.miner_tx),
-                              transaction{}, blk_height,
-                              blk.timestamp, true);
+                              blk.miner_tx, blk_height,
+                              blk.timestamp, true,
+                              0, vector<uint64_t>{}, tx_extra_info{});
 
         // now insert hashes of regular txs to be fatched later
-        // so for now, theys txs are null pointers
+        // so for now, theys txs are empty
         for (auto& tx_hash: blk.tx_hashes)
+        {
             txs_data.emplace_back(tx_hash, transaction{},
-                                  blk_height, blk.timestamp, false);
+                                  blk_height, blk.timestamp, false,
+                                  0, vector<uint64_t>{}, tx_extra_info{});
+            txs_to_get.push_back(tx_hash);
+        }
     }
 
-    // prepare vector<tx_hash> for CurrentBlockchainStatus::get_txs
-    // to fetch the correspoding transactions
-    std::vector<crypto::hash> txs_to_get;
-
-    for (auto const& tx_tuple: txs_data)
-        txs_to_get.push_back(std::get<0>(tx_tuple));
-
     // fetch all txs from the blocks that we are
     // analyzing in this iteration
     vector<cryptonote::transaction> txs;
-    vector<crypto::hash> missed_txs;
 
-    if (!CurrentBlockchainStatus::get_txs(txs_to_get, txs, missed_txs)
-            || !missed_txs.empty())
+    if (!get_txs_for_scanning(txs_to_get, txs))
     {
         OMERROR << "Cant get transactions in blocks from : " << h1;
         return false;
@@ -1074,15 +2173,187 @@ CurrentBlockchainStatus::get_txs_in_blocks(
 
     size_t tx_idx {0};
 
-    for (auto& tx: txs)
+    for (auto& tx_tuple: txs_data)
+    {
+        // coinbase txs are already there
+        if (!std::get<4>(tx_tuple))
+            std::get<1>(tx_tuple) = std::move(txs[tx_idx++]);
+
+        // parsed once here, rather than by each user of the tx
+        std::get<7>(tx_tuple)
+                = xmreg::parse_tx_extra_info(std::get<1>(tx_tuple).extra);
+    }
+
+    return true;
+}
+
+bool
+CurrentBlockchainStatus::get_tx_output_indices(txs_tuple_t& tx_tuple)
+{
+    // every tx has some outputs, so empty indices
+    // mean that they have not been read yet
+    if (!std::get<6>(tx_tuple).empty())
+        return true;
+
+    try
+    {
+        if (!mcore->tx_exists(std::get<0>(tx_tuple), std::get<5>(tx_tuple)))
+        {
+            OMERROR << "Tx " << pod_to_hex(std::get<0>(tx_tuple))
+                    << " not found in blockchain";
+            return false;
+        }
+
+        std::get<6>(tx_tuple) = mcore->get_tx_amount_output_indices(
+                    std::get<5>(tx_tuple));
+    }
+    catch(const exception& e)
     {
-        auto& tx_tuple = txs_data[tx_idx++];
-        //assert(std::get<0>(tx_tuple) == get_transaction_hash(tx));
-        std::get<1>(tx_tuple) = std::move(tx);
+        OMERROR << "Cant get output indices of tx "
+                << pod_to_hex(std::get<0>(tx_tuple)) << ": " << e.what();
+        return false;
     }
 
     return true;
 }
 
+std::shared_ptr<CurrentBlockchainStatus::ring_members_t const>
+CurrentBlockchainStatus::get_ring_members(
+        vector<txs_tuple_t> const& txs_data)
+{
+    if (txs_data.empty())
+        return std::make_shared<ring_members_t const>();
+
+    crypto::hash const& first_tx_hash = std::get<0>(txs_data.front());
+    crypto::hash const& last_tx_hash  = std::get<0>(txs_data.back());
+
+    {
+        std::lock_guard<std::mutex> lck (recent_ring_members_mtx);
+
+        for (auto const& range: recent_ring_members)
+        {
+            if (range.first_tx_hash == first_tx_hash
+                    && range.last_tx_hash == last_tx_hash)
+                return range.ring_members;
+        }
+    }
+
+    // global_amount_indices of ring members for each amount.
+    // sorted and deduplicated once all of them are collected.
+    std::map<uint64_t, vector<uint64_t>> indices_for_amounts;
+
+    // with duplicates, so that the cap bounds the memory
+    // used for collecting them too
+    size_t no_of_ring_members {0};
+
+    for (auto const& tx_tuple: txs_data)
+    {
+        for (txin_to_key const& in_key: inputs_to_key(std::get<1>(tx_tuple)))
+        {
+            vector<uint64_t>& indices = indices_for_amounts[in_key.amount];
+
+            // relative offsets to absolute ones
+            uint64_t absolute_offset {0};
+
+            for (uint64_t offset: in_key.key_offsets)
+                indices.push_back(absolute_offset += offset);
+
+            no_of_ring_members += in_key.key_offsets.size();
+        }
+
+        // too many for one range. each ring is read separately then.
+        if (no_of_ring_members > MAX_RING_MEMBERS_PER_RANGE)
+            return nullptr;
+    }
+
+    auto ring_members = std::make_shared<ring_members_t>();
+
+    {
+        BatchRead batch_read {mcore.get()};
+
+        // reused for all amounts
+        vector<output_data_t> outputs;
+
+        for (auto& amount_indices: indices_for_amounts)
+        {
+            uint64_t const amount = amount_indices.first;
+
+            vector<uint64_t>& global_amount_indices = amount_indices.second;
+
+            std::sort(global_amount_indices.begin(),
+                      global_amount_indices.end());
+
+            global_amount_indices.erase(
+                    std::unique(global_amount_indices.begin(),
+                                global_amount_indices.end()),
+                    global_amount_indices.end());
+
+            if (!get_output_keys(amount, global_amount_indices, outputs))
+            {
+                OMERROR << "Cant get ring members for amount " << amount;
+                return nullptr;
+            }
+
+            // indices are sorted, so each insert is at the end
+            for (size_t i = 0; i < outputs.size(); ++i)
+                ring_members->emplace_hint(ring_members->end(),
+                                           ring_member_key_t {
+                                               amount,
+                                               global_amount_indices[i]},
+                                           outputs[i]);
+        }
+    }
+
+    std::lock_guard<std::mutex> lck (recent_ring_members_mtx);
+
+    recent_ring_members.push_back({first_tx_hash, last_tx_hash,
+                                   ring_members});
+
+    if (recent_ring_members.size() > MAX_SHARED_RING_MEMBERS_RANGES)
+        recent_ring_members.pop_front();
+
+    return ring_members;
+}
+
+std::shared_ptr<vector<PrecomputedTxPubKey> const>
+CurrentBlockchainStatus::get_precomputed_tx_pub_keys(
+        vector<txs_tuple_t> const& txs_data)
+{
+    if (txs_data.empty())
+        return std::make_shared<vector<PrecomputedTxPubKey> const>();
+
+    crypto::hash const& first_tx_hash = std::get<0>(txs_data.front());
+    crypto::hash const& last_tx_hash  = std::get<0>(txs_data.back());
+
+    {
+        std::lock_guard<std::mutex> lck (recent_tx_pub_keys_mtx);
+
+        for (auto const& range: recent_tx_pub_keys)
+        {
+            if (range.first_tx_hash == first_tx_hash
+                    && range.last_tx_hash == last_tx_hash)
+                return range.tx_pub_keys;
+        }
+    }
+
+    auto tx_pub_keys = std::make_shared<vector<PrecomputedTxPubKey>>(
+                txs_data.size());
+
+    for (size_t i = 0; i < txs_data.size(); ++i)
+    {
+        // not initialized ones are just not used
+        (*tx_pub_keys)[i].init(std::get<7>(txs_data[i]).tx_pub_key);
+    }
+
+    std::lock_guard<std::mutex> lck (recent_tx_pub_keys_mtx);
+
+    recent_tx_pub_keys.push_back({first_tx_hash, last_tx_hash,
+                                  tx_pub_keys});
+
+    if (recent_tx_pub_keys.size() > MAX_PRECOMPUTED_TX_PUB_KEYS_RANGES)
+        recent_tx_pub_keys.pop_front();
+
+    return tx_pub_keys;
 }
 
+}
@@ -8,17 +8,28 @@
 #include "ssqlses.h"
 #include "TxUnlockChecker.h"
 #include "BlockchainSetup.h"
-#include "TxSearch.h"
 #include "tools.h"
 #include "ThreadRAII.h"
 #include "RPCCalls.h"
 #include "MySqlAccounts.h"
+#include "AccountEvents.h"
+#include "OutputKeyCache.h"
+#include "KnownOutputsIndex.h"
+#include "SearchThreadRegistry.h"
+#include "BlockTimestampIndex.h"
+#include "PrecomputedTxPubKey.h"
 
 #include <iostream>
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
+#include <unordered_set>
+#include <map>
+#include <set>
+#include <deque>
+#include <functional>
 
 
 namespace xmreg {
@@ -27,6 +38,7 @@ using namespace std;
 
 class XmrAccount;
 class MySqlAccounts;
+class TxSearch;
 
 
 /*
@@ -48,10 +60,27 @@ public:
 
 
     //                            tx_hash      , tx,          height , timestamp, is_coinbase
+    //                            blockchain_tx_id, amount_specific_indices, parsed tx_extra
     using txs_tuple_t
-        = std::tuple<crypto::hash, transaction, uint64_t, uint64_t, bool>;
+        = std::tuple<crypto::hash, transaction, uint64_t, uint64_t, bool,
+                     uint64_t, vector<uint64_t>, tx_extra_info>;
+
+    // outputs used as ring members, i.e., mixins, in inputs of txs
+    //                        amount  , global_amount_index
+    using ring_member_key_t = std::pair<uint64_t, uint64_t>;
+    using ring_members_t    = std::map<ring_member_key_t, output_data_t>;
+
+    // data which changes only with new blocks. made by the monitor
+    // thread once per block, so that requests dont need to
+    // recompute it.
+    struct BlockchainSnapshot
+    {
+        uint64_t     height;
+        crypto::hash tip_hash;
+        uint64_t     per_kb_fee;
+    };
 
-    atomic<uint64_t> current_height;
+    atomic<uint64_t> current_height {0};
 
     atomic<bool> is_running;
 
@@ -68,9 +97,35 @@ public:
     virtual void
     update_current_blockchain_height();
 
+    // adds timestamps of new blocks to block_timestamps. on first
+    // call, loads the index from bc_setup.block_timestamps_file
+    // and fills in the rest from lmdb. executed by its own thread,
+    // started with the monitor thread.
+    virtual bool
+    update_block_timestamp_index();
+
+    // first height that can have blocks mined at or after the timestamp.
+    // false if the index is not built yet.
+    virtual bool
+    get_height_for_timestamp(uint64_t timestamp, uint64_t& height) const;
+
+    // publishes new snapshot if the top block has changed
+    virtual bool
+    update_blockchain_snapshot();
+
+    // lock-free. null until monitor thread makes first snapshot.
+    std::shared_ptr<BlockchainSnapshot const>
+    get_blockchain_snapshot() const;
+
     virtual bool
     init_monero_blockchain();
 
+    // keeps one lmdb read transaction for all blockchain reads
+    // in this thread, e.g., for a whole range of blocks analyzed
+    // by a search thread, until the returned object is destroyed.
+    BatchRead
+    make_batch_read();
+
     // inject TxUnlockChecker object
     // its simplifies mocking its behavior in our
     // tests, as we just inject mock version of
@@ -92,6 +147,18 @@ public:
                   vector<transaction> &blk_txs,
                   vector<crypto::hash>& missed_txs);
 
+    /**
+     * Read txs for scanning, i.e., only their prefixes and
+     * base of rct signatures (type, ecdhInfo, outPk). Ring
+     * signatures and range proofs are skipped.
+     *
+     * Such txs cant be hashed, serialized or relayed, as their
+     * prunable part is missing. Their hashes are the ones given.
+     */
+    virtual bool
+    get_txs_for_scanning(vector<crypto::hash> const& txs_to_get,
+                         vector<transaction>& txs);
+
     virtual bool
     get_txs(vector<crypto::hash> const& txs_to_get,
             vector<transaction>& txs,
@@ -110,6 +177,8 @@ public:
     get_tx_with_output(uint64_t output_idx, uint64_t amount,
                        transaction& tx, uint64_t& output_idx_in_tx);
 
+    // outputs are served from output_key_cache if possible,
+    // and the rest is read from lmdb in one go
     virtual bool
     get_output_keys(const uint64_t& amount,
                     const vector<uint64_t>& absolute_offsets,
@@ -132,12 +201,65 @@ public:
     get_amount_specific_indices(const crypto::hash& tx_hash,
                                 vector<uint64_t>& out_indices);
 
+    /**
+     * Get random outputs (decoys) for the given amounts.
+     *
+     * Decoys for ringct outputs (i.e., amount 0) are picked here,
+     * from the cached rct output distribution using the same
+     * gamma selection as wallet2. Pre-ringct amounts, or all amounts
+     * before the distribution is cached, go to the
+     * Blockchain::get_random_outs_for_amounts.
+     */
     virtual bool
     get_random_outputs(const vector<uint64_t>& amounts,
                        const uint64_t& outs_count,
                        vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS
                         ::outs_for_amount>& found_outputs);
 
+    /**
+     * Pick outs_count unlocked ringct decoys for each
+     * of no_of_rings rings.
+     *
+     * Keys of all picked outputs are read at once.
+     * Outputs in each ring are sorted by their global index.
+     */
+    virtual bool
+    get_random_rct_outputs(size_t no_of_rings,
+                           uint64_t outs_count,
+                           vector<vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS
+                                ::out_entry>>& rings);
+
+    /**
+     * Extend cached distribution of ringct outputs
+     * with blocks added since previous call.
+     *
+     * Called by the blockchain monitoring thread. Whole distribution
+     * is read from monero only the first time. Later, only outputs in
+     * new blocks are counted, and last few blocks are always
+     * re-counted, in case of reorgs.
+     */
+    virtual bool
+    update_rct_output_distribution();
+
+    /**
+     * Read distribution of all ringct outputs from monero,
+     * replacing the cached one.
+     */
+    virtual bool
+    read_rct_output_distribution();
+
+    /**
+     * Cumulative numbers of ringct outputs at blocks h1 to h2,
+     * given no_of_outputs before h1, counted from their txs.
+     */
+    virtual bool
+    count_rct_outputs(uint64_t h1, uint64_t h2,
+                      uint64_t no_of_outputs,
+                      vector<uint64_t>& offsets);
+
+    virtual bool
+    is_rct_output_distribution_ready() const;
+
     virtual uint64_t
     get_dynamic_per_kb_fee_estimate() const;
 
@@ -151,6 +273,40 @@ public:
     virtual vector<pair<uint64_t, transaction>>
     get_mempool_txs();
 
+    // same txs as get_mempool_txs(), without copying them.
+    // the snapshot is replaced, never modified, by read_mempool()
+    // when txs in the mempool change
+    virtual std::shared_ptr<mempool_txs_t const>
+    get_mempool_txs_snapshot();
+
+    virtual void
+    set_account_events(std::shared_ptr<AccountEvents> _account_events);
+
+    virtual std::shared_ptr<AccountEvents>
+    get_account_events();
+
+    /**
+     * Push events to accounts subscribed over websockets.
+     *
+     * Executed by the blockchain monitoring thread after
+     * each mempool read. It keeps search threads of subscribed
+     * accounts alive, and sends them our txs from
+     * the mempool that were not present in the previous read.
+     */
+    virtual void
+    notify_subscribers();
+
+    /**
+     * Scans new blocks and mempool txs for payments to the import
+     * wallet, and remembers them by their decrypted payment ids.
+     * Each block and mempool tx is scanned only once. Executed
+     * by the monitor thread, after each read_mempool() and
+     * update of the blockchain height, in that order.
+     */
+    virtual bool
+    update_import_payments();
+
+    // looks up payments found by update_import_payments
     virtual bool
     search_if_payment_made(
             const string& payment_id_str,
@@ -165,24 +321,38 @@ public:
     get_output_key(uint64_t amount,
                    uint64_t global_amount_index);
 
+    OutputKeyCache const&
+    get_output_key_cache() const {return *output_key_cache;}
+
+    // outputs of all accounts with search threads
+    KnownOutputsIndex&
+    get_known_outputs_index() {return *known_outputs_index;}
+
     // definitions of these function are at the end of this file
     // due to forward declaraions of TxSearch
     virtual bool
     start_tx_search_thread(XmrAccount acc,
                            std::unique_ptr<TxSearch> tx_search);
 
+    // methods of search threads take already parsed addresses,
+    // so that requests parse their addresses only once
+
     virtual bool
-    ping_search_thread(const string& address);
+    ping_search_thread(account_public_address const& address);
 
     virtual bool
-    search_thread_exist(const string& address);
+    search_thread_exist(account_public_address const& address);
+
+    // null if the address has no search thread
+    virtual std::shared_ptr<SearchThreadRegistry::search_thread_t>
+    get_search_thread(account_public_address const& address);
 
     virtual bool
-    get_xmr_address_viewkey(const string& address_str,
+    get_xmr_address_viewkey(account_public_address const& acc_address,
                             address_parse_info& address,
                             secret_key& viewkey);
     virtual bool
-    find_txs_in_mempool(const string& address_str,
+    find_txs_in_mempool(account_public_address const& address,
                         json& transactions);
 
     virtual bool
@@ -205,20 +375,24 @@ public:
     get_tx_block_height(crypto::hash const& tx_hash, int64_t& tx_height);
 
     virtual bool
-    set_new_searched_blk_no(const string& address,
+    set_new_searched_blk_no(account_public_address const& address,
                             uint64_t new_value);
 
     virtual bool
-    get_searched_blk_no(const string& address,
+    get_searched_blk_no(account_public_address const& address,
                         uint64_t& searched_blk_no);
 
-    virtual bool
-    get_known_outputs_keys(string const& address,
-                           unordered_map<public_key, uint64_t>& known_outputs_keys);
-
+    // removes stopped search threads and passes them
+    // to the reaper thread, without waiting for them
     virtual void
     clean_search_thread_map();
 
+    // joins search threads removed by clean_search_thread_map,
+    // waiting for some if there are none. executed by the
+    // reaper thread. returns number of threads released.
+    virtual size_t
+    reap_search_threads();
+
     /*
      * The frontend requires rct field to work
      * the filed consisitct of rct_pk, mask, and amount.
@@ -228,6 +402,25 @@ public:
             const uint64_t global_amount_index,
             const uint64_t out_amount);
 
+    /**
+     * Batch version of construct_output_rct_field for all
+     * outputs returned by get_random_outputs.
+     *
+     * rct_pk is taken directly from output's commitment stored
+     * in lmdb. Only ringct outputs need their txs, and of these
+     * only prefix and rct base are parsed, once per tx.
+     * All reads are done within one lmdb read transaction.
+     *
+     * @param found_outputs outputs as returned by get_random_outputs
+     * @param rct_fields rct fields of found_outputs, in the same order
+     * @return false if any of the outputs or their txs cant be read
+     */
+    virtual bool
+    construct_output_rct_fields(
+            vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS
+                ::outs_for_amount> const& found_outputs,
+            vector<vector<tuple<string, string, string>>>& rct_fields);
+
 
     inline virtual BlockchainSetup const&
     get_bc_setup() const
@@ -235,10 +428,57 @@ public:
         return bc_setup;
     }
 
+    // txs are read using get_txs_for_scanning, except coinbase
+    // txs which are taken from the blocks. their tx_extra is
+    // parsed, but lmdb tx ids and amount specific indices
+    // are not filled in.
     virtual bool
     get_txs_in_blocks(vector<block> const& blocks,
                       vector<txs_tuple_t>& txs_data);
 
+    // fills in lmdb tx id and amount specific indices of a tx
+    // from get_txs_in_blocks, unless they are already there.
+    // search threads need them only for few txs, i.e., those
+    // with their outputs or inputs.
+    virtual bool
+    get_tx_output_indices(txs_tuple_t& tx_tuple);
+
+    /**
+     * Resolves all ring members of all inputs of the given txs at once.
+     *
+     * (amount, global_amount_index) pairs are sorted and deduplicated,
+     * and read in one lmdb read transaction, amount by amount.
+     *
+     * Search threads of different accounts often analyze same
+     * blocks (e.g., the newest block), so results for a few most
+     * recent block ranges are kept and shared between them.
+     *
+     * Ranges with very many ring members, counted with
+     * duplicates, are not read at once, to bound memory used
+     * by the shared results.
+     *
+     * @param txs_data txs as returned by get_txs_in_blocks
+     * @return ring members or nullptr if they cant be read,
+     *         or there are too many of them
+     */
+    virtual std::shared_ptr<ring_members_t const>
+    get_ring_members(vector<txs_tuple_t> const& txs_data);
+
+    /**
+     * Precomputes pub keys of the given txs, so that search
+     * threads of all accounts analyzing the same blocks generate
+     * their derivations from the same decompressed pub keys,
+     * and tables of their multiples.
+     *
+     * Kept for a few most recent block ranges, like ring members.
+     *
+     * @param txs_data txs as returned by get_txs_in_blocks
+     * @return precomputed pub keys in the order of txs_data.
+     *  Pub keys which are not valid points are not initialized.
+     */
+    virtual std::shared_ptr<vector<PrecomputedTxPubKey> const>
+    get_precomputed_tx_pub_keys(vector<txs_tuple_t> const& txs_data);
+
     // default destructor is fine
     virtual ~CurrentBlockchainStatus() = default;
 
@@ -252,9 +492,6 @@ public:
 
 protected:
 
-    virtual TxSearch&
-    get_search_thread(string const& acc_address);
-
     // parameters used to connect/read monero blockchain
     BlockchainSetup bc_setup;
 
@@ -273,22 +510,169 @@ protected:
     // vector of mempool transactions that all threads
     // can refer to
     //           <recieved_time, transaction>
-    mempool_txs_t mempool_txs;
+    // only accessed using std::atomic_load and std::atomic_store
+    std::shared_ptr<mempool_txs_t const> mempool_txs
+            {std::make_shared<mempool_txs_t const>()};
 
-    // map that will keep track of search threads. In the
-    // map, key is address to which a running thread belongs to.
-    // make it static to guarantee only one such map exist.
-    map<string, ThreadRAII2<TxSearch>> searching_threads;
+    // keeps track of search threads, by addresses
+    // to which they belong to.
+    SearchThreadRegistry searching_threads;
 
     // thread that will be dispachaed and will keep monitoring blockchain
     // and mempool changes
     std::thread m_thread;
 
-    // to synchronize searching access to searching_threads map
-    mutex searching_threads_map_mtx;
+    // keeps block_timestamps up to date
+    std::thread block_timestamps_thread;
 
-    // to synchronize access to mempool_txs vector
+    // joins stopped search threads. a stopped thread can still
+    // be scanning its last blocks, so the monitor thread does
+    // not wait for it.
+    std::thread reaper_thread;
+
+    // to synchronize access to stopped_search_threads
+    mutex reaping_mtx;
+    std::condition_variable reaping_cv;
+
+    // removed from searching_threads, but not joined yet
+    vector<pair<account_public_address,
+                std::shared_ptr<SearchThreadRegistry::search_thread_t>>>
+            stopped_search_threads;
+
+    // to synchronize access to new_mempool_txs
+    // and mempool_tx_hashes
     mutex getting_mempool_txs;
+
+    // txs which appeared in the mempool since previous
+    // read_mempool(), and hashes of all txs from the last read.
+    // used to push only new mempool txs to subscribers.
+    mempool_txs_t new_mempool_txs;
+    unordered_set<crypto::hash> mempool_tx_hashes;
+
+    // websockets subscribed to accounts' events.
+    // can be null, e.g., in tests.
+    std::shared_ptr<AccountEvents> account_events;
+
+    // cumulative number of ringct outputs at each block, starting
+    // from rct_distribution_start_height, i.e., same as
+    // rct_offsets used by wallet2 for picking decoys.
+    vector<uint64_t> rct_output_offsets;
+
+    uint64_t rct_distribution_start_height {0};
+
+    // number of ringct outputs before rct_distribution_start_height
+    uint64_t rct_distribution_base {0};
+
+    struct import_payment_t
+    {
+        crypto::hash tx_hash;
+        uint64_t     amount;
+        bool         in_mempool;
+        uint64_t     height;     // of its block, if not in_mempool
+    };
+
+    // payments to the import wallet found so far, by
+    // their decrypted payment ids. payments in txs which left the
+    // mempool without being mined, or in orphaned blocks, are
+    // removed.
+    unordered_map<string, vector<import_payment_t>> import_payments;
+
+    // to synchronize access to import_payments
+    mutex import_payments_mtx;
+
+    // next block to scan for import payments.
+    // used only by the monitor thread.
+    uint64_t import_payments_next_height {0};
+    bool import_payments_started {false};
+
+    // hash of the block at import_payments_next_height - 1,
+    // to detect reorgs. used only by the monitor thread.
+    crypto::hash import_payments_last_hash {null_hash};
+
+    // mempool txs already scanned for import payments.
+    // used only by the monitor thread.
+    unordered_set<crypto::hash> import_payments_mempool_tx_hashes;
+
+    // checks if tx has encrypted payment id and
+    // outputs for the import wallet
+    bool
+    identify_import_payment(transaction const& tx,
+                            string& payment_id_str,
+                            uint64_t& total_received);
+
+    void
+    add_import_payment(string const& payment_id_str,
+                       crypto::hash const& tx_hash,
+                       uint64_t amount,
+                       bool in_mempool,
+                       uint64_t height);
+
+    void
+    remove_import_payments(
+            std::function<bool(import_payment_t const&)> const& to_remove);
+
+    BlockTimestampIndex block_timestamps;
+
+    // size of block_timestamps when it was last saved.
+    // used only by block_timestamps_thread.
+    uint64_t block_timestamps_saved_size {0};
+    bool block_timestamps_loaded {false};
+
+    // only accessed using std::atomic_load and std::atomic_store
+    std::shared_ptr<BlockchainSnapshot const> blockchain_snapshot;
+
+    // to synchronize access to rct_output_offsets
+    mutable mutex rct_distribution_mtx;
+
+    // outputs' keys shared by all search threads and
+    // get_random_outs. only outputs older than
+    // CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE are put there, as
+    // the cache is not cleared on reorgs.
+    std::unique_ptr<OutputKeyCache> output_key_cache;
+
+    // filled by search threads
+    std::unique_ptr<KnownOutputsIndex> known_outputs_index;
+
+    // ring members of recently analyzed block ranges, identified
+    // by hashes of their first and last txs. newest last.
+    struct block_range_ring_members
+    {
+        crypto::hash first_tx_hash;
+        crypto::hash last_tx_hash;
+        std::shared_ptr<ring_members_t const> ring_members;
+    };
+
+    std::deque<block_range_ring_members> recent_ring_members;
+
+    // to synchronize access to recent_ring_members
+    mutex recent_ring_members_mtx;
+
+    // precomputed tx pub keys of recently analyzed block ranges,
+    // identified as the ring members are
+    struct block_range_tx_pub_keys
+    {
+        crypto::hash first_tx_hash;
+        crypto::hash last_tx_hash;
+        std::shared_ptr<vector<PrecomputedTxPubKey> const> tx_pub_keys;
+    };
+
+    std::deque<block_range_tx_pub_keys> recent_tx_pub_keys;
+
+    // to synchronize access to recent_tx_pub_keys
+    mutex recent_tx_pub_keys_mtx;
+
+    // put outputs which can't be reorganized anymore into the cache
+    void
+    cache_output_keys(uint64_t amount,
+                      vector<uint64_t> const& global_amount_indices,
+                      vector<output_data_t> const& outputs);
+
+    // pick decoys using gamma distribution of output ages, as
+    // in wallet2. rct_distribution_mtx must be locked by the caller.
+    bool
+    pick_rct_output_indices(size_t count,
+                            unordered_set<uint64_t> const& excluded,
+                            vector<uint64_t>& picks) const;
 };
 
 
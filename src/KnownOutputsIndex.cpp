@@ -0,0 +1,121 @@
+#include "KnownOutputsIndex.h"
+
+namespace xmreg
+{
+
+constexpr size_t KnownOutputsIndex::NO_OF_SHARDS;
+
+void
+KnownOutputsIndex::insert(public_key const& out_pub_key,
+                          known_output_t const& known_output)
+{
+    Shard& shard = get_shard(out_pub_key);
+
+    std::lock_guard<std::mutex> lck (shard.mtx);
+
+    shard.outputs.insert(out_pub_key, known_output);
+}
+
+void
+KnownOutputsIndex::acquire(uint64_t account_id)
+{
+    std::lock_guard<std::mutex> lck (owners_mtx);
+
+    ++owners[account_id];
+}
+
+void
+KnownOutputsIndex::release(uint64_t account_id)
+{
+    // kept while erasing, so that a thread acquiring the
+    // account meanwhile inserts its outputs only afterwards
+    std::lock_guard<std::mutex> lck (owners_mtx);
+
+    auto it = owners.find(account_id);
+
+    if (it == owners.end() || --it->second > 0)
+        return;
+
+    owners.erase(it);
+
+    // search threads end rarely, so going over all
+    // the outputs is fine here
+    vector<public_key> out_pub_keys;
+
+    for (Shard& shard: shards)
+    {
+        std::lock_guard<std::mutex> shard_lck (shard.mtx);
+
+        out_pub_keys.clear();
+
+        shard.outputs.for_each(
+                [&out_pub_keys, account_id](public_key const& out_pub_key,
+                                            known_output_t const& known_output)
+                {
+                    if (known_output.account_id == account_id)
+                        out_pub_keys.push_back(out_pub_key);
+                });
+
+        for (public_key const& out_pub_key: out_pub_keys)
+            shard.outputs.erase(out_pub_key);
+    }
+}
+
+bool
+KnownOutputsIndex::find(public_key const& out_pub_key,
+                        known_output_t& known_output) const
+{
+    Shard const& shard = get_shard(out_pub_key);
+
+    std::lock_guard<std::mutex> lck (shard.mtx);
+
+    return shard.outputs.find(out_pub_key, known_output);
+}
+
+size_t
+KnownOutputsIndex::size() const
+{
+    size_t total {0};
+
+    for (Shard const& shard: shards)
+    {
+        std::lock_guard<std::mutex> lck (shard.mtx);
+        total += shard.outputs.size();
+    }
+
+    return total;
+}
+
+size_t
+KnownOutputsIndex::memory_usage() const
+{
+    size_t total {sizeof(*this)};
+
+    for (Shard const& shard: shards)
+    {
+        std::lock_guard<std::mutex> lck (shard.mtx);
+        total += shard.outputs.memory_usage();
+    }
+
+    return total;
+}
+
+KnownOutputsIndex::Shard&
+KnownOutputsIndex::get_shard(public_key const& out_pub_key)
+{
+    return shards[shard_no(out_pub_key)];
+}
+
+KnownOutputsIndex::Shard const&
+KnownOutputsIndex::get_shard(public_key const& out_pub_key) const
+{
+    return shards[shard_no(out_pub_key)];
+}
+
+size_t
+KnownOutputsIndex::shard_no(public_key const& out_pub_key)
+{
+    return static_cast<unsigned char>(out_pub_key.data[8]) % NO_OF_SHARDS;
+}
+
+}
@@ -0,0 +1,108 @@
+#ifndef OPENMONERO_KNOWNOUTPUTSINDEX_H
+#define OPENMONERO_KNOWNOUTPUTSINDEX_H
+
+#include "monero_headers.h"
+#include "KnownOutputsMap.h"
+
+#include <array>
+#include <mutex>
+#include <unordered_map>
+
+namespace xmreg
+{
+
+using namespace cryptonote;
+using namespace crypto;
+using namespace std;
+
+/**
+ * Index of outputs of all accounts with running search
+ * threads, from outputs' public keys to their accounts.
+ *
+ * Search threads put their outputs from the Outputs table
+ * into it when they start, and add new ones as they find them.
+ *
+ * Each search thread scans its own range of blocks, so ring
+ * members are still looked up by every thread, for its own
+ * account only. One lookup finds the output of any account,
+ * but it is not used to find spends of all the accounts in
+ * a single pass over a tx.
+ *
+ * An account can have more than one search thread for a while,
+ * e.g., a new one started after login while the stopped one
+ * is joined, but not destroyed yet, as a request still uses it. So threads acquire their account's
+ * outputs, and the outputs are removed only when the last
+ * of its threads releases them.
+ *
+ * Like OutputKeyCache, it is split into shards, each with
+ * its own lock.
+ */
+class KnownOutputsIndex
+{
+public:
+
+    using known_output_t = KnownOutputsMap::known_output_t;
+
+    static constexpr size_t NO_OF_SHARDS {16};
+
+    // replaces the output if it is already there. an output found
+    // again, e.g., by rescan, was deleted and inserted into mysql
+    // again, so its old id is not kept.
+    void
+    insert(public_key const& out_pub_key, known_output_t const& known_output);
+
+    // called by a search thread before it inserts
+    // outputs of the account
+    void
+    acquire(uint64_t account_id);
+
+    // removes all outputs of the account, if no other
+    // search thread acquired them
+    void
+    release(uint64_t account_id);
+
+    bool
+    find(public_key const& out_pub_key, known_output_t& known_output) const;
+
+    size_t
+    size() const;
+
+    // approximate memory used by the index, in bytes
+    size_t
+    memory_usage() const;
+
+private:
+
+    struct Shard
+    {
+        mutable mutex mtx;
+
+        KnownOutputsMap outputs;
+    };
+
+    Shard&
+    get_shard(public_key const& out_pub_key);
+
+    Shard const&
+    get_shard(public_key const& out_pub_key) const;
+
+    // KnownOutputsMap picks slots by the first 8 bytes of keys.
+    // shards are picked by another byte, as otherwise all keys
+    // of a shard would have the same low bits, and be put into
+    // every 16th slot of its map.
+    static size_t
+    shard_no(public_key const& out_pub_key);
+
+    std::array<Shard, NO_OF_SHARDS> shards;
+
+    // taken before locks of shards, when outputs of
+    // an account are removed
+    mutex owners_mtx;
+
+    //           account_id, number of its search threads
+    unordered_map<uint64_t, size_t> owners;
+};
+
+}
+
+#endif //OPENMONERO_KNOWNOUTPUTSINDEX_H
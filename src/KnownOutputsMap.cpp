@@ -0,0 +1,134 @@
+#include "KnownOutputsMap.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace xmreg
+{
+
+constexpr size_t KnownOutputsMap::MIN_NO_OF_SLOTS;
+
+void
+KnownOutputsMap::reserve(size_t no_of_outputs_to_hold)
+{
+    size_t no_of_slots = std::max(slots.size(), MIN_NO_OF_SLOTS);
+
+    while (4 * no_of_outputs_to_hold > 3 * no_of_slots)
+        no_of_slots *= 2;
+
+    if (no_of_slots != slots.size())
+        rehash(no_of_slots);
+}
+
+void
+KnownOutputsMap::insert(public_key const& out_pub_key,
+                        known_output_t const& known_output)
+{
+    if (out_pub_key == null_pkey)
+        return;
+
+    if (4 * (no_of_outputs + 1) > 3 * slots.size())
+        reserve(no_of_outputs + 1);
+
+    slot_t& slot = slots[find_slot(out_pub_key)];
+
+    if (slot.out_pub_key == null_pkey)
+    {
+        slot.out_pub_key = out_pub_key;
+        ++no_of_outputs;
+    }
+
+    slot.known_output = known_output;
+}
+
+bool
+KnownOutputsMap::find(public_key const& out_pub_key,
+                      known_output_t& known_output) const
+{
+    if (slots.empty())
+        return false;
+
+    slot_t const& slot = slots[find_slot(out_pub_key)];
+
+    if (slot.out_pub_key == null_pkey)
+        return false;
+
+    known_output = slot.known_output;
+
+    return true;
+}
+
+bool
+KnownOutputsMap::erase(public_key const& out_pub_key)
+{
+    if (slots.empty() || out_pub_key == null_pkey)
+        return false;
+
+    size_t const mask = slots.size() - 1;
+
+    size_t hole = find_slot(out_pub_key);
+
+    if (slots[hole].out_pub_key == null_pkey)
+        return false;
+
+    // outputs after the hole, up to the next empty slot, are moved
+    // back into it if it is on their probe path. so lookups dont
+    // need tombstones.
+    for (size_t idx = (hole + 1) & mask;
+         slots[idx].out_pub_key != null_pkey;
+         idx = (idx + 1) & mask)
+    {
+        size_t const home = home_slot(slots[idx].out_pub_key);
+
+        if (((idx - home) & mask) >= ((idx - hole) & mask))
+        {
+            slots[hole] = slots[idx];
+            hole = idx;
+        }
+    }
+
+    slots[hole].out_pub_key = null_pkey;
+
+    --no_of_outputs;
+
+    return true;
+}
+
+size_t
+KnownOutputsMap::home_slot(public_key const& out_pub_key) const
+{
+    uint64_t hash;
+
+    std::memcpy(&hash, out_pub_key.data, sizeof(hash));
+
+    return hash & (slots.size() - 1);
+}
+
+size_t
+KnownOutputsMap::find_slot(public_key const& out_pub_key) const
+{
+    size_t const mask = slots.size() - 1;
+
+    size_t idx = home_slot(out_pub_key);
+
+    // there is always an empty slot, so this ends
+    while (slots[idx].out_pub_key != null_pkey
+           && slots[idx].out_pub_key != out_pub_key)
+        idx = (idx + 1) & mask;
+
+    return idx;
+}
+
+void
+KnownOutputsMap::rehash(size_t no_of_slots)
+{
+    vector<slot_t> old_slots(no_of_slots, slot_t {null_pkey, {}});
+
+    old_slots.swap(slots);
+
+    for (slot_t const& slot: old_slots)
+        if (slot.out_pub_key != null_pkey)
+            slots[find_slot(slot.out_pub_key)] = slot;
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef OPENMONERO_KNOWNOUTPUTSMAP_H
+#define OPENMONERO_KNOWNOUTPUTSMAP_H
+
+#include "monero_headers.h"
+
+#include <vector>
+
+namespace xmreg
+{
+
+using namespace cryptonote;
+using namespace crypto;
+using namespace std;
+
+/**
+ * Map from outputs' public keys to their accounts and amounts.
+ * Shards of KnownOutputsIndex keep their outputs in it.
+ *
+ * Entries are kept in one array, with open addressing and
+ * linear probing, so a lookup usually reads one cache line
+ * and there is no heap node per entry. Public keys are already
+ * uniformly distributed, so their first 8 bytes are the hash.
+ *
+ * Empty slots have null_pkey as the key, so null_pkey can't
+ * be inserted.
+ */
+class KnownOutputsMap
+{
+public:
+
+    struct known_output_t
+    {
+        uint64_t account_id;
+
+        // id in the Outputs table, or 0 if not known yet
+        uint64_t output_id;
+
+        uint64_t amount;
+    };
+
+    KnownOutputsMap() = default;
+
+    // makes room for no_of_outputs without rehashing
+    void
+    reserve(size_t no_of_outputs);
+
+    // replaces known_output if out_pub_key is already there
+    void
+    insert(public_key const& out_pub_key, known_output_t const& known_output);
+
+    bool
+    find(public_key const& out_pub_key, known_output_t& known_output) const;
+
+    // false if out_pub_key was not there
+    bool
+    erase(public_key const& out_pub_key);
+
+    size_t
+    size() const {return no_of_outputs;}
+
+    bool
+    empty() const {return no_of_outputs == 0;}
+
+    // bytes used by the slots
+    size_t
+    memory_usage() const {return slots.capacity() * sizeof(slot_t);}
+
+    // calls f(out_pub_key, known_output) for each output
+    template <typename F>
+    void
+    for_each(F&& f) const
+    {
+        for (slot_t const& slot: slots)
+            if (slot.out_pub_key != null_pkey)
+                f(slot.out_pub_key, slot.known_output);
+    }
+
+private:
+
+    struct slot_t
+    {
+        public_key out_pub_key;
+        known_output_t known_output;
+    };
+
+    static constexpr size_t MIN_NO_OF_SLOTS {16};
+
+    // slot where probing for out_pub_key starts
+    size_t
+    home_slot(public_key const& out_pub_key) const;
+
+    // index of the slot with out_pub_key, or of the
+    // empty slot where it would be inserted
+    size_t
+    find_slot(public_key const& out_pub_key) const;
+
+    void
+    rehash(size_t no_of_slots);
+
+    // size is zero or a power of two, and at most
+    // three quarters of the slots are used
+    vector<slot_t> slots;
+
+    size_t no_of_outputs {0};
+};
+
+}
+
+#endif //OPENMONERO_KNOWNOUTPUTSMAP_H
@@ -138,6 +138,69 @@ MicroCore::init_success() const
     return initialization_succeded;
 }
 
+namespace
+{
+
+// nesting level of batch reads in the current thread, as
+// stopping the transaction in an inner batch read would
+// also end it for the outer ones.
+thread_local size_t batch_read_depth {0};
+
+}
+
+void
+MicroCore::start_batch_read()
+{
+    if (batch_read_depth++ == 0 && initialization_succeded)
+        core_storage.get_db().block_txn_start(true);
+}
+
+void
+MicroCore::stop_batch_read()
+{
+    if (batch_read_depth == 0)
+        return;
+
+    if (--batch_read_depth == 0 && initialization_succeded)
+        core_storage.get_db().block_txn_stop();
+}
+
+void
+MicroCore::renew_batch_read()
+{
+    if (batch_read_depth == 0 || !initialization_succeded)
+        return;
+
+    core_storage.get_db().block_txn_stop();
+    core_storage.get_db().block_txn_start(true);
+}
+
+BatchRead::BatchRead(MicroCore* _mcore)
+    : mcore {_mcore}
+{
+    if (mcore)
+        mcore->start_batch_read();
+}
+
+BatchRead::BatchRead(BatchRead&& other) noexcept
+    : mcore {other.mcore}
+{
+    other.mcore = nullptr;
+}
+
+void
+BatchRead::renew()
+{
+    if (mcore)
+        mcore->renew_batch_read();
+}
+
+BatchRead::~BatchRead()
+{
+    if (mcore)
+        mcore->stop_batch_read();
+}
+
 MicroCore::~MicroCore()
 {
     //cout << "\n\nMicroCore::~MicroCore()\n\n";
@@ -110,6 +110,20 @@ public:
         return core_storage.get_db().get_output_tx_and_index(amount, index);
     }
 
+    virtual void
+    get_output_tx_and_index(uint64_t const& amount,
+                            vector<uint64_t> const& offsets,
+                            vector<tx_out_index>& indices) const
+    {
+        core_storage.get_db().get_output_tx_and_index(amount, offsets, indices);
+    }
+
+    virtual bool
+    get_tx_blob(crypto::hash const& tx_hash, string& tx_blob) const
+    {
+        return core_storage.get_db().get_tx_blob(tx_hash, tx_blob);
+    }
+
     template<typename... T>
     auto get_tx_block_height(T&&... args) const
     {
@@ -146,6 +160,23 @@ public:
         return core_storage.get_random_outs_for_amounts(req, res);
     }
 
+    /**
+     * Number of outputs of the given amount in each block,
+     * starting from max(from_height, first block which can have
+     * such outputs), returned in start_height.
+     *
+     * base is number of the outputs before the start_height.
+     */
+    virtual bool
+    get_output_distribution(uint64_t amount, uint64_t from_height,
+                            uint64_t& start_height,
+                            std::vector<uint64_t>& distribution,
+                            uint64_t& base) const
+    {
+        return core_storage.get_output_distribution(
+                    amount, from_height, start_height, distribution, base);
+    }
+
     virtual bool
     get_outs(const COMMAND_RPC_GET_OUTPUTS_BIN::request& req,
              COMMAND_RPC_GET_OUTPUTS_BIN::response& res) const
@@ -159,6 +190,12 @@ public:
         return core_storage.get_dynamic_per_kb_fee_estimate(grace_blocks);
     }
 
+    virtual uint64_t
+    get_block_timestamp(uint64_t height) const
+    {
+        return core_storage.get_db().get_block_timestamp(height);
+    }
+
     virtual bool
     get_block_from_height(uint64_t height, block& blk) const;
 
@@ -179,9 +216,67 @@ public:
     virtual bool
     init_success() const;    
 
+    /**
+     * Start read only lmdb transaction used by all
+     * subsequent reads in this thread, until stop_batch_read.
+     *
+     * Otherwise each read starts and stops its own transaction,
+     * which adds up when reading many outputs at once.
+     *
+     * Batch reads can be nested in a thread. Only the outermost
+     * start and stop begin and end the transaction.
+     *
+     * Prefer BatchRead to calling these directly.
+     */
+    virtual void
+    start_batch_read();
+
+    virtual void
+    stop_batch_read();
+
+    /**
+     * Replace the current batch read transaction with a new one,
+     * so that long scans see new blocks, and lmdb can reuse
+     * pages freed since the transaction started.
+     */
+    virtual void
+    renew_batch_read();
+
     virtual ~MicroCore();
 };
 
+
+/**
+ * Keeps a batch read of MicroCore open for its lifetime, e.g.,
+ *
+ *   {
+ *       BatchRead batch_read {mcore};
+ *
+ *       // all reads here use the same lmdb transaction
+ *   }
+ */
+class BatchRead
+{
+public:
+
+    explicit BatchRead(MicroCore* _mcore);
+
+    BatchRead(BatchRead&& other) noexcept;
+
+    BatchRead(BatchRead const&) = delete;
+    BatchRead& operator=(BatchRead const&) = delete;
+    BatchRead& operator=(BatchRead&&) = delete;
+
+    void
+    renew();
+
+    ~BatchRead();
+
+private:
+
+    MicroCore* mcore;
+};
+
 }
 
 
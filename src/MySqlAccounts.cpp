@@ -13,6 +13,29 @@
 namespace xmreg
 {
 
+namespace
+{
+
+// make comma separated list of ids for IN (%0) clauses.
+// ids are numbers, so no escaping is needed.
+string
+make_id_list(const vector<uint64_t>& ids)
+{
+    string id_list;
+
+    for (uint64_t id: ids)
+    {
+        if (!id_list.empty())
+            id_list += ',';
+
+        id_list += std::to_string(id);
+    }
+
+    return id_list;
+}
+
+}
+
 
 MysqlInputs::MysqlInputs(shared_ptr<MySqlConnector> _conn)
         : conn {_conn}
@@ -41,6 +64,62 @@ MysqlInputs::select_for_out(const uint64_t& output_id, vector<XmrInput>& ins)
     return false;
 }
 
+bool
+MysqlInputs::select_for_accounts(const vector<uint64_t>& account_ids,
+                                 vector<XmrInput>& ins)
+{
+    ins.clear();
+
+    if (account_ids.empty())
+        return true;
+
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(XmrInput::SELECT_IN_STMT);
+        query.parse();
+
+        query.storein(ins, make_id_list(account_ids));
+
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+
+bool
+MysqlInputs::select_for_txs(const vector<uint64_t>& tx_ids,
+                            vector<XmrInput>& ins)
+{
+    ins.clear();
+
+    if (tx_ids.empty())
+        return true;
+
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(XmrInput::SELECT_FOR_TXS_IN_STMT);
+        query.parse();
+
+        query.storein(ins, make_id_list(tx_ids));
+
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
 
 MysqlOutpus::MysqlOutpus(shared_ptr<MySqlConnector> _conn): conn {_conn}
 {}
@@ -76,6 +155,34 @@ MysqlOutpus::exist(const string& output_public_key_str, XmrOutput& out)
     return true;
 }
 
+bool
+MysqlOutpus::select_by_ids(const vector<uint64_t>& output_ids,
+                           vector<XmrOutput>& outs)
+{
+    outs.clear();
+
+    if (output_ids.empty())
+        return true;
+
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(XmrOutput::SELECT_IN_STMT);
+        query.parse();
+
+        query.storein(outs, make_id_list(output_ids));
+
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
 
 MysqlTransactions::MysqlTransactions(shared_ptr<MySqlConnector> _conn): conn {_conn}
 {}
@@ -129,6 +236,55 @@ MysqlTransactions::delete_tx(const uint64_t& tx_id_no)
     return 0;
 }
 
+uint64_t
+MysqlTransactions::mark_spendable(const vector<uint64_t>& tx_ids)
+{
+    if (tx_ids.empty())
+        return 0;
+
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(XmrTransaction::MARK_AS_SPENDABLE_IN_STMT);
+        query.parse();
+
+        SimpleResult sr = query.execute(make_id_list(tx_ids));
+
+        return sr.rows();
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return 0;
+}
+
+uint64_t
+MysqlTransactions::delete_txs(const vector<uint64_t>& tx_ids)
+{
+    if (tx_ids.empty())
+        return 0;
+
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(XmrTransaction::DELETE_IN_STMT);
+        query.parse();
+
+        SimpleResult sr = query.execute(make_id_list(tx_ids));
+
+        return sr.rows();
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return 0;
+}
 
 bool
 MysqlTransactions::exist(const uint64_t& account_id, const string& tx_hash_str, XmrTransaction& tx)
@@ -186,6 +342,197 @@ MysqlTransactions::get_total_recieved(const uint64_t& account_id, uint64_t& amou
     return false;
 }
 
+bool
+MysqlTransactions::select_page(const uint64_t& account_id,
+                               const uint64_t& before_id,
+                               const uint64_t& limit,
+                               vector<XmrTransaction>& txs)
+{
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(XmrTransaction::SELECT_PAGE_STMT);
+        query.parse();
+
+        txs.clear();
+        query.storein(txs, account_id, before_id, limit);
+
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+bool
+MysqlTransactions::select_nonspendable(const uint64_t& account_id,
+                                       vector<XmrTransaction>& txs)
+{
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(XmrTransaction::SELECT_NONSPENDABLE_STMT);
+        query.parse();
+
+        txs.clear();
+        query.storein(txs, account_id);
+
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+bool
+MysqlTransactions::get_summary(const uint64_t& account_id,
+                               uint64_t& total_received,
+                               uint64_t& total_received_unlocked)
+{
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(XmrTransaction::SUMMARY_STMT);
+        query.parse();
+
+        StoreQueryResult sqr = query.store(account_id);
+
+        // no row means no txs yet
+        total_received          = 0;
+        total_received_unlocked = 0;
+
+        if (!sqr.empty())
+        {
+            total_received          = sqr.at(0)["total_received"];
+            total_received_unlocked = sqr.at(0)["total_received_unlocked"];
+        }
+
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+bool
+MysqlTransactions::select_nonspendable(const vector<uint64_t>& account_ids,
+                                       vector<XmrTransaction>& txs)
+{
+    txs.clear();
+
+    if (account_ids.empty())
+        return true;
+
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(
+                    XmrTransaction::SELECT_NONSPENDABLE_IN_STMT);
+        query.parse();
+
+        query.storein(txs, make_id_list(account_ids));
+
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+bool
+MysqlTransactions::get_summaries(
+        const vector<uint64_t>& account_ids,
+        unordered_map<uint64_t, XmrTxsSummary>& summaries)
+{
+    summaries.clear();
+
+    if (account_ids.empty())
+        return true;
+
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(XmrTransaction::SUMMARY_IN_STMT);
+        query.parse();
+
+        StoreQueryResult sqr = query.store(make_id_list(account_ids));
+
+        for (auto const& row: sqr)
+        {
+            XmrTxsSummary& summary = summaries[row["account_id"]];
+
+            summary.total_received          = row["total_received"];
+            summary.total_received_unlocked = row["total_received_unlocked"];
+            summary.last_tx_id              = row["last_tx_id"];
+        }
+
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+bool
+MysqlTransactions::select_after(
+        const vector<pair<uint64_t, uint64_t>>& account_cursors,
+        vector<XmrTransaction>& txs)
+{
+    txs.clear();
+
+    if (account_cursors.empty())
+        return true;
+
+    string conditions;
+
+    for (auto const& cursor: account_cursors)
+    {
+        if (!conditions.empty())
+            conditions += " OR ";
+
+        conditions += "(`account_id` = " + std::to_string(cursor.first)
+                      + " AND `id` > " + std::to_string(cursor.second) + ")";
+    }
+
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(XmrTransaction::SELECT_AFTER_STMT);
+        query.parse();
+
+        query.storein(txs, conditions);
+
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
 MysqlPayments::MysqlPayments(shared_ptr<MySqlConnector> _conn): conn {_conn}
 {}
 
@@ -262,6 +609,49 @@ MySqlAccounts::select(const string& address, XmrAccount& account)
     return false;
 }
 
+bool
+MySqlAccounts::select(const vector<string>& addresses,
+                      vector<XmrAccount>& accounts)
+{
+    accounts.clear();
+
+    if (addresses.empty())
+        return true;
+
+    try
+    {
+        conn->check_if_connected();
+
+        Query query = conn->query(XmrAccount::SELECT_IN_STMT);
+        query.parse();
+
+        // addresses come from the frontend, so they must be escaped
+        string address_list;
+
+        for (string const& address: addresses)
+        {
+            string escaped_address;
+            query.escape_string(&escaped_address,
+                                address.data(), address.size());
+
+            if (!address_list.empty())
+                address_list += ',';
+
+            address_list += '\'' + escaped_address + '\'';
+        }
+
+        query.storein(accounts, address_list);
+
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
 template <typename T>
 uint64_t
 MySqlAccounts::insert(const T& data_to_insert)
@@ -469,8 +859,16 @@ bool MySqlAccounts::select_by_primary_id<XmrPayment>(uint64_t id, XmrPayment& se
 
 bool
 MySqlAccounts::select_txs_for_account_spendability_check(
-        const uint64_t& account_id, vector<XmrTransaction>& txs)
+        vector<XmrTransaction>& txs)
+{
+    return select_txs_for_spendability_check(txs);
+}
+
+bool
+MySqlAccounts::select_txs_for_spendability_check(vector<XmrTransaction>& txs)
 {
+    vector<uint64_t> txs_to_mark_spendable;
+    vector<uint64_t> txs_to_delete;
 
     for (auto it = txs.begin(); it != txs.end(); )
     {
@@ -491,13 +889,7 @@ MySqlAccounts::select_txs_for_account_spendability_check(
                 // it is spendable. Meaning, that its older than 10 blocks.
                 // so mark it as spendable in mysql, so that its permanet.
 
-                uint64_t no_row_updated = mark_tx_spendable(tx.id.data);
-
-                if (no_row_updated != 1)
-                {
-                    cerr << "no_row_updated != 1 due to  xmr_accounts->mark_tx_spendable(tx.id)\n";
-                    return false;
-                }
+                txs_to_mark_spendable.push_back(tx.id.data);
 
                 tx.spendable = true;
             }
@@ -518,13 +910,7 @@ MySqlAccounts::select_txs_for_account_spendability_check(
                     // tx does not exist in blockchain, or its blockchain_id changed
                     // for example, it was orhpaned, and then readded.
 
-                    uint64_t no_row_updated = delete_tx(tx.id.data);
-
-                    if (no_row_updated != 1)
-                    {
-                        cerr << "no_row_updated != 1 due to  xmr_accounts->delete_tx(tx.id)\n";
-                        return false;
-                    }
+                    txs_to_delete.push_back(tx.id.data);
 
                     // because txs does not exist in blockchain anymore,
                     // we assume its back to mempool, and it will be rescanned
@@ -552,6 +938,21 @@ MySqlAccounts::select_txs_for_account_spendability_check(
 
     } // for (auto it = txs.begin(); it != txs.end(); )
 
+    if (!txs_to_mark_spendable.empty()
+            && mysql_tx->mark_spendable(txs_to_mark_spendable)
+                    != txs_to_mark_spendable.size())
+    {
+        cerr << "not all rows updated due to mark_spendable(tx_ids)\n";
+        return false;
+    }
+
+    if (!txs_to_delete.empty()
+            && mysql_tx->delete_txs(txs_to_delete) != txs_to_delete.size())
+    {
+        cerr << "not all rows deleted due to delete_txs(tx_ids)\n";
+        return false;
+    }
+
     return true;
 }
 
@@ -605,6 +1006,75 @@ MySqlAccounts::get_total_recieved(const uint64_t& account_id, uint64_t& amount)
     return mysql_tx->get_total_recieved(account_id, amount);
 }
 
+bool
+MySqlAccounts::select_txs_page(const uint64_t& account_id,
+                               const uint64_t& before_id,
+                               const uint64_t& limit,
+                               vector<XmrTransaction>& txs)
+{
+    return mysql_tx->select_page(account_id, before_id, limit, txs);
+}
+
+bool
+MySqlAccounts::select_nonspendable_txs(const uint64_t& account_id,
+                                       vector<XmrTransaction>& txs)
+{
+    return mysql_tx->select_nonspendable(account_id, txs);
+}
+
+bool
+MySqlAccounts::get_txs_summary(const uint64_t& account_id,
+                               uint64_t& total_received,
+                               uint64_t& total_received_unlocked)
+{
+    return mysql_tx->get_summary(account_id, total_received,
+                                 total_received_unlocked);
+}
+
+bool
+MySqlAccounts::select_nonspendable_txs(const vector<uint64_t>& account_ids,
+                                       vector<XmrTransaction>& txs)
+{
+    return mysql_tx->select_nonspendable(account_ids, txs);
+}
+
+bool
+MySqlAccounts::get_txs_summaries(
+        const vector<uint64_t>& account_ids,
+        unordered_map<uint64_t, XmrTxsSummary>& summaries)
+{
+    return mysql_tx->get_summaries(account_ids, summaries);
+}
+
+bool
+MySqlAccounts::select_txs_after(
+        const vector<pair<uint64_t, uint64_t>>& account_cursors,
+        vector<XmrTransaction>& txs)
+{
+    return mysql_tx->select_after(account_cursors, txs);
+}
+
+bool
+MySqlAccounts::select_inputs_for_accounts(const vector<uint64_t>& account_ids,
+                                          vector<XmrInput>& ins)
+{
+    return mysql_in->select_for_accounts(account_ids, ins);
+}
+
+bool
+MySqlAccounts::select_inputs_for_txs(const vector<uint64_t>& tx_ids,
+                                     vector<XmrInput>& ins)
+{
+    return mysql_in->select_for_txs(tx_ids, ins);
+}
+
+bool
+MySqlAccounts::select_outputs_by_ids(const vector<uint64_t>& output_ids,
+                                     vector<XmrOutput>& outs)
+{
+    return mysql_out->select_by_ids(output_ids, outs);
+}
+
 void
 MySqlAccounts::disconnect()
 {
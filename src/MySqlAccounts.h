@@ -12,6 +12,7 @@
 
 #include <iostream>
 #include <memory>
+#include <unordered_map>
 
 
 
@@ -45,6 +46,14 @@ public:
 
     bool
     select_for_out(const uint64_t& output_id, vector<XmrInput>& ins);
+
+    bool
+    select_for_accounts(const vector<uint64_t>& account_ids,
+                        vector<XmrInput>& ins);
+
+    bool
+    select_for_txs(const vector<uint64_t>& tx_ids,
+                   vector<XmrInput>& ins);
 };
 
 
@@ -60,10 +69,22 @@ public:
 
     bool
     exist(const string& output_public_key_str, XmrOutput& out);
+
+    bool
+    select_by_ids(const vector<uint64_t>& output_ids,
+                  vector<XmrOutput>& outs);
 };
 
 
 
+// aggregated values of account's rows in Transactions table
+struct XmrTxsSummary
+{
+    uint64_t total_received {0};
+    uint64_t total_received_unlocked {0};
+    uint64_t last_tx_id {0};
+};
+
 class MysqlTransactions
 {
 
@@ -79,11 +100,42 @@ public:
     uint64_t
     delete_tx(const uint64_t& tx_id_no);
 
+    // batch versions of the above. return number of changed rows
+    uint64_t
+    mark_spendable(const vector<uint64_t>& tx_ids);
+
+    uint64_t
+    delete_txs(const vector<uint64_t>& tx_ids);
+
     bool
     exist(const uint64_t& account_id, const string& tx_hash_str, XmrTransaction& tx);
 
     bool
     get_total_recieved(const uint64_t& account_id, uint64_t& amount);
+
+    bool
+    select_page(const uint64_t& account_id, const uint64_t& before_id,
+                const uint64_t& limit, vector<XmrTransaction>& txs);
+
+    bool
+    select_nonspendable(const uint64_t& account_id, vector<XmrTransaction>& txs);
+
+    bool
+    get_summary(const uint64_t& account_id,
+                uint64_t& total_received,
+                uint64_t& total_received_unlocked);
+
+    bool
+    select_nonspendable(const vector<uint64_t>& account_ids,
+                        vector<XmrTransaction>& txs);
+
+    bool
+    get_summaries(const vector<uint64_t>& account_ids,
+                  unordered_map<uint64_t, XmrTxsSummary>& summaries);
+
+    bool
+    select_after(const vector<pair<uint64_t, uint64_t>>& account_cursors,
+                 vector<XmrTransaction>& txs);
 };
 
 class MysqlPayments
@@ -126,6 +178,15 @@ public:
     bool
     select(const string& address, XmrAccount& account);
 
+    /**
+     * Select accounts for many addresses using single query.
+     *
+     * Addresses which are not in the Accounts table are
+     * simply missing from the result.
+     */
+    bool
+    select(const vector<string>& addresses, vector<XmrAccount>& accounts);
+
     template <typename T>
     uint64_t
     insert(const T& data_to_insert);
@@ -159,8 +220,7 @@ public:
     select_by_primary_id(uint64_t id, T& selected_data);
 
     bool
-    select_txs_for_account_spendability_check(const uint64_t& account_id,
-                                              vector<XmrTransaction>& txs);
+    select_txs_for_account_spendability_check(vector<XmrTransaction>& txs);
 
     bool
     select_inputs_for_out(const uint64_t& output_id, vector<XmrInput>& ins);
@@ -189,6 +249,88 @@ public:
     bool
     get_total_recieved(const uint64_t& account_id, uint64_t& amount);
 
+    /**
+     * Select one page of account's txs, newest first.
+     *
+     * Keyset pagination: only txs with blockchain_tx_id lower
+     * than before_id are returned, so consecutive pages are
+     * fetched by passing blockchain_tx_id of the last tx from
+     * previous page.
+     *
+     * @param account_id
+     * @param before_id  use numeric_limits<uint64_t>::max() for first page
+     * @param limit      max number of txs to return
+     * @param txs
+     * @return true if query was executed without errors
+     */
+    bool
+    select_txs_page(const uint64_t& account_id, const uint64_t& before_id,
+                    const uint64_t& limit, vector<XmrTransaction>& txs);
+
+    bool
+    select_nonspendable_txs(const uint64_t& account_id,
+                            vector<XmrTransaction>& txs);
+
+    /**
+     * Get total received and total received unlocked
+     * for the given account from AccountSummaries table, without
+     * fetching individual rows of the Transactions table.
+     *
+     * Unlocked amount is as good as spendable flags in the
+     * table, so it is best to update them with
+     * select_txs_for_account_spendability_check first.
+     */
+    bool
+    get_txs_summary(const uint64_t& account_id,
+                    uint64_t& total_received,
+                    uint64_t& total_received_unlocked);
+
+    // batch versions of the above methods. Each of them executes
+    // only one query, no matter how many accounts are given.
+    // Used by get_addresses_info request.
+
+    bool
+    select_nonspendable_txs(const vector<uint64_t>& account_ids,
+                            vector<XmrTransaction>& txs);
+
+    /**
+     * Same as select_txs_for_account_spendability_check, but
+     * txs can be of many accounts, and all txs which became
+     * spendable or were orphaned are updated with
+     * two queries in total.
+     */
+    bool
+    select_txs_for_spendability_check(vector<XmrTransaction>& txs);
+
+    bool
+    get_txs_summaries(const vector<uint64_t>& account_ids,
+                      unordered_map<uint64_t, XmrTxsSummary>& summaries);
+
+    /**
+     * Select txs newer than given cursors, oldest first.
+     *
+     * @param account_cursors pairs of account_id and
+     *        primary id of the last tx already known for the account
+     * @param txs
+     * @return true if query was executed without errors
+     */
+    bool
+    select_txs_after(const vector<pair<uint64_t, uint64_t>>& account_cursors,
+                     vector<XmrTransaction>& txs);
+
+    bool
+    select_inputs_for_accounts(const vector<uint64_t>& account_ids,
+                               vector<XmrInput>& ins);
+
+    // inputs of many txs at once, e.g., of a page of txs
+    bool
+    select_inputs_for_txs(const vector<uint64_t>& tx_ids,
+                          vector<XmrInput>& ins);
+
+    bool
+    select_outputs_by_ids(const vector<uint64_t>& output_ids,
+                          vector<XmrOutput>& outs);
+
     void
     disconnect();
 
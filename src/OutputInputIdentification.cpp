@@ -14,14 +14,23 @@ OutputInputIdentification::OutputInputIdentification(
     const transaction* _tx,
     crypto::hash const& _tx_hash,
     bool is_coinbase,
-    std::shared_ptr<CurrentBlockchainStatus> _current_bc_status)
+    std::shared_ptr<CurrentBlockchainStatus> _current_bc_status,
+    PrecomputedTxPubKey const* precomputed_tx_pub_key,
+    SubaddressTable const* _subaddresses,
+    tx_extra_info const* _extra_info)
     : total_received {0}, mixin_no {0}, current_bc_status {_current_bc_status}
 {
     address_info = _a;
     viewkey = _v;
     tx = _tx;
+    subaddresses = _subaddresses;
 
-    tx_pub_key  = xmreg::get_tx_pub_key_from_received_outs(*tx);
+    given_extra_info = _extra_info;
+
+    if (given_extra_info == nullptr)
+        parsed_extra_info = xmreg::parse_tx_extra_info(tx->extra);
+
+    tx_pub_key  = get_extra_info().tx_pub_key;
 
     tx_is_coinbase = is_coinbase;
     tx_hash = _tx_hash;
@@ -34,7 +43,18 @@ OutputInputIdentification::OutputInputIdentification(
     }
 
 
-    if (!generate_key_derivation(tx_pub_key, *viewkey, derivation))
+    bool const use_precomputed
+            = precomputed_tx_pub_key != nullptr
+              && precomputed_tx_pub_key->is_initialized()
+              && precomputed_tx_pub_key->get_tx_pub_key() == tx_pub_key;
+
+    bool const derivation_generated
+            = use_precomputed
+              ? precomputed_tx_pub_key->generate_key_derivation(*viewkey,
+                                                               derivation)
+              : generate_key_derivation(tx_pub_key, *viewkey, derivation);
+
+    if (!derivation_generated)
     {
         cerr << "Cant get derived key for: "  << "\n"
              << "pub_tx_key: " << get_tx_pub_key_str() << " and "
@@ -45,6 +65,42 @@ OutputInputIdentification::OutputInputIdentification(
 
 }
 
+bool
+OutputInputIdentification::is_output_mine(
+        public_key const& out_key,
+        key_derivation const& out_derivation,
+        uint64_t output_idx_in_tx,
+        subaddress_index& subaddr_index) const
+{
+    if (subaddresses == nullptr)
+    {
+        // get the tx output public key
+        // that normally would be generated for us,
+        // if someone had sent us some xmr.
+        public_key generated_tx_pubkey;
+
+        derive_public_key(out_derivation,
+                          output_idx_in_tx,
+                          address_info->address.m_spend_public_key,
+                          generated_tx_pubkey);
+
+        subaddr_index = {0, 0};
+
+        // check if generated public key matches the current output's key
+        return out_key == generated_tx_pubkey;
+    }
+
+    // spend public key of the subaddress this output
+    // would be sent to, if it was ours
+    public_key spend_public_key;
+
+    if (!derive_subaddress_public_key(out_key, out_derivation,
+                                      output_idx_in_tx, spend_public_key))
+        return false;
+
+    return subaddresses->find(spend_public_key, subaddr_index);
+}
+
 uint64_t
 OutputInputIdentification::get_mixin_no()
 {
@@ -57,27 +113,55 @@ OutputInputIdentification::get_mixin_no()
 void
 OutputInputIdentification::identify_outputs()
 {
-    //          <public_key  , amount  , out idx>
-    vector<tuple<txout_to_key, uint64_t, uint64_t>> outputs = get_ouputs_tuple(*tx);
+    // txs to subaddresses can have a pub key for each output,
+    // in addition to the main one
+    vector<public_key> const& additional_tx_pub_keys
+            = get_extra_info().additional_tx_pub_keys;
+
+    vector<key_derivation> additional_derivations;
 
-    for (auto& out: outputs)
+    if (additional_tx_pub_keys.size() == tx->vout.size())
     {
-        txout_to_key const& txout_k = std::get<0>(out);
-        uint64_t amount             = std::get<1>(out);
-        uint64_t output_idx_in_tx   = std::get<2>(out);
+        additional_derivations.resize(additional_tx_pub_keys.size());
 
-        // get the tx output public key
-        // that normally would be generated for us,
-        // if someone had sent us some xmr.
-        public_key generated_tx_pubkey;
+        for (size_t i = 0; i < additional_tx_pub_keys.size(); ++i)
+        {
+            if (!generate_key_derivation(additional_tx_pub_keys[i],
+                                         *viewkey,
+                                         additional_derivations[i]))
+            {
+                cerr << "Cant get derived key for additional pub key "
+                     << pod_to_hex(additional_tx_pub_keys[i]) << endl;
 
-        derive_public_key(derivation,
-                          output_idx_in_tx,
-                          address_info->address.m_spend_public_key,
-                          generated_tx_pubkey);
+                throw OutputInputIdentificationException(
+                        "Cant get derived key for additional tx pub key");
+            }
+        }
+    }
 
-        // check if generated public key matches the current output's key
-        bool mine_output = (txout_k.key == generated_tx_pubkey);
+    for (output_to_key_ref const& out: outputs_to_key(*tx))
+    {
+        txout_to_key const& txout_k = out.txout_k;
+        uint64_t amount             = out.amount;
+        uint64_t output_idx_in_tx   = out.idx_in_tx;
+
+        // derivation and pub key used for this output
+        key_derivation const* out_derivation = &derivation;
+        public_key const* out_tx_pub_key     = &tx_pub_key;
+
+        subaddress_index subaddr_index {0, 0};
+
+        bool mine_output = is_output_mine(txout_k.key, derivation,
+                                          output_idx_in_tx, subaddr_index);
+
+        if (!mine_output && output_idx_in_tx < additional_derivations.size())
+        {
+            out_derivation = &additional_derivations[output_idx_in_tx];
+            out_tx_pub_key = &additional_tx_pub_keys[output_idx_in_tx];
+
+            mine_output = is_output_mine(txout_k.key, *out_derivation,
+                                         output_idx_in_tx, subaddr_index);
+        }
 
         // placeholder variable for ringct outputs info
         // that we need to save in database
@@ -112,8 +196,7 @@ OutputInputIdentification::identify_outputs()
                 rct::key mask =  tx->rct_signatures.ecdhInfo[output_idx_in_tx].mask;
 
                 r = decode_ringct(tx->rct_signatures,
-                                  tx_pub_key,
-                                  *viewkey,
+                                  *out_derivation,
                                   output_idx_in_tx,
                                   mask,
                                   rct_amount_val);
@@ -137,38 +220,77 @@ OutputInputIdentification::identify_outputs()
             identified_outputs.emplace_back(
                     output_info{
                             txout_k.key, amount, output_idx_in_tx,
-                            rtc_outpk, rtc_mask, rtc_amount
+                            rtc_outpk, rtc_mask, rtc_amount,
+                            *out_tx_pub_key, subaddr_index
                     });
 
         } //  if (mine_output)
 
-    } // for (const auto& out: outputs)
+    } // for (output_to_key_ref const& out: outputs_to_key(*tx))
 
 }
 
 
 void
 OutputInputIdentification::identify_inputs(
-        unordered_map<public_key, uint64_t> const& known_outputs_keys)
+        KnownOutputsIndex const& known_outputs_index,
+        uint64_t account_id,
+        CurrentBlockchainStatus::ring_members_t const* ring_members)
 {
-    vector<txin_to_key> input_key_imgs = xmreg::get_key_images(*tx);
+    identify_inputs_with(
+            [&known_outputs_index, account_id](public_key const& out_pub_key,
+                                               input_info& in_info)
+            {
+                KnownOutputsIndex::known_output_t known_output;
+
+                if (!known_outputs_index.find(out_pub_key, known_output)
+                        || known_output.account_id != account_id)
+                    return false;
 
+                in_info.amount     = known_output.amount;
+                in_info.account_id = known_output.account_id;
+                in_info.output_id  = known_output.output_id;
+
+                return true;
+            },
+            ring_members);
+}
+
+template <typename KnownOutputLookup>
+void
+OutputInputIdentification::identify_inputs_with(
+        KnownOutputLookup&& find_known_output,
+        CurrentBlockchainStatus::ring_members_t const* ring_members)
+{
     size_t search_misses {0};
 
+    // reused for all inputs, so that they are allocated
+    // only once per tx
+    std::vector<uint64_t> absolute_offsets;
+
+    // public keys of outputs used in the mixins that match to the offests
+    std::vector<cryptonote::output_data_t> mixin_outputs;
+
     // make timescale maps for mixins in input
-    for (txin_to_key const& in_key: input_key_imgs)
+    for (txin_to_key const& in_key: inputs_to_key(*tx))
     {
         // get absolute offsets of mixins
-        std::vector<uint64_t> absolute_offsets
-                = cryptonote::relative_output_offsets_to_absolute(
-                        in_key.key_offsets);
-
-        // get public keys of outputs used in the mixins that match to the offests
-        std::vector<cryptonote::output_data_t> mixin_outputs;
-
-        if (!current_bc_status->get_output_keys(in_key.amount,
-                                                absolute_offsets,
-                                                mixin_outputs))
+        absolute_offsets.assign(in_key.key_offsets.begin(),
+                                in_key.key_offsets.end());
+
+        std::partial_sum(absolute_offsets.begin(),
+                         absolute_offsets.end(),
+                         absolute_offsets.begin());
+
+        bool const found_in_ring_members
+                = ring_members != nullptr
+                  && find_ring_members(*ring_members, in_key.amount,
+                                       absolute_offsets, mixin_outputs);
+
+        if (!found_in_ring_members
+                && !current_bc_status->get_output_keys(in_key.amount,
+                                                       absolute_offsets,
+                                                       mixin_outputs))
         {
             cerr << "Mixins key images not found" << endl;
             continue;
@@ -184,7 +306,7 @@ OutputInputIdentification::identify_inputs(
         for (const uint64_t& abs_offset: absolute_offsets)
         {
             // get basic information about mixn's output
-            cryptonote::output_data_t output_data = mixin_outputs[count];
+            cryptonote::output_data_t const& output_data = mixin_outputs[count];
 
             //cout << " - output_public_key_str: " << output_public_key_str << endl;
 
@@ -192,17 +314,17 @@ OutputInputIdentification::identify_inputs(
             // if the key exists. Its much faster than going to mysql
             // for this.
 
-            auto it = known_outputs_keys.find(output_data.pubkey);
+            input_info in_info {};
 
-            if (it != known_outputs_keys.end())
+            if (find_known_output(output_data.pubkey, in_info))
             {
                 // this seems to be our mixin.
                 // save it into identified_inputs vector
 
-                identified_inputs.push_back(input_info {
-                        pod_to_hex(in_key.k_image),
-                        it->second, // amount
-                        output_data.pubkey});
+                in_info.key_img     = pod_to_hex(in_key.k_image);
+                in_info.out_pub_key = output_data.pubkey;
+
+                identified_inputs.push_back(std::move(in_info));
 
                 found_a_match = true;
 
@@ -228,11 +350,34 @@ OutputInputIdentification::identify_inputs(
                 break;
         }
 
-    } // for (const txin_to_key& in_key: input_key_imgs)
+    } // for (txin_to_key const& in_key: inputs_to_key(*tx))
 
 }
 
 
+bool
+OutputInputIdentification::find_ring_members(
+        CurrentBlockchainStatus::ring_members_t const& ring_members,
+        uint64_t amount,
+        vector<uint64_t> const& absolute_offsets,
+        vector<cryptonote::output_data_t>& mixin_outputs) const
+{
+    mixin_outputs.clear();
+    mixin_outputs.reserve(absolute_offsets.size());
+
+    for (uint64_t abs_offset: absolute_offsets)
+    {
+        auto it = ring_members.find({amount, abs_offset});
+
+        if (it == ring_members.end())
+            return false;
+
+        mixin_outputs.push_back(it->second);
+    }
+
+    return true;
+}
+
 string const&
 OutputInputIdentification::get_tx_hash_str()
 {
@@ -264,4 +409,20 @@ OutputInputIdentification::get_tx_pub_key_str()
     return tx_pub_key_str;
 }
 
+string const&
+OutputInputIdentification::get_payment_id_str()
+{
+    if (payment_id_str.empty())
+        payment_id_str = get_extra_info().get_payment_id_str();
+
+    return payment_id_str;
+}
+
+tx_extra_info const&
+OutputInputIdentification::get_extra_info() const
+{
+    return given_extra_info != nullptr ? *given_extra_info
+                                       : parsed_extra_info;
+}
+
 }
@@ -6,9 +6,13 @@
 #define RESTBED_XMR_OUTPUTINPUTIDENTIFICATION_H
 
 #include "CurrentBlockchainStatus.h"
+#include "KnownOutputsIndex.h"
+#include "PrecomputedTxPubKey.h"
+#include "SubaddressTable.h"
 #include "tools.h"
 
 #include <map>
+#include <numeric>
 #include <utility>
 
 namespace xmreg
@@ -61,6 +65,12 @@ public:
         string     rtc_outpk;
         string     rtc_mask;
         string     rtc_amount;
+
+        // tx pub key for this output. its either main pub key
+        // of the tx, or its additional pub key for this output.
+        public_key tx_pub_key;
+
+        subaddress_index subaddr_index;
     };
 
     // define a structure to keep information about found
@@ -70,6 +80,11 @@ public:
         string key_img;
         uint64_t amount;
         public_key out_pub_key;
+
+        // only known when identified using KnownOutputsIndex.
+        // output_id can be 0 also then, for newly found outputs.
+        uint64_t account_id;
+        uint64_t output_id;
     };
 
     crypto::hash tx_hash;
@@ -79,6 +94,7 @@ public:
     string tx_hash_str;
     string tx_prefix_hash_str;
     string tx_pub_key_str;
+    string payment_id_str;
 
     bool tx_is_coinbase;
 
@@ -102,16 +118,32 @@ public:
 
     std::shared_ptr<CurrentBlockchainStatus> current_bc_status;
 
+    // precomputed_tx_pub_key is optional. When given for the
+    // tx's pub key, it is used to generate the derivation.
+    //
+    // subaddresses are optional too. Without them, only outputs
+    // to the main address are identified.
+    //
+    // _extra_info is tx_extra of the tx already parsed, e.g.,
+    // by get_txs_in_blocks. If not given, it is parsed here.
+    // Given one must outlive this object.
     OutputInputIdentification(const address_parse_info* _a,
                               const secret_key* _v,
                               const transaction* _tx,
                               crypto::hash const& _tx_hash,
                               bool is_coinbase,
-                              std::shared_ptr<CurrentBlockchainStatus> _current_bc_status);
+                              std::shared_ptr<CurrentBlockchainStatus> _current_bc_status,
+                              PrecomputedTxPubKey const* precomputed_tx_pub_key
+                                = nullptr,
+                              SubaddressTable const* _subaddresses = nullptr,
+                              tx_extra_info const* _extra_info = nullptr);
 
     /**
      * FIRST step. search for the incoming xmr using address, viewkey and
      * outputs public keys.
+     *
+     * Outputs are checked against derivations of the tx pub key and,
+     * if the tx has them, of its additional pub keys.
      */
     void
     identify_outputs();
@@ -123,19 +155,24 @@ public:
      * our known output keys. If a metch is found, we assume
      * that associated input is ours
      *
-     * The known_outputs_keys parameter is optional. But when we have
-     * it, the identification is faster as we just check mixins public keys
-     * if they are in known_outputs_keys.
+     * Known output keys of the account are looked up in the index
+     * of all accounts' outputs, so we just check if mixins public
+     * keys are there, with the given account_id.
      *
-     * searching without known_outputs_keys is not implemented yet here
+     * searching without known output keys is not implemented yet here
      * but it was done for the onion explorer. so later basically just
      * copy and past here.
      *
-     * known_outputs_keys is pair of <output public key, output amount>
+     * ring_members are optional ring members resolved in advance for
+     * many txs (see CurrentBlockchainStatus::get_ring_members). Rings
+     * not found there are read using get_output_keys.
      *
      */
     void
-    identify_inputs(unordered_map<public_key, uint64_t> const& known_outputs_keys);
+    identify_inputs(KnownOutputsIndex const& known_outputs_index,
+                    uint64_t account_id,
+                    CurrentBlockchainStatus::ring_members_t const* ring_members
+                        = nullptr);
 
     string const&
     get_tx_hash_str();
@@ -146,18 +183,55 @@ public:
     string const&
     get_tx_pub_key_str();
 
+    // empty if the tx has no payment id
+    string const&
+    get_payment_id_str();
+
     uint64_t
     get_mixin_no();
 
+    tx_extra_info const&
+    get_extra_info() const;
+
 private:
 
+    // find_known_output(out_pub_key, in_info) says whether the ring
+    // member is a known output, and fills in_info with its data.
+    template <typename KnownOutputLookup>
+    void
+    identify_inputs_with(KnownOutputLookup&& find_known_output,
+                         CurrentBlockchainStatus::ring_members_t const* ring_members);
+
+    // checks output's key against the main address or, if given,
+    // all the subaddresses, for the given derivation
+    bool
+    is_output_mine(public_key const& out_key,
+                   key_derivation const& out_derivation,
+                   uint64_t output_idx_in_tx,
+                   subaddress_index& subaddr_index) const;
+
+    // takes mixin_outputs from ring_members, if all of them are there
+    bool
+    find_ring_members(CurrentBlockchainStatus::ring_members_t const& ring_members,
+                      uint64_t amount,
+                      vector<uint64_t> const& absolute_offsets,
+                      vector<cryptonote::output_data_t>& mixin_outputs) const;
+
     // address and viewkey for this search thread.
     const address_parse_info* address_info;
     const secret_key* viewkey;
 
+    // subaddresses of the address, can be null
+    SubaddressTable const* subaddresses;
+
     // transaction that is beeing search
     const transaction* tx;
 
+    // tx_extra of the tx, given to the constructor, or
+    // if not given, parsed by it
+    tx_extra_info const* given_extra_info;
+    tx_extra_info parsed_extra_info;
+
 };
 
 }
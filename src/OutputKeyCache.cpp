@@ -0,0 +1,113 @@
+#include "OutputKeyCache.h"
+
+namespace xmreg
+{
+
+constexpr size_t OutputKeyCache::NO_OF_SHARDS;
+
+OutputKeyCache::OutputKeyCache(size_t capacity)
+    : shard_capacity {std::max<size_t>(1, capacity / NO_OF_SHARDS)}
+{}
+
+bool
+OutputKeyCache::get(uint64_t amount, uint64_t global_amount_index,
+                    output_data_t& output_data)
+{
+    key_t const key {amount, global_amount_index};
+
+    Shard& shard = get_shard(key);
+
+    std::lock_guard<std::mutex> lck (shard.mtx);
+
+    auto it = shard.outputs.find(key);
+
+    if (it == shard.outputs.end())
+    {
+        ++no_of_misses;
+        return false;
+    }
+
+    // move to the front, as most recently used
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+
+    output_data = it->second->second;
+
+    ++no_of_hits;
+
+    return true;
+}
+
+void
+OutputKeyCache::put(uint64_t amount, uint64_t global_amount_index,
+                    output_data_t const& output_data)
+{
+    key_t const key {amount, global_amount_index};
+
+    Shard& shard = get_shard(key);
+
+    std::lock_guard<std::mutex> lck (shard.mtx);
+
+    auto it = shard.outputs.find(key);
+
+    if (it != shard.outputs.end())
+    {
+        it->second->second = output_data;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+
+    if (shard.outputs.size() >= shard_capacity)
+    {
+        // evict least recently used
+        shard.outputs.erase(shard.lru.back().first);
+        shard.lru.pop_back();
+    }
+
+    shard.lru.emplace_front(key, output_data);
+    shard.outputs.emplace(key, shard.lru.begin());
+}
+
+size_t
+OutputKeyCache::size() const
+{
+    size_t total {0};
+
+    for (Shard const& shard: shards)
+    {
+        std::lock_guard<std::mutex> lck (shard.mtx);
+        total += shard.outputs.size();
+    }
+
+    return total;
+}
+
+double
+OutputKeyCache::get_hit_rate() const
+{
+    uint64_t const hits = no_of_hits;
+    uint64_t const lookups = hits + no_of_misses;
+
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+}
+
+void
+OutputKeyCache::clear()
+{
+    for (Shard& shard: shards)
+    {
+        std::lock_guard<std::mutex> lck (shard.mtx);
+        shard.outputs.clear();
+        shard.lru.clear();
+    }
+
+    no_of_hits = 0;
+    no_of_misses = 0;
+}
+
+OutputKeyCache::Shard&
+OutputKeyCache::get_shard(key_t const& key)
+{
+    return shards[key_hash{}(key) % NO_OF_SHARDS];
+}
+
+}
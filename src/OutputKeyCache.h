@@ -0,0 +1,108 @@
+#ifndef OPENMONERO_OUTPUTKEYCACHE_H
+#define OPENMONERO_OUTPUTKEYCACHE_H
+
+#include "monero_headers.h"
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace xmreg
+{
+
+using namespace cryptonote;
+using namespace std;
+
+/**
+ * LRU cache of outputs' data read from lmdb, keyed
+ * by amount and global amount index.
+ *
+ * Ring members of popular outputs are read over and over
+ * by search threads of different accounts and by
+ * get_random_outs. The cache is split into shards, each
+ * with its own lock, so that concurrent threads rarely
+ * wait for each other.
+ *
+ * It does not know anything about reorgs. So only outputs
+ * which can't be reorganized anymore should be put into it.
+ */
+class OutputKeyCache
+{
+public:
+
+    //                    amount  , global_amount_index
+    using key_t = std::pair<uint64_t, uint64_t>;
+
+    static constexpr size_t NO_OF_SHARDS {16};
+
+    // capacity is max number of outputs in the whole cache
+    explicit OutputKeyCache(size_t capacity);
+
+    bool
+    get(uint64_t amount, uint64_t global_amount_index,
+        output_data_t& output_data);
+
+    void
+    put(uint64_t amount, uint64_t global_amount_index,
+        output_data_t const& output_data);
+
+    size_t
+    size() const;
+
+    uint64_t
+    get_no_of_hits() const {return no_of_hits;}
+
+    uint64_t
+    get_no_of_misses() const {return no_of_misses;}
+
+    // fraction of get calls which found the output, or 0
+    // if there were no calls yet
+    double
+    get_hit_rate() const;
+
+    void
+    clear();
+
+private:
+
+    struct key_hash
+    {
+        size_t
+        operator()(key_t const& key) const
+        {
+            // global indices of the same amount are consecutive,
+            // so they are spread well across buckets as they are
+            return std::hash<uint64_t>{}(key.second)
+                    ^ (std::hash<uint64_t>{}(key.first) << 1);
+        }
+    };
+
+    using lru_list_t = std::list<std::pair<key_t, output_data_t>>;
+
+    struct Shard
+    {
+        mutable mutex mtx;
+
+        // most recently used first
+        lru_list_t lru;
+
+        unordered_map<key_t, lru_list_t::iterator, key_hash> outputs;
+    };
+
+    Shard&
+    get_shard(key_t const& key);
+
+    size_t shard_capacity;
+
+    std::array<Shard, NO_OF_SHARDS> shards;
+
+    atomic<uint64_t> no_of_hits {0};
+    atomic<uint64_t> no_of_misses {0};
+};
+
+}
+
+#endif //OPENMONERO_OUTPUTKEYCACHE_H
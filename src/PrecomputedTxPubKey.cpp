@@ -0,0 +1,194 @@
+#include "PrecomputedTxPubKey.h"
+
+namespace xmreg
+{
+
+namespace
+{
+
+// helpers of ge_scalarmult, which are static in crypto-ops.c.
+// all of them are branch free, as they handle the viewkey.
+
+// 1 if b == c, 0 otherwise
+unsigned char
+equal(signed char b, signed char c)
+{
+    unsigned char const x = static_cast<unsigned char>(b)
+                            ^ static_cast<unsigned char>(c);
+    uint32_t y = x;
+    y -= 1;
+    y >>= 31;
+    return static_cast<unsigned char>(y);
+}
+
+// 1 if b < 0, 0 otherwise
+unsigned char
+negative(signed char b)
+{
+    unsigned long long x = b;
+    x >>= 63;
+    return static_cast<unsigned char>(x);
+}
+
+// f = g if b == 1, f unchanged if b == 0
+void
+fe_cmov(fe f, fe const g, unsigned char b)
+{
+    int32_t const mask = -static_cast<int32_t>(b);
+
+    for (size_t i = 0; i < 10; ++i)
+        f[i] ^= (f[i] ^ g[i]) & mask;
+}
+
+void
+ge_cached_cmov(ge_cached& t, ge_cached const& u, unsigned char b)
+{
+    fe_cmov(t.YplusX, u.YplusX, b);
+    fe_cmov(t.YminusX, u.YminusX, b);
+    fe_cmov(t.Z, u.Z, b);
+    fe_cmov(t.T2d, u.T2d, b);
+}
+
+// identity point
+void
+ge_cached_0(ge_cached& t)
+{
+    for (size_t i = 0; i < 10; ++i)
+    {
+        t.YplusX[i]  = i == 0;
+        t.YminusX[i] = i == 0;
+        t.Z[i]       = i == 0;
+        t.T2d[i]     = 0;
+    }
+}
+
+void
+ge_p2_0(ge_p2& r)
+{
+    for (size_t i = 0; i < 10; ++i)
+    {
+        r.X[i] = 0;
+        r.Y[i] = i == 0;
+        r.Z[i] = i == 0;
+    }
+}
+
+// -t
+void
+ge_cached_neg(ge_cached& r, ge_cached const& t)
+{
+    for (size_t i = 0; i < 10; ++i)
+    {
+        r.YplusX[i]  = t.YminusX[i];
+        r.YminusX[i] = t.YplusX[i];
+        r.Z[i]       = t.Z[i];
+        r.T2d[i]     = -t.T2d[i];
+    }
+}
+
+}
+
+bool
+PrecomputedTxPubKey::init(public_key const& _tx_pub_key)
+{
+    initialized = false;
+
+    tx_pub_key = _tx_pub_key;
+
+    if (ge_frombytes_vartime(&point,
+            reinterpret_cast<unsigned char const*>(tx_pub_key.data)) != 0)
+        return false;
+
+    ge_p1p1 t;
+    ge_p3 u;
+
+    ge_p3_to_cached(&multiples[0], &point);
+
+    for (size_t i = 0; i < 7; ++i)
+    {
+        ge_add(&t, &point, &multiples[i]);
+        ge_p1p1_to_p3(&u, &t);
+        ge_p3_to_cached(&multiples[i + 1], &u);
+    }
+
+    initialized = true;
+
+    return true;
+}
+
+bool
+PrecomputedTxPubKey::generate_key_derivation(
+        secret_key const& viewkey,
+        key_derivation& derivation) const
+{
+    if (!initialized)
+        return false;
+
+    unsigned char const* a
+            = reinterpret_cast<unsigned char const*>(viewkey.data);
+
+    // viewkey in radix 16, with digits from -8 to 8,
+    // as in ge_scalarmult
+    signed char e[64];
+
+    int carry {0};
+    int carry2;
+
+    for (size_t i = 0; i < 31; ++i)
+    {
+        carry += a[i];
+        carry2 = (carry + 8) >> 4;
+        e[2 * i] = carry - (carry2 << 4);
+        carry = (carry2 + 8) >> 4;
+        e[2 * i + 1] = carry2 - (carry << 4);
+    }
+
+    carry += a[31];
+    carry2 = (carry + 8) >> 4;
+    e[62] = carry - (carry2 << 4);
+    e[63] = carry2;
+
+    ge_p2 r;
+    ge_p1p1 t;
+    ge_p3 u;
+
+    ge_p2_0(r);
+
+    for (int i = 63; i >= 0; --i)
+    {
+        signed char const b = e[i];
+        unsigned char const bnegative = negative(b);
+        unsigned char const babs = b - (((-bnegative) & b) << 1);
+
+        ge_p2_dbl(&t, &r);
+        ge_p1p1_to_p2(&r, &t);
+        ge_p2_dbl(&t, &r);
+        ge_p1p1_to_p2(&r, &t);
+        ge_p2_dbl(&t, &r);
+        ge_p1p1_to_p2(&r, &t);
+        ge_p2_dbl(&t, &r);
+        ge_p1p1_to_p3(&u, &t);
+
+        ge_cached cur;
+        ge_cached minuscur;
+
+        ge_cached_0(cur);
+
+        for (size_t j = 0; j < 8; ++j)
+            ge_cached_cmov(cur, multiples[j], equal(babs, static_cast<signed char>(j + 1)));
+
+        ge_cached_neg(minuscur, cur);
+        ge_cached_cmov(cur, minuscur, bnegative);
+
+        ge_add(&t, &u, &cur);
+        ge_p1p1_to_p2(&r, &t);
+    }
+
+    ge_mul8(&t, &r);
+    ge_p1p1_to_p2(&r, &t);
+    ge_tobytes(reinterpret_cast<unsigned char*>(derivation.data), &r);
+
+    return true;
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef OPENMONERO_PRECOMPUTEDTXPUBKEY_H
+#define OPENMONERO_PRECOMPUTEDTXPUBKEY_H
+
+#include "monero_headers.h"
+
+namespace xmreg
+{
+
+using namespace cryptonote;
+using namespace crypto;
+using namespace std;
+
+/**
+ * Tx public key R kept decompressed, with its multiples
+ * 1*R, ..., 8*R.
+ *
+ * generate_key_derivation(R, viewkey) decompresses R and
+ * builds this table on each call, in ge_scalarmult. When
+ * search threads of many accounts scan the same tx, this is
+ * done once per tx instead.
+ *
+ * viewkey * R is computed as in monero's ge_scalarmult, i.e.,
+ * in constant time, as the viewkey is secret. Only the table
+ * comes from here.
+ */
+class PrecomputedTxPubKey
+{
+public:
+
+    // false if tx_pub_key is not a valid point
+    bool
+    init(public_key const& tx_pub_key);
+
+    bool
+    is_initialized() const {return initialized;}
+
+    public_key const&
+    get_tx_pub_key() const {return tx_pub_key;}
+
+    // same result as crypto::generate_key_derivation(tx_pub_key,
+    // viewkey, derivation)
+    bool
+    generate_key_derivation(secret_key const& viewkey,
+                            key_derivation& derivation) const;
+
+private:
+
+    public_key tx_pub_key;
+
+    // decompressed tx_pub_key
+    ge_p3 point;
+
+    // 1*point, 2*point, ..., 8*point
+    ge_cached multiples[8];
+
+    bool initialized {false};
+};
+
+}
+
+#endif //OPENMONERO_PRECOMPUTEDTXPUBKEY_H
@@ -0,0 +1,701 @@
+#include "ResponseWriter.h"
+
+#include "tools.h"
+
+#include <stdexcept>
+#include <unordered_set>
+#include <cstring>
+
+namespace xmreg
+{
+
+constexpr size_t ResponseWriter::MAX_RETAINED_CAPACITY;
+constexpr size_t ResponseWriter::MAX_DEPTH;
+
+namespace
+{
+
+string&
+thread_buffer()
+{
+    static thread_local string buffer;
+    return buffer;
+}
+
+// CBOR major types
+constexpr uint8_t CBOR_UNSIGNED {0};
+constexpr uint8_t CBOR_NEGATIVE {1};
+constexpr uint8_t CBOR_BYTES    {2};
+constexpr uint8_t CBOR_TEXT     {3};
+constexpr uint8_t CBOR_ARRAY    {4};
+constexpr uint8_t CBOR_MAP      {5};
+
+// CBOR additional info saying how many bytes the argument
+// following the initial byte has
+constexpr uint8_t CBOR_ARG_1_BYTE  {24};
+constexpr uint8_t CBOR_ARG_2_BYTES {25};
+constexpr uint8_t CBOR_ARG_4_BYTES {26};
+constexpr uint8_t CBOR_ARG_8_BYTES {27};
+
+// CBOR simple values and other single byte items
+constexpr uint8_t CBOR_FALSE            {0xf4};
+constexpr uint8_t CBOR_TRUE             {0xf5};
+constexpr uint8_t CBOR_NULL             {0xf6};
+constexpr uint8_t CBOR_FLOAT64          {0xfb};
+constexpr uint8_t CBOR_BREAK            {0xff};
+constexpr uint8_t CBOR_ARRAY_INDEFINITE {0x9f};
+constexpr uint8_t CBOR_MAP_INDEFINITE   {0xbf};
+
+// MessagePack formats. fix ones have their value or size
+// in low bits of the byte.
+constexpr uint8_t MSGPACK_FIXMAP    {0x80};
+constexpr uint8_t MSGPACK_FIXARRAY  {0x90};
+constexpr uint8_t MSGPACK_FIXSTR    {0xa0};
+constexpr uint8_t MSGPACK_NIL       {0xc0};
+constexpr uint8_t MSGPACK_FALSE     {0xc2};
+constexpr uint8_t MSGPACK_TRUE      {0xc3};
+constexpr uint8_t MSGPACK_BIN8      {0xc4};
+constexpr uint8_t MSGPACK_BIN16     {0xc5};
+constexpr uint8_t MSGPACK_BIN32     {0xc6};
+constexpr uint8_t MSGPACK_FLOAT64   {0xcb};
+constexpr uint8_t MSGPACK_UINT8     {0xcc};
+constexpr uint8_t MSGPACK_UINT16    {0xcd};
+constexpr uint8_t MSGPACK_UINT32    {0xce};
+constexpr uint8_t MSGPACK_UINT64    {0xcf};
+constexpr uint8_t MSGPACK_INT8      {0xd0};
+constexpr uint8_t MSGPACK_INT16     {0xd1};
+constexpr uint8_t MSGPACK_INT32     {0xd2};
+constexpr uint8_t MSGPACK_INT64     {0xd3};
+constexpr uint8_t MSGPACK_STR8      {0xd9};
+constexpr uint8_t MSGPACK_STR16     {0xda};
+constexpr uint8_t MSGPACK_STR32     {0xdb};
+constexpr uint8_t MSGPACK_ARRAY16   {0xdc};
+constexpr uint8_t MSGPACK_ARRAY32   {0xdd};
+constexpr uint8_t MSGPACK_MAP16     {0xde};
+constexpr uint8_t MSGPACK_MAP32     {0xdf};
+
+}
+
+ResponseWriter::ResponseWriter(Format _format)
+    : buffer {thread_buffer()}, format {_format}
+{
+    if (buffer.capacity() > MAX_RETAINED_CAPACITY)
+        string().swap(buffer);
+
+    buffer.clear();
+}
+
+ResponseWriter::ResponseWriter(string& _buffer, Format _format)
+    : buffer {_buffer}, format {_format}
+{
+    buffer.clear();
+}
+
+ResponseWriter&
+ResponseWriter::begin_object()
+{
+    open_scope('{');
+    return *this;
+}
+
+ResponseWriter&
+ResponseWriter::end_object()
+{
+    close_scope('}');
+    return *this;
+}
+
+ResponseWriter&
+ResponseWriter::begin_array()
+{
+    open_scope('[');
+    return *this;
+}
+
+ResponseWriter&
+ResponseWriter::end_array()
+{
+    close_scope(']');
+    return *this;
+}
+
+ResponseWriter&
+ResponseWriter::key(string const& name)
+{
+    before_value();
+
+    if (format == Format::JSON)
+    {
+        write_escaped(name.data(), name.size());
+        buffer += ':';
+    }
+    else
+    {
+        write_string(name.data(), name.size(), false);
+    }
+
+    after_key = true;
+    hex_key   = format != Format::JSON && is_hex_field(name);
+
+    return *this;
+}
+
+ResponseWriter&
+ResponseWriter::value(string const& str)
+{
+    bool const hex_field = next_is_hex();
+    before_value();
+    write_string(str.data(), str.size(), hex_field);
+    return *this;
+}
+
+ResponseWriter&
+ResponseWriter::value(const char* str)
+{
+    bool const hex_field = next_is_hex();
+    before_value();
+    write_string(str, std::char_traits<char>::length(str), hex_field);
+    return *this;
+}
+
+ResponseWriter&
+ResponseWriter::value(bool b)
+{
+    before_value();
+
+    if (format == Format::JSON)
+        buffer += b ? "true" : "false";
+    else if (format == Format::CBOR)
+        write_byte(b ? CBOR_TRUE : CBOR_FALSE);
+    else
+        write_byte(b ? MSGPACK_TRUE : MSGPACK_FALSE);
+
+    return *this;
+}
+
+ResponseWriter&
+ResponseWriter::null()
+{
+    before_value();
+
+    if (format == Format::JSON)
+        buffer += "null";
+    else if (format == Format::CBOR)
+        write_byte(CBOR_NULL);
+    else
+        write_byte(MSGPACK_NIL);
+
+    return *this;
+}
+
+ResponseWriter&
+ResponseWriter::value(json const& j)
+{
+    bool const hex_field = next_is_hex();
+
+    before_value();
+
+    if (format == Format::JSON)
+        buffer += j.dump();
+    else
+        write_binary(j, hex_field);
+
+    return *this;
+}
+
+string const&
+ResponseWriter::str() const
+{
+    return buffer;
+}
+
+ResponseWriter::Format
+ResponseWriter::get_format() const
+{
+    return format;
+}
+
+bool
+ResponseWriter::is_hex_field(string const& name)
+{
+    static const unordered_set<string> hex_field_names {
+        "hash", "tx_hash", "tx_prefix_hash", "prefix_hash",
+        "tx_pub_key", "pub_key", "public_key", "key_image",
+        "spend_key_images", "rct", "payment_id"
+    };
+
+    return hex_field_names.count(name) > 0;
+}
+
+void
+ResponseWriter::before_value()
+{
+    if (after_key)
+    {
+        after_key = false;
+        return;
+    }
+
+    if (depth == 0)
+        return;
+
+    if (format == Format::MSGPACK)
+    {
+        // keys are counted for maps, so values after
+        // them (returned above) are not
+        ++scope_sizes[depth - 1];
+        return;
+    }
+
+    if (format == Format::CBOR)
+        return;
+
+    uint64_t const scope_bit = uint64_t {1} << (depth - 1);
+
+    if (has_elements & scope_bit)
+        buffer += ',';
+
+    has_elements |= scope_bit;
+}
+
+bool
+ResponseWriter::next_is_hex() const
+{
+    if (after_key)
+        return hex_key;
+
+    return depth > 0 && (hex_scopes & (uint64_t {1} << (depth - 1)));
+}
+
+void
+ResponseWriter::open_scope(char bracket)
+{
+    if (depth == MAX_DEPTH)
+        throw std::runtime_error("ResponseWriter: max depth exceeded");
+
+    bool const hex_array = bracket == '[' && next_is_hex();
+
+    before_value();
+
+    if (format == Format::JSON)
+    {
+        buffer += bracket;
+    }
+    else if (format == Format::CBOR)
+    {
+        // indefinite length map or array
+        write_byte(bracket == '{' ? CBOR_MAP_INDEFINITE
+                                  : CBOR_ARRAY_INDEFINITE);
+    }
+    else
+    {
+        // map 32 or array 32, with size written in close_scope
+        write_byte(bracket == '{' ? MSGPACK_MAP32 : MSGPACK_ARRAY32);
+
+        scope_offsets[depth] = buffer.size();
+        scope_sizes[depth]   = 0;
+
+        buffer.append(4, '\0');
+    }
+
+    ++depth;
+
+    uint64_t const scope_bit = uint64_t {1} << (depth - 1);
+
+    has_elements &= ~scope_bit;
+
+    if (hex_array)
+        hex_scopes |= scope_bit;
+    else
+        hex_scopes &= ~scope_bit;
+}
+
+void
+ResponseWriter::close_scope(char bracket)
+{
+    if (depth == 0)
+        throw std::runtime_error("ResponseWriter: no scope to close");
+
+    --depth;
+
+    if (format == Format::JSON)
+    {
+        buffer += bracket;
+    }
+    else if (format == Format::CBOR)
+    {
+        // break
+        write_byte(CBOR_BREAK);
+    }
+    else
+    {
+        uint32_t const size = scope_sizes[depth];
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            buffer[scope_offsets[depth] + i]
+                    = static_cast<char>((size >> (8 * (3 - i))) & 0xff);
+        }
+    }
+}
+
+void
+ResponseWriter::write_number(uint64_t number, bool negative)
+{
+    // for negative numbers, number is the absolute value
+
+    if (format == Format::CBOR)
+    {
+        if (negative)
+            write_cbor_head(CBOR_NEGATIVE, number - 1);
+        else
+            write_cbor_head(CBOR_UNSIGNED, number);
+
+        return;
+    }
+
+    if (format == Format::MSGPACK)
+    {
+        if (!negative)
+        {
+            if (number <= 0x7f)
+            {
+                // positive fixint
+                buffer += static_cast<char>(number);
+            }
+            else if (number <= 0xff)
+            {
+                write_byte(MSGPACK_UINT8);
+                write_big_endian(number, 1);
+            }
+            else if (number <= 0xffff)
+            {
+                write_byte(MSGPACK_UINT16);
+                write_big_endian(number, 2);
+            }
+            else if (number <= 0xffffffff)
+            {
+                write_byte(MSGPACK_UINT32);
+                write_big_endian(number, 4);
+            }
+            else
+            {
+                write_byte(MSGPACK_UINT64);
+                write_big_endian(number, 8);
+            }
+
+            return;
+        }
+
+        // two's complement of the negative number
+        uint64_t const twos_complement = ~number + 1;
+
+        if (number <= 32)
+        {
+            // negative fixint
+            write_big_endian(twos_complement, 1);
+        }
+        else if (number <= 0x80)
+        {
+            write_byte(MSGPACK_INT8);
+            write_big_endian(twos_complement, 1);
+        }
+        else if (number <= 0x8000)
+        {
+            write_byte(MSGPACK_INT16);
+            write_big_endian(twos_complement, 2);
+        }
+        else if (number <= 0x80000000)
+        {
+            write_byte(MSGPACK_INT32);
+            write_big_endian(twos_complement, 4);
+        }
+        else
+        {
+            write_byte(MSGPACK_INT64);
+            write_big_endian(twos_complement, 8);
+        }
+
+        return;
+    }
+
+    // 20 digits is enough for uint64_t
+    char digits[21];
+    char* end = digits + sizeof(digits);
+    char* begin = end;
+
+    do
+    {
+        *--begin = static_cast<char>('0' + number % 10);
+        number /= 10;
+    }
+    while (number > 0);
+
+    if (negative)
+        *--begin = '-';
+
+    buffer.append(begin, end);
+}
+
+void
+ResponseWriter::write_string(const char* str, size_t size, bool hex_field)
+{
+    if (format == Format::JSON)
+    {
+        write_escaped(str, size);
+        return;
+    }
+
+    if (hex_field && size % 2 == 0)
+    {
+        size_t const head_offset = buffer.size();
+
+        write_bytes_head(size / 2);
+
+        size_t const bytes_offset = buffer.size();
+
+        buffer.resize(bytes_offset + size / 2);
+
+        if (hex_to_bytes(str, size / 2, &buffer[bytes_offset]))
+            return;
+
+        // not a hex string after all, so it goes as a text
+        buffer.resize(head_offset);
+    }
+
+    write_text_head(size);
+    buffer.append(str, size);
+}
+
+void
+ResponseWriter::write_binary(json const& j, bool hex_field)
+{
+    switch (j.type())
+    {
+        case json::value_t::object:
+            write_container_head(true, j.size());
+
+            for (auto it = j.begin(); it != j.end(); ++it)
+            {
+                string const& name = it.key();
+
+                write_string(name.data(), name.size(), false);
+                write_binary(it.value(), is_hex_field(name));
+            }
+            break;
+
+        case json::value_t::array:
+            write_container_head(false, j.size());
+
+            for (json const& element: j)
+                write_binary(element, hex_field);
+            break;
+
+        case json::value_t::string:
+        {
+            string const& str = j.get_ref<string const&>();
+            write_string(str.data(), str.size(), hex_field);
+            break;
+        }
+
+        case json::value_t::boolean:
+            if (format == Format::CBOR)
+                write_byte(j.get<bool>() ? CBOR_TRUE : CBOR_FALSE);
+            else
+                write_byte(j.get<bool>() ? MSGPACK_TRUE : MSGPACK_FALSE);
+            break;
+
+        case json::value_t::number_unsigned:
+            write_number(j.get<uint64_t>(), false);
+            break;
+
+        case json::value_t::number_integer:
+        {
+            int64_t const number = j.get<int64_t>();
+
+            if (number < 0)
+                write_number(static_cast<uint64_t>(-(number + 1)) + 1, true);
+            else
+                write_number(static_cast<uint64_t>(number), false);
+            break;
+        }
+
+        case json::value_t::number_float:
+        {
+            double const number = j.get<double>();
+
+            uint64_t bits;
+            std::memcpy(&bits, &number, sizeof(bits));
+
+            // double precision float in both formats
+            write_byte(format == Format::CBOR ? CBOR_FLOAT64
+                                              : MSGPACK_FLOAT64);
+            write_big_endian(bits, 8);
+            break;
+        }
+
+        default:
+            // null and discarded
+            write_byte(format == Format::CBOR ? CBOR_NULL : MSGPACK_NIL);
+    }
+}
+
+void
+ResponseWriter::write_text_head(uint64_t size)
+{
+    if (format == Format::CBOR)
+    {
+        write_cbor_head(CBOR_TEXT, size);
+    }
+    else if (size < 32)
+    {
+        // fixstr
+        write_byte(MSGPACK_FIXSTR | size);
+    }
+    else if (size <= 0xff)
+    {
+        write_byte(MSGPACK_STR8);
+        write_big_endian(size, 1);
+    }
+    else if (size <= 0xffff)
+    {
+        write_byte(MSGPACK_STR16);
+        write_big_endian(size, 2);
+    }
+    else
+    {
+        write_byte(MSGPACK_STR32);
+        write_big_endian(size, 4);
+    }
+}
+
+void
+ResponseWriter::write_bytes_head(uint64_t size)
+{
+    if (format == Format::CBOR)
+    {
+        write_cbor_head(CBOR_BYTES, size);
+    }
+    else if (size <= 0xff)
+    {
+        write_byte(MSGPACK_BIN8);
+        write_big_endian(size, 1);
+    }
+    else if (size <= 0xffff)
+    {
+        write_byte(MSGPACK_BIN16);
+        write_big_endian(size, 2);
+    }
+    else
+    {
+        write_byte(MSGPACK_BIN32);
+        write_big_endian(size, 4);
+    }
+}
+
+void
+ResponseWriter::write_container_head(bool is_object, uint64_t size)
+{
+    if (format == Format::CBOR)
+    {
+        write_cbor_head(is_object ? CBOR_MAP : CBOR_ARRAY, size);
+    }
+    else if (size < 16)
+    {
+        // fixmap or fixarray
+        write_byte((is_object ? MSGPACK_FIXMAP : MSGPACK_FIXARRAY) | size);
+    }
+    else if (size <= 0xffff)
+    {
+        write_byte(is_object ? MSGPACK_MAP16 : MSGPACK_ARRAY16);
+        write_big_endian(size, 2);
+    }
+    else
+    {
+        write_byte(is_object ? MSGPACK_MAP32 : MSGPACK_ARRAY32);
+        write_big_endian(size, 4);
+    }
+}
+
+void
+ResponseWriter::write_cbor_head(uint8_t major_type, uint64_t argument)
+{
+    uint8_t const initial_byte = major_type << 5;
+
+    if (argument < 24)
+    {
+        write_byte(initial_byte | argument);
+    }
+    else if (argument <= 0xff)
+    {
+        write_byte(initial_byte | CBOR_ARG_1_BYTE);
+        write_big_endian(argument, 1);
+    }
+    else if (argument <= 0xffff)
+    {
+        write_byte(initial_byte | CBOR_ARG_2_BYTES);
+        write_big_endian(argument, 2);
+    }
+    else if (argument <= 0xffffffff)
+    {
+        write_byte(initial_byte | CBOR_ARG_4_BYTES);
+        write_big_endian(argument, 4);
+    }
+    else
+    {
+        write_byte(initial_byte | CBOR_ARG_8_BYTES);
+        write_big_endian(argument, 8);
+    }
+}
+
+void
+ResponseWriter::write_big_endian(uint64_t number, size_t no_of_bytes)
+{
+    for (size_t i = no_of_bytes; i > 0; --i)
+        buffer += static_cast<char>((number >> (8 * (i - 1))) & 0xff);
+}
+
+void
+ResponseWriter::write_byte(uint8_t byte)
+{
+    buffer += static_cast<char>(byte);
+}
+
+void
+ResponseWriter::write_escaped(const char* str, size_t size)
+{
+    static constexpr const char* hex_digits = "0123456789abcdef";
+
+    buffer += '"';
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        char const c = str[i];
+
+        switch (c)
+        {
+            case '"':  buffer += "\\\""; break;
+            case '\\': buffer += "\\\\"; break;
+            case '\n': buffer += "\\n";  break;
+            case '\r': buffer += "\\r";  break;
+            case '\t': buffer += "\\t";  break;
+            case '\b': buffer += "\\b";  break;
+            case '\f': buffer += "\\f";  break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    buffer += "\\u00";
+                    buffer += hex_digits[(c >> 4) & 0x0f];
+                    buffer += hex_digits[c & 0x0f];
+                }
+                else
+                {
+                    buffer += c;
+                }
+        }
+    }
+
+    buffer += '"';
+}
+
+}
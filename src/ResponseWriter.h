@@ -0,0 +1,198 @@
+#ifndef OPENMONERO_RESPONSEWRITER_H
+#define OPENMONERO_RESPONSEWRITER_H
+
+#include "../ext/json.hpp"
+
+#include <array>
+#include <string>
+#include <type_traits>
+#include <cstdint>
+
+namespace xmreg
+{
+
+using namespace std;
+using namespace nlohmann;
+
+/**
+ * Writes responses directly into a string buffer, as json
+ * text or, if client asks for it, as CBOR or MessagePack.
+ *
+ * Used for large responses (e.g., get_address_txs), so that
+ * rows fetched from mysql can be serialized as they come,
+ * without first building a tree of json objects and then
+ * dumping it into yet another string.
+ *
+ * Default constructed writer uses a thread local buffer, which
+ * keeps its capacity between requests. Thus, there should be
+ * only one such writer alive per thread, and its str()
+ * is valid only until the next writer is made in that thread.
+ *
+ * Commas and colons are inserted automatically, e.g.,
+ *
+ *   writer.begin_object()
+ *         .key("height").value(height)
+ *         .key("spent_outputs").begin_array()
+ *         .end_array()
+ *         .end_object();
+ *
+ * Same calls can produce CBOR or MessagePack instead of text,
+ * for native clients asking for them. In these formats,
+ * values of known key and hash fields (e.g., hash, tx_pub_key,
+ * key_image) are written as byte strings (CBOR major type 2,
+ * MessagePack bin), rather than as hex text.
+ */
+class ResponseWriter
+{
+public:
+
+    enum class Format {JSON, CBOR, MSGPACK};
+
+    // buffers larger than this are freed, rather than kept
+    // for the next request
+    static constexpr size_t MAX_RETAINED_CAPACITY {4 * 1024 * 1024};
+
+    // max nesting of objects and arrays
+    static constexpr size_t MAX_DEPTH {64};
+
+    explicit ResponseWriter(Format _format = Format::JSON);
+
+    explicit ResponseWriter(string& _buffer, Format _format = Format::JSON);
+
+    ResponseWriter&
+    begin_object();
+
+    ResponseWriter&
+    end_object();
+
+    ResponseWriter&
+    begin_array();
+
+    ResponseWriter&
+    end_array();
+
+    ResponseWriter&
+    key(string const& name);
+
+    ResponseWriter&
+    value(string const& str);
+
+    ResponseWriter&
+    value(const char* str);
+
+    ResponseWriter&
+    value(bool b);
+
+    ResponseWriter&
+    null();
+
+    // already built json (e.g., mempool txs) is written as it is
+    ResponseWriter&
+    value(json const& j);
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value
+                            && !std::is_same<T, bool>::value,
+                            ResponseWriter&>::type
+    value(T number)
+    {
+        before_value();
+
+        if (number < 0)
+            write_number(static_cast<uint64_t>(-(number + 1)) + 1, true);
+        else
+            write_number(static_cast<uint64_t>(number), false);
+
+        return *this;
+    }
+
+    string const&
+    str() const;
+
+    Format
+    get_format() const;
+
+    // is value of field with this name a key or hash
+    // written as bytes in binary formats
+    static bool
+    is_hex_field(string const& name);
+
+private:
+
+    // writes comma, if needed, before next element in current scope
+    void
+    before_value();
+
+    void
+    open_scope(char bracket);
+
+    void
+    close_scope(char bracket);
+
+    void
+    write_number(uint64_t number, bool negative);
+
+    void
+    write_escaped(const char* str, size_t size);
+
+    // string value in any format. hex strings of hex fields
+    // are written as bytes in binary formats.
+    void
+    write_string(const char* str, size_t size, bool hex_field);
+
+    // already built json in binary formats
+    void
+    write_binary(json const& j, bool hex_field);
+
+    // does the next value belong to a hex field, either
+    // directly or as element of its array
+    bool
+    next_is_hex() const;
+
+    // headers of binary format items with their sizes
+    void
+    write_text_head(uint64_t size);
+
+    void
+    write_bytes_head(uint64_t size);
+
+    void
+    write_container_head(bool is_object, uint64_t size);
+
+    void
+    write_cbor_head(uint8_t major_type, uint64_t argument);
+
+    void
+    write_big_endian(uint64_t number, size_t no_of_bytes);
+
+    // single marker byte of binary formats
+    void
+    write_byte(uint8_t byte);
+
+    string& buffer;
+
+    Format format;
+
+    // bit i says that scope at depth i has at least one element
+    uint64_t has_elements {0};
+
+    size_t depth {0};
+
+    // value after a key does not need comma
+    bool after_key {false};
+
+    // last key was of a hex field
+    bool hex_key {false};
+
+    // bit i says that scope at depth i is array of a hex field
+    uint64_t hex_scopes {0};
+
+    // MessagePack containers need their sizes up front. they
+    // are written as 32-bit sizes, set when scope closes.
+    std::array<size_t, MAX_DEPTH> scope_offsets;
+    std::array<uint32_t, MAX_DEPTH> scope_sizes;
+};
+
+}
+
+#endif //OPENMONERO_RESPONSEWRITER_H
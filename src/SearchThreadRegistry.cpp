@@ -0,0 +1,127 @@
+#include "SearchThreadRegistry.h"
+
+#include "TxSearch.h"
+
+namespace xmreg
+{
+
+constexpr size_t SearchThreadRegistry::NO_OF_SHARDS;
+
+SearchThreadRegistry::insert_result
+SearchThreadRegistry::insert(account_public_address const& address,
+                             std::unique_ptr<TxSearch> tx_search)
+{
+    Shard& shard = get_shard(address);
+
+    std::lock_guard<std::mutex> lck (shard.mtx);
+
+    std::shared_ptr<threads_map_t const> threads
+            = std::atomic_load(&shard.threads);
+
+    if (threads->count(address) > 0)
+        return insert_result::exists;
+
+    if (shard.stopping.count(address) > 0)
+        return insert_result::stopping;
+
+    auto updated_threads = std::make_shared<threads_map_t>(*threads);
+
+    // thread is started only once we know it is the only one
+    // for the address, as otherwise it would have to be joined
+    // while holding the lock
+    updated_threads->emplace(
+            address, std::make_shared<search_thread_t>(std::move(tx_search)));
+
+    std::atomic_store(&shard.threads,
+                      std::shared_ptr<threads_map_t const>(
+                              std::move(updated_threads)));
+
+    return insert_result::inserted;
+}
+
+std::shared_ptr<SearchThreadRegistry::search_thread_t>
+SearchThreadRegistry::find(account_public_address const& address) const
+{
+    std::shared_ptr<threads_map_t const> threads
+            = std::atomic_load(&get_shard(address).threads);
+
+    auto it = threads->find(address);
+
+    if (it == threads->end())
+        return nullptr;
+
+    return it->second;
+}
+
+vector<pair<account_public_address,
+            std::shared_ptr<SearchThreadRegistry::search_thread_t>>>
+SearchThreadRegistry::remove_stopped()
+{
+    vector<pair<account_public_address, std::shared_ptr<search_thread_t>>>
+            stopped;
+
+    for (Shard& shard: shards)
+    {
+        std::lock_guard<std::mutex> lck (shard.mtx);
+
+        std::shared_ptr<threads_map_t const> threads
+                = std::atomic_load(&shard.threads);
+
+        auto updated_threads = std::make_shared<threads_map_t>();
+
+        for (auto const& thread: *threads)
+        {
+            if (thread.second->get_functor().still_searching())
+                updated_threads->insert(thread);
+            else
+            {
+                shard.stopping.insert(thread);
+                stopped.push_back(thread);
+            }
+        }
+
+        if (updated_threads->size() == threads->size())
+            continue;
+
+        std::atomic_store(&shard.threads,
+                          std::shared_ptr<threads_map_t const>(
+                                  std::move(updated_threads)));
+    }
+
+    return stopped;
+}
+
+void
+SearchThreadRegistry::remove_joined(account_public_address const& address)
+{
+    Shard& shard = get_shard(address);
+
+    std::lock_guard<std::mutex> lck (shard.mtx);
+
+    shard.stopping.erase(address);
+}
+
+size_t
+SearchThreadRegistry::size() const
+{
+    size_t total {0};
+
+    for (Shard const& shard: shards)
+        total += std::atomic_load(&shard.threads)->size();
+
+    return total;
+}
+
+SearchThreadRegistry::Shard&
+SearchThreadRegistry::get_shard(account_public_address const& address)
+{
+    return shards[address_hash{}(address) % NO_OF_SHARDS];
+}
+
+SearchThreadRegistry::Shard const&
+SearchThreadRegistry::get_shard(account_public_address const& address) const
+{
+    return shards[address_hash{}(address) % NO_OF_SHARDS];
+}
+
+}
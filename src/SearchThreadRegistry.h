@@ -0,0 +1,123 @@
+#ifndef OPENMONERO_SEARCHTHREADREGISTRY_H
+#define OPENMONERO_SEARCHTHREADREGISTRY_H
+
+#include "monero_headers.h"
+#include "ThreadRAII.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace xmreg
+{
+
+using namespace cryptonote;
+using namespace crypto;
+using namespace std;
+
+class TxSearch;
+
+/**
+ * Running search threads, by addresses of their accounts.
+ *
+ * Like KnownOutputsIndex, it is split into shards. But as
+ * search threads are looked up on each request, and added or
+ * removed only on logins and when they stop, each shard is
+ * an immutable map replaced by its updated copy. So lookups
+ * dont lock, and the lock of a shard is only taken to
+ * replace it.
+ *
+ * Removed threads are returned to the caller, so that they
+ * are joined outside of the locks. Until the caller reports
+ * them joined, they are kept as stopping, and no new thread
+ * can be started for their addresses. Otherwise a new thread
+ * could be searching for the same account as the stopped
+ * one, which can still be scanning its last blocks.
+ */
+class SearchThreadRegistry
+{
+public:
+
+    using search_thread_t = ThreadRAII2<TxSearch>;
+
+    static constexpr size_t NO_OF_SHARDS {16};
+
+    enum class insert_result {inserted, exists, stopping};
+
+    // starts the search thread, unless the address already
+    // has one, running or stopping.
+    insert_result
+    insert(account_public_address const& address,
+           std::unique_ptr<TxSearch> tx_search);
+
+    // null if the address has no search thread
+    std::shared_ptr<search_thread_t>
+    find(account_public_address const& address) const;
+
+    // removes threads which are not searching anymore.
+    // they are kept as stopping until removed by remove_joined.
+    vector<pair<account_public_address, std::shared_ptr<search_thread_t>>>
+    remove_stopped();
+
+    // forgets stopping thread of the address, after it was joined
+    void
+    remove_joined(account_public_address const& address);
+
+    size_t
+    size() const;
+
+private:
+
+    struct address_hash
+    {
+        size_t
+        operator()(account_public_address const& address) const
+        {
+            // spend public keys are uniformly distributed
+            return std::hash<public_key>{}(address.m_spend_public_key);
+        }
+    };
+
+    struct address_equal
+    {
+        bool
+        operator()(account_public_address const& a,
+                   account_public_address const& b) const
+        {
+            return a.m_spend_public_key == b.m_spend_public_key
+                   && a.m_view_public_key == b.m_view_public_key;
+        }
+    };
+
+    using threads_map_t = unordered_map<account_public_address,
+                                        std::shared_ptr<search_thread_t>,
+                                        address_hash, address_equal>;
+
+    struct Shard
+    {
+        // only taken when threads are replaced
+        mutable mutex mtx;
+
+        // only accessed using std::atomic_load and std::atomic_store
+        std::shared_ptr<threads_map_t const> threads
+                {std::make_shared<threads_map_t const>()};
+
+        // removed, but not joined yet. guarded by mtx,
+        // as it is not used by lookups.
+        threads_map_t stopping;
+    };
+
+    Shard&
+    get_shard(account_public_address const& address);
+
+    Shard const&
+    get_shard(account_public_address const& address) const;
+
+    std::array<Shard, NO_OF_SHARDS> shards;
+};
+
+}
+
+#endif //OPENMONERO_SEARCHTHREADREGISTRY_H
@@ -0,0 +1,95 @@
+#include "SessionTokens.h"
+
+#include "TxSearch.h"
+
+namespace xmreg
+{
+
+constexpr size_t SessionTokens::NO_OF_SHARDS;
+
+string
+SessionTokens::insert(string const& address,
+                      std::shared_ptr<search_thread_t> const& search_thread)
+{
+    string const token = pod_to_hex(
+                crypto::rand<crypto::hash>());
+
+    Shard& shard = get_shard(token);
+
+    std::lock_guard<std::mutex> lck (shard.mtx);
+
+    // tokens are not used after they expire, so
+    // expired ones are removed when new ones are added
+    for (auto it = shard.sessions.begin(); it != shard.sessions.end();)
+    {
+        if (!get_search_thread(it->second))
+            it = shard.sessions.erase(it);
+        else
+            ++it;
+    }
+
+    shard.sessions[token] = session_t {address, search_thread};
+
+    return token;
+}
+
+std::shared_ptr<SessionTokens::search_thread_t>
+SessionTokens::find(string const& token, string const& address)
+{
+    Shard& shard = get_shard(token);
+
+    std::lock_guard<std::mutex> lck (shard.mtx);
+
+    auto it = shard.sessions.find(token);
+
+    if (it == shard.sessions.end() || it->second.address != address)
+        return nullptr;
+
+    std::shared_ptr<search_thread_t> search_thread
+            = get_search_thread(it->second);
+
+    if (!search_thread)
+        shard.sessions.erase(it);
+
+    return search_thread;
+}
+
+size_t
+SessionTokens::size() const
+{
+    size_t total {0};
+
+    for (Shard const& shard: shards)
+    {
+        std::lock_guard<std::mutex> lck (shard.mtx);
+        total += shard.sessions.size();
+    }
+
+    return total;
+}
+
+std::shared_ptr<SessionTokens::search_thread_t>
+SessionTokens::get_search_thread(session_t const& session)
+{
+    std::shared_ptr<search_thread_t> search_thread
+            = session.search_thread.lock();
+
+    if (!search_thread || !search_thread->get_functor().still_searching())
+        return nullptr;
+
+    return search_thread;
+}
+
+SessionTokens::Shard&
+SessionTokens::get_shard(string const& token)
+{
+    return shards[std::hash<string>{}(token) % NO_OF_SHARDS];
+}
+
+SessionTokens::Shard const&
+SessionTokens::get_shard(string const& token) const
+{
+    return shards[std::hash<string>{}(token) % NO_OF_SHARDS];
+}
+
+}
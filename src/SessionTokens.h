@@ -0,0 +1,82 @@
+#ifndef OPENMONERO_SESSIONTOKENS_H
+#define OPENMONERO_SESSIONTOKENS_H
+
+#include "SearchThreadRegistry.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace xmreg
+{
+
+using namespace std;
+
+/**
+ * Tokens issued by login, so that later requests of the
+ * wallet dont need to hash its viewkey again. Its account
+ * is still read from mysql, as the row can change.
+ *
+ * A token is valid only as long as the search thread it
+ * was issued with keeps searching, so it expires together
+ * with the search thread.
+ *
+ * Like KnownOutputsIndex, it is split into shards, each
+ * with its own lock.
+ */
+class SessionTokens
+{
+public:
+
+    using search_thread_t = SearchThreadRegistry::search_thread_t;
+
+    static constexpr size_t NO_OF_SHARDS {16};
+
+    // random token for the address and its search thread
+    string
+    insert(string const& address,
+           std::shared_ptr<search_thread_t> const& search_thread);
+
+    // null if the token is not known, has expired,
+    // or was issued for other address
+    std::shared_ptr<search_thread_t>
+    find(string const& token, string const& address);
+
+    size_t
+    size() const;
+
+private:
+
+    struct session_t
+    {
+        string address;
+
+        // does not keep the search thread alive
+        std::weak_ptr<search_thread_t> search_thread;
+    };
+
+    struct Shard
+    {
+        mutable mutex mtx;
+
+        unordered_map<string, session_t> sessions;
+    };
+
+    // null if the session's search thread stopped
+    static std::shared_ptr<search_thread_t>
+    get_search_thread(session_t const& session);
+
+    Shard&
+    get_shard(string const& token);
+
+    Shard const&
+    get_shard(string const& token) const;
+
+    std::array<Shard, NO_OF_SHARDS> shards;
+};
+
+}
+
+#endif //OPENMONERO_SESSIONTOKENS_H
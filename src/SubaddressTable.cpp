@@ -0,0 +1,53 @@
+#include "SubaddressTable.h"
+
+namespace xmreg
+{
+
+SubaddressTable::SubaddressTable(address_parse_info const& address,
+                                 secret_key const& viewkey,
+                                 uint32_t major_lookahead,
+                                 uint32_t minor_lookahead)
+{
+    // spend secret key is not needed for subaddresses'
+    // spend public keys
+    account_keys keys;
+
+    keys.m_account_address  = address.address;
+    keys.m_view_secret_key  = viewkey;
+
+    hw::device& hwdev = hw::get_device("default");
+
+    // main address is always there
+    major_lookahead = std::max<uint32_t>(major_lookahead, 1);
+    minor_lookahead = std::max<uint32_t>(minor_lookahead, 1);
+
+    spend_public_keys.reserve(static_cast<size_t>(major_lookahead)
+                              * minor_lookahead);
+
+    for (uint32_t major = 0; major < major_lookahead; ++major)
+    {
+        vector<public_key> const major_keys
+                = hwdev.get_subaddress_spend_public_keys(
+                        keys, major, 0, minor_lookahead);
+
+        for (uint32_t minor = 0; minor < major_keys.size(); ++minor)
+            spend_public_keys.emplace(major_keys[minor],
+                                      subaddress_index {major, minor});
+    }
+}
+
+bool
+SubaddressTable::find(public_key const& spend_public_key,
+                      subaddress_index& index) const
+{
+    auto it = spend_public_keys.find(spend_public_key);
+
+    if (it == spend_public_keys.end())
+        return false;
+
+    index = it->second;
+
+    return true;
+}
+
+}
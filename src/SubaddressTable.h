@@ -0,0 +1,51 @@
+#ifndef OPENMONERO_SUBADDRESSTABLE_H
+#define OPENMONERO_SUBADDRESSTABLE_H
+
+#include "monero_headers.h"
+
+#include <unordered_map>
+
+namespace xmreg
+{
+
+using namespace cryptonote;
+using namespace crypto;
+using namespace std;
+
+/**
+ * Spend public keys of an account's subaddresses, from
+ * (0, 0), i.e., the main address, up to
+ * (major_lookahead - 1, minor_lookahead - 1).
+ *
+ * An output belongs to a subaddress if subtracting
+ * Hs(derivation || output index) * G from its key gives
+ * the subaddress's spend public key. So with the keys
+ * precomputed, each output is checked with one lookup,
+ * no matter how many subaddresses there are.
+ *
+ * Only the address and viewkey are needed to build it.
+ */
+class SubaddressTable
+{
+public:
+
+    SubaddressTable(address_parse_info const& address,
+                    secret_key const& viewkey,
+                    uint32_t major_lookahead,
+                    uint32_t minor_lookahead);
+
+    bool
+    find(public_key const& spend_public_key,
+         subaddress_index& index) const;
+
+    size_t
+    size() const {return spend_public_keys.size();}
+
+private:
+
+    unordered_map<public_key, subaddress_index> spend_public_keys;
+};
+
+}
+
+#endif //OPENMONERO_SUBADDRESSTABLE_H
@@ -15,14 +15,30 @@
 namespace xmreg
 {
 
+template <typename F>
+void
+TxSearch::update_state(F&& update)
+{
+    std::shared_ptr<state_t const> current_state = std::atomic_load(&state);
+    std::shared_ptr<state_t const> updated_state;
+
+    do
+    {
+        auto new_state = std::make_shared<state_t>(*current_state);
+
+        update(*new_state);
+
+        updated_state = std::move(new_state);
+    }
+    while (!std::atomic_compare_exchange_weak(
+               &state, &current_state, updated_state));
+}
+
 TxSearch::TxSearch(XmrAccount& _acc, std::shared_ptr<CurrentBlockchainStatus> _current_bc_status)
     : current_bc_status {_current_bc_status}
 {
     acc = make_shared<XmrAccount>(_acc);
 
-    // creates an mysql connection for this thread
-    xmr_accounts = make_shared<MySqlAccounts>(current_bc_status);
-
     network_type net_type = current_bc_status->get_bc_setup().net_type;
 
     if (!xmreg::parse_str_address(acc->address, address, net_type))
@@ -37,11 +53,16 @@ TxSearch::TxSearch(XmrAccount& _acc, std::shared_ptr<CurrentBlockchainStatus> _c
         throw TxSearchException("Cant parse private key: " + acc->viewkey);
     }
 
-    populate_known_outputs();
+    update_state([this](state_t& new_state)
+                 {
+                     new_state.address = address;
+                     new_state.viewkey = viewkey;
+                     new_state.account = std::make_shared<XmrAccount const>(*acc);
+                 });
 
     // start searching from last block that we searched for
     // this accont
-    searched_blk_no = acc->scanned_block_height;
+    set_searched_blk_no(acc->scanned_block_height);
 
     last_ping_timestamp = 0;
 
@@ -65,13 +86,19 @@ TxSearch::operator()()
     // here.
     try
     {
+        prepare_search();
+
         while(continue_search)
         {
             uint64_t loop_timestamp {current_timestamp};
 
+            notify_about_unlocked_txs();
+
+            search_mempool();
+
             uint64_t last_block_height = current_bc_status->current_height;
 
-            uint64_t h1 = searched_blk_no;
+            uint64_t h1 = get_state()->searched_blk_no;
             uint64_t h2 = std::min(h1 + blocks_lookahead - 1, last_block_height);
 
             vector<block> blocks = current_bc_status->get_blocks_range(h1, h2);
@@ -111,6 +138,11 @@ TxSearch::operator()()
             cout << "Analyzing " << blocks.size() << " blocks from " << h1 << " to " << h2
                  << " out of " << last_block_height << " blocks.\n";
 
+            // all blockchain reads for this range, i.e., its txs,
+            // ring members, and data of found txs, use one lmdb
+            // read transaction.
+            BatchRead batch_read = current_bc_status->make_batch_read();
+
             vector<CurrentBlockchainStatus::txs_tuple_t> txs_data;
 
             if (!current_bc_status->get_txs_in_blocks(blocks, txs_data))
@@ -119,6 +151,22 @@ TxSearch::operator()()
                 return;
             }
 
+            // ring members of all inputs in the blocks, read at once and
+            // shared with other search threads analyzing same blocks.
+            // if null, each input's ring is read separately. they are
+            // read only once the account has some outputs, as before
+            // that none of the inputs can be ours.
+            std::shared_ptr<CurrentBlockchainStatus::ring_members_t const>
+                    ring_members;
+
+            bool ring_members_read {false};
+
+            // tx pub keys precomputed once for all search threads
+            // analyzing same blocks
+            std::shared_ptr<vector<PrecomputedTxPubKey> const>
+                    tx_pub_keys = current_bc_status
+                                    ->get_precomputed_tx_pub_keys(txs_data);
+
             // we will only create mysql DateTime object once, anything is found
             // in a given block;
             unique_ptr<DateTime> blk_timestamp_mysql_format;
@@ -139,21 +187,38 @@ TxSearch::operator()()
             // that we think are yours, and the frontend, because it has spend key,
             // can filter out false positives.
             //for (transaction& tx: txs)
-            for (auto const& tx_tuple: txs_data)
+            for (size_t tx_i = 0; tx_i < txs_data.size(); ++tx_i)
             {
+                auto& tx_tuple = txs_data[tx_i];
+
                 crypto::hash const& tx_hash = std::get<0>(tx_tuple);
                 transaction const& tx       = std::get<1>(tx_tuple);
                 uint64_t blk_height         = std::get<2>(tx_tuple);
                 uint64_t blk_timestamp      = std::get<3>(tx_tuple);
                 bool is_coinbase            = std::get<4>(tx_tuple);
 
+                // this is id of txs in lmdb blockchain table.
+                // it will be used mostly to sort txs in the frontend.
+                // both it and amount specific (i.e., global) indices of
+                // outputs are read by get_tx_output_indices only for
+                // txs with our outputs or inputs.
+                uint64_t const& blockchain_tx_id = std::get<5>(tx_tuple);
+
+                vector<uint64_t> const& amount_specific_indices
+                                            = std::get<6>(tx_tuple);
+
+                tx_extra_info const& extra_info = std::get<7>(tx_tuple);
+
                 //cout << "\n\n\n" << blk_height << '\n';
 
                 // Class that is responsible for identification of our outputs
                 // and inputs in a given tx.
                 OutputInputIdentification oi_identification {&address, &viewkey, &tx,
                                                              tx_hash, is_coinbase,
-                                                             current_bc_status};
+                                                             current_bc_status,
+                                                             &(*tx_pub_keys)[tx_i],
+                                                             get_subaddresses(),
+                                                             &extra_info};
 
                 // flag indicating whether the txs in the given block are spendable.
                 // this is true when block number is more than 10 blocks from current
@@ -162,18 +227,14 @@ TxSearch::operator()()
                 bool is_spendable = current_bc_status->is_tx_unlocked(
                         tx.unlock_time, blk_height);
 
-
-                // this is id of txs in lmdb blockchain table.
-                // it will be used mostly to sort txs in the frontend.
-                uint64_t blockchain_tx_id {0};
-
                 // FIRSt step.
                 oi_identification.identify_outputs();
 
-                vector<uint64_t> amount_specific_indices;
-
                 uint64_t tx_mysql_id {0};
 
+                // how much we preasumply spent in this tx
+                uint64_t total_sent {0};
+
                 // create pointer to mysql transaction object
                 // that we will initilize if we find something.
                 unique_ptr<mysqlpp::Transaction> mysql_transaction;
@@ -208,18 +269,14 @@ TxSearch::operator()()
                     }
 
 
-                    if (!current_bc_status->tx_exist(tx_hash, blockchain_tx_id))
-                    {
-                        cerr << "Tx " << oi_identification.get_tx_hash_str()
-                             << " " << pod_to_hex(tx_hash)
-                             << " not found in blockchain !" << '\n';
-                        throw TxSearchException("Cant get tx from blockchain: " + pod_to_hex(tx_hash));
-                    }
-
                     cout << " - found some outputs in block " << blk_height
                          << ", tx: " << oi_identification.get_tx_hash_str() << '\n';
 
 
+                    if (!current_bc_status->get_tx_output_indices(tx_tuple))
+                        throw TxSearchException("Cant get output indices of tx "
+                                                + oi_identification.get_tx_hash_str());
+
                     XmrTransaction tx_data;
 
                     tx_data.id               = mysqlpp::null;
@@ -243,7 +300,7 @@ TxSearch::operator()()
                     tx_data.is_rct           = oi_identification.is_rct;
                     tx_data.rct_type         = oi_identification.rct_type;
                     tx_data.spendable        = is_spendable;
-                    tx_data.payment_id       = current_bc_status->get_payment_id_as_string(tx);
+                    tx_data.payment_id       = oi_identification.get_payment_id_str();
                     tx_data.mixin            = oi_identification.get_mixin_no();
                     tx_data.timestamp        = *blk_timestamp_mysql_format;
 
@@ -251,14 +308,6 @@ TxSearch::operator()()
                     // insert tx_data into mysql's Transactions table
                     tx_mysql_id = xmr_accounts->insert(tx_data);
 
-                    // get amount specific (i.e., global) indices of outputs
-                    if (!current_bc_status->get_amount_specific_indices(
-                            tx_hash, amount_specific_indices))
-                    {
-                        cerr << "cant get_amount_specific_indices!" << endl;
-                        throw TxSearchException("cant get_amount_specific_indices!");
-                    }
-
                     if (tx_mysql_id == 0)
                     {
                         //cerr << "tx_mysql_id is zero!" << endl;
@@ -277,7 +326,7 @@ TxSearch::operator()()
                         out_data.account_id   = acc->id.data;
                         out_data.tx_id        = tx_mysql_id;
                         out_data.out_pub_key  = pod_to_hex(out_info.pub_key);
-                        out_data.tx_pub_key   = oi_identification.get_tx_pub_key_str();
+                        out_data.tx_pub_key   = pod_to_hex(out_info.tx_pub_key);
                         out_data.amount       = out_info.amount;
                         out_data.out_index    = out_info.idx_in_tx;
                         out_data.rct_outpk    = out_info.rtc_outpk;
@@ -285,18 +334,22 @@ TxSearch::operator()()
                         out_data.rct_amount   = out_info.rtc_amount;
                         out_data.global_index = amount_specific_indices.at(out_data.out_index);
                         out_data.mixin        = tx_data.mixin;
+                        out_data.subaddr_major = out_info.subaddr_index.major;
+                        out_data.subaddr_minor = out_info.subaddr_index.minor;
                         out_data.timestamp    = tx_data.timestamp;
 
                         outputs_found.push_back(std::move(out_data));
 
-                        {
-                            // add the outputs found into known_outputs_keys map
-                            std::lock_guard<std::mutex> lck (getting_known_outputs_keys);
-                            known_outputs_keys.insert({out_info.pub_key, out_info.amount});
-                        }
+                        // output id is not known until it is read
+                        // back from mysql
+                        current_bc_status->get_known_outputs_index().insert(
+                                out_info.pub_key,
+                                {acc->id.data, 0, out_info.amount});
 
                     } //  for (auto& out_info: oi_identification.identified_outputs)
 
+                    has_known_outputs = true;
+
 
                     // insert all outputs found into mysql's outputs table
                     uint64_t no_rows_inserted = xmr_accounts->insert(outputs_found);
@@ -314,7 +367,19 @@ TxSearch::operator()()
 
                 // no need mutex here, as this will be exectued only after
                 // the above. there is no threads here.
-                oi_identification.identify_inputs(known_outputs_keys);
+                if (has_known_outputs)
+                {
+                    if (!ring_members_read)
+                    {
+                        ring_members = current_bc_status
+                                        ->get_ring_members(txs_data);
+                        ring_members_read = true;
+                    }
+
+                    oi_identification.identify_inputs(
+                            current_bc_status->get_known_outputs_index(),
+                            acc->id.data, ring_members.get());
+                }
 
 
                 if (!oi_identification.identified_inputs.empty())
@@ -349,16 +414,6 @@ TxSearch::operator()()
                             throw TxSearchException("Cant delete tx " + oi_identification.tx_hash_str);
                     }
 
-                    if (blockchain_tx_id == 0)
-                    {
-                        if (!current_bc_status->tx_exist(oi_identification.tx_hash, blockchain_tx_id))
-                        {
-                            cerr << "Tx " << oi_identification.get_tx_hash_str()
-                                 << "not found in blockchain !" << '\n';
-                            throw TxSearchException("Cant get tx from blockchain: " + pod_to_hex(tx_hash));
-                        }
-                    }
-
                     cout << " - found some possible inputs in block " << blk_height
                          << ", tx: " << oi_identification.get_tx_hash_str() << '\n';
 
@@ -368,7 +423,18 @@ TxSearch::operator()()
                     {
                         XmrOutput out;
 
-                        if (xmr_accounts->output_exists(pod_to_hex(in_info.out_pub_key), out))
+                        // outputs read from mysql when this search thread
+                        // started have their ids in the index already.
+                        // outputs found again, e.g., by rescan, have zero
+                        // ids, as their rows were deleted with their txs.
+                        if (in_info.output_id != 0)
+                        {
+                            out.id     = in_info.output_id;
+                            out.amount = in_info.amount;
+                        }
+
+                        if (in_info.output_id != 0
+                                || xmr_accounts->output_exists(pod_to_hex(in_info.out_pub_key), out))
                         {
                             //cout << "input uses some mixins which are our outputs" << out << '\n';
 
@@ -401,8 +467,6 @@ TxSearch::operator()()
                         // check if this tx is written in mysql.
 
                         // calculate how much we preasumply spent.
-                        uint64_t total_sent {0};
-
                         for (const XmrInput& in_data: inputs_found)
                             total_sent += in_data.amount;
 
@@ -414,6 +478,10 @@ TxSearch::operator()()
                             // so write it to mysql as ours, with
                             // total received of 0.
 
+                            if (!current_bc_status->get_tx_output_indices(tx_tuple))
+                                throw TxSearchException("Cant get output indices of tx "
+                                                        + oi_identification.get_tx_hash_str());
+
                             XmrTransaction tx_data;
 
                             tx_data.id               = mysqlpp::null;
@@ -430,7 +498,7 @@ TxSearch::operator()()
                             tx_data.is_rct           = oi_identification.is_rct;
                             tx_data.rct_type         = oi_identification.rct_type;
                             tx_data.spendable        = is_spendable;
-                            tx_data.payment_id       = current_bc_status->get_payment_id_as_string(tx);
+                            tx_data.payment_id       = oi_identification.get_payment_id_str();
                             tx_data.mixin            = oi_identification.get_mixin_no();
                             tx_data.timestamp        = *blk_timestamp_mysql_format;
 
@@ -470,8 +538,30 @@ TxSearch::operator()()
                 // all this into database.
 
                 if (mysql_transaction)
+                {
                     mysql_transaction->commit();
 
+                    if (tx_mysql_id > 0)
+                    {
+                        publish_event({
+                            {"event"         , "tx_confirmed"},
+                            {"hash"          , oi_identification.get_tx_hash_str()},
+                            {"height"        , blk_height},
+                            {"timestamp"     , blk_timestamp},
+                            {"total_received", oi_identification.total_received},
+                            {"total_sent"    , total_sent},
+                            {"coinbase"      , oi_identification.tx_is_coinbase},
+                            {"spendable"     , is_spendable}});
+
+                        if (!is_spendable)
+                        {
+                            locked_txs[oi_identification.get_tx_hash_str()]
+                                    = {tx_mysql_id, blockchain_tx_id,
+                                       tx.unlock_time, blk_height};
+                        }
+                    }
+                }
+
             } // for (auto const& tx_pair: txs_map)
 
             // update scanned_block_height every given interval
@@ -487,11 +577,27 @@ TxSearch::operator()()
                 // iff success, set acc to updated_acc;
                 //cout << "scanned_block_height updated\n";
                 *acc = updated_acc;
+
+                auto account = std::make_shared<XmrAccount const>(updated_acc);
+
+                update_state([&account](state_t& new_state)
+                             {
+                                 new_state.account = account;
+                             });
             }
 
             //current_timestamp = loop_timestamp;
 
-            searched_blk_no = h2 + 1;
+            update_state([h2](state_t& new_state)
+                         {
+                             new_state.searched_blk_no = h2 + 1;
+                         });
+
+            publish_event({
+                {"event"                  , "scan_progress"},
+                {"scanned_block_height"   , h2},
+                {"scanned_block_timestamp", blocks.back().timestamp},
+                {"blockchain_height"      , last_block_height}});
 
         } // while(continue_search)
 
@@ -526,19 +632,27 @@ TxSearch::stop()
 
 TxSearch::~TxSearch()
 {
+    // outputs of the account stay in the index if another
+    // search thread for it is already running
+    if (known_outputs_acquired)
+        current_bc_status->get_known_outputs_index().release(acc->id.data);
+
     cout << "TxSearch destroyed" << endl;
 }
 
 void
 TxSearch::set_searched_blk_no(uint64_t new_value)
 {
-    searched_blk_no = new_value;
+    update_state([new_value](state_t& new_state)
+                 {
+                     new_state.searched_blk_no = new_value;
+                 });
 }
 
 uint64_t
 TxSearch::get_searched_blk_no() const
 {
-    return searched_blk_no;
+    return get_state()->searched_blk_no;
 }
 
 inline uint64_t
@@ -564,48 +678,134 @@ TxSearch::still_searching() const
 }
 
 void
-TxSearch::populate_known_outputs()
+TxSearch::populate_known_outputs(shared_ptr<MySqlAccounts>& accounts)
 {
-    vector<XmrOutput> outs;
-
-    if (xmr_accounts->select(acc->id.data, outs))
+    std::call_once(known_outputs_populated, [this, &accounts]()
     {
-        for (const XmrOutput& out: outs)
+        if (!accounts)
+            accounts = make_shared<MySqlAccounts>(current_bc_status);
+
+        // only threads which are running, i.e., were not just made
+        // for an account which already had one, own its outputs
+        // in the index
+        current_bc_status->get_known_outputs_index().acquire(acc->id.data);
+        known_outputs_acquired = true;
+
+        vector<XmrOutput> outs;
+
+        if (accounts->select(acc->id.data, outs))
         {
-            public_key out_pub_key;
+            for (const XmrOutput& out: outs)
+            {
+                public_key out_pub_key;
 
-            hex_to_pod(out.out_pub_key, out_pub_key);
+                hex_to_pod(out.out_pub_key, out_pub_key);
 
-            known_outputs_keys[out_pub_key] = out.amount;
+                current_bc_status->get_known_outputs_index().insert(
+                        out_pub_key,
+                        {acc->id.data, out.id.data, out.amount});
+            }
+
+            has_known_outputs = !outs.empty();
         }
+    });
+}
+
+void
+TxSearch::prepare_search()
+{
+    // creates an mysql connection for this thread
+    xmr_accounts = make_shared<MySqlAccounts>(current_bc_status);
+
+    // unless already done by find_txs_in_mempool
+    populate_known_outputs(xmr_accounts);
+
+    get_subaddresses();
+
+    vector<XmrTransaction> nonspendable_txs;
+
+    if (xmr_accounts->select_nonspendable_txs(acc->id.data, nonspendable_txs))
+    {
+        for (XmrTransaction const& tx: nonspendable_txs)
+            locked_txs[tx.hash] = {tx.id.data, tx.blockchain_tx_id,
+                                   tx.unlock_time, tx.height};
     }
 }
 
-TxSearch::known_outputs_t
-TxSearch::get_known_outputs_keys()
+SubaddressTable const*
+TxSearch::get_subaddresses()
 {
-    std::lock_guard<std::mutex> lck (getting_known_outputs_keys);
-    return known_outputs_keys;
-};
+    std::call_once(subaddresses_made, [this]()
+    {
+        BlockchainSetup const& bc_setup = current_bc_status->get_bc_setup();
+
+        subaddresses = std::make_unique<SubaddressTable const>(
+                    address, viewkey,
+                    bc_setup.subaddress_lookahead_major,
+                    bc_setup.subaddress_lookahead_minor);
+    });
+
+    return subaddresses.get();
+}
+
+std::shared_ptr<TxSearch::state_t const>
+TxSearch::get_state() const
+{
+    return std::atomic_load(&state);
+}
+
+std::shared_ptr<XmrAccount const>
+TxSearch::get_account() const
+{
+    return get_state()->account;
+}
+
+void
+TxSearch::search_mempool()
+{
+    std::shared_ptr<mempool_txs_t const> mempool_txs
+            = current_bc_status->get_mempool_txs_snapshot();
+
+    if (mempool_txs == get_state()->searched_mempool_txs)
+        return;
+
+    auto txs_found = std::make_shared<json const>(
+                find_txs_in_mempool(*mempool_txs));
+
+    update_state([&mempool_txs, &txs_found](state_t& new_state)
+                 {
+                     new_state.searched_mempool_txs = mempool_txs;
+                     new_state.txs_found_in_mempool = txs_found;
+                 });
+}
+
+std::shared_ptr<json const>
+TxSearch::get_txs_found_in_mempool() const
+{
+    return get_state()->txs_found_in_mempool;
+}
 
 json
-TxSearch::find_txs_in_mempool(
-        vector<pair<uint64_t, transaction>> mempool_txs)
+TxSearch::find_txs_in_mempool(mempool_txs_t const& mempool_txs)
 {
     json j_transactions = json::array();
 
     uint64_t current_height = current_bc_status->get_current_blockchain_height();
 
-    known_outputs_t known_outputs_keys_copy = get_known_outputs_keys();
-
     // since find_txs_in_mempool can be called outside of this thread,
     // we need to use local connection. we cant use connection that the
     // main search method is using, as we can end up wtih mysql errors
     // mysql will blow up when two queries are done at the same
     // time in a single connection.
     // so we create local connection here, only to be used in this method.
+    // the connection is made only when we find some of our inputs.
+
+    shared_ptr<MySqlAccounts> local_xmr_accounts;
 
-    shared_ptr<MySqlAccounts> local_xmr_accounts = make_shared<MySqlAccounts>(current_bc_status);
+    // if the search thread has not read outputs of the account
+    // into the known outputs index yet, e.g., right after login,
+    // they are read now. otherwise spends would not be found.
+    populate_known_outputs(local_xmr_accounts);
 
     for (const pair<uint64_t, transaction>& mtx: mempool_txs)
     {
@@ -621,7 +821,9 @@ TxSearch::find_txs_in_mempool(
         // and inputs in a given tx.
         OutputInputIdentification oi_identification {&address, &viewkey, &tx,
                                                      tx_hash, coinbase,
-                                                     current_bc_status};
+                                                     current_bc_status,
+                                                     nullptr,
+                                                     get_subaddresses()};
 
         // FIRSt step. to search for the incoming xmr, we use address, viewkey and
         // outputs public key.
@@ -649,7 +851,7 @@ TxSearch::find_txs_in_mempool(
                                         // just to indicate to frontend that this
                                         // tx is younger than 10 blocks so that
                                         // it shows unconfirmed message.
-            j_tx["payment_id"]     = current_bc_status->get_payment_id_as_string(tx);
+            j_tx["payment_id"]     = oi_identification.get_payment_id_str();
             j_tx["coinbase"]       = false; // mempool tx are not coinbase, so always false
             j_tx["is_rct"]         = oi_identification.is_rct;
             j_tx["rct_type"]       = oi_identification.rct_type;
@@ -664,7 +866,9 @@ TxSearch::find_txs_in_mempool(
 
         // no need mutex here, as this will be exectued only after
         // the above. there is no threads here.
-        oi_identification.identify_inputs(known_outputs_keys_copy);
+        oi_identification.identify_inputs(
+                current_bc_status->get_known_outputs_index(),
+                acc->id.data);
 
         if (!oi_identification.identified_inputs.empty())
         {
@@ -676,6 +880,11 @@ TxSearch::find_txs_in_mempool(
             json spend_keys;
             uint64_t total_sent {0};
 
+            if (!local_xmr_accounts)
+            {
+                local_xmr_accounts = make_shared<MySqlAccounts>(current_bc_status);
+            }
+
             for (auto& in_info: oi_identification.identified_inputs)
             {
                 // need to get output info from mysql, as we need
@@ -693,6 +902,7 @@ TxSearch::find_txs_in_mempool(
                           {"tx_pub_key", out.tx_pub_key},
                           {"out_index" , out.out_index},
                           {"mixin"     , out.mixin},
+                          {"subaddr_index", out.get_subaddr_index()},
                     });
                 }
             }
@@ -737,7 +947,7 @@ TxSearch::find_txs_in_mempool(
                                                         // just to indicate to frontend that this
                                                         // tx is younger than 10 blocks so that
                                                         // it shows unconfirmed message.
-                    j_tx["payment_id"]     = current_bc_status->get_payment_id_as_string(tx);
+                    j_tx["payment_id"]     = oi_identification.get_payment_id_str();
                     j_tx["coinbase"]       = false;     // mempool tx are not coinbase, so always false
                     j_tx["is_rct"]         = oi_identification.is_rct;
                     j_tx["rct_type"]       = oi_identification.rct_type;
@@ -763,7 +973,9 @@ TxSearch::find_txs_in_mempool(
 TxSearch::addr_view_t
 TxSearch::get_xmr_address_viewkey() const
 {
-    return make_pair(address, viewkey);
+    std::shared_ptr<state_t const> current_state = get_state();
+
+    return make_pair(current_state->address, current_state->viewkey);
 }
 
 
@@ -795,6 +1007,65 @@ TxSearch::delete_existing_tx_if_exists(string const& tx_hash)
     return true;
 }
 
+void
+TxSearch::publish_event(json const& event)
+{
+    shared_ptr<AccountEvents> account_events
+            = current_bc_status->get_account_events();
+
+    if (!account_events || !account_events->has_subscribers(acc->address))
+        return;
+
+    account_events->publish(acc->address, event);
+}
+
+void
+TxSearch::notify_about_unlocked_txs()
+{
+    for (auto it = locked_txs.begin(); it != locked_txs.end(); )
+    {
+        locked_tx_t const& locked_tx = it->second;
+
+        // as in MySqlAccounts::select_txs_for_spendability_check,
+        // tx whose block got orphaned is removed, and will be
+        // found again once it is in some other block.
+        uint64_t blockchain_tx_id {0};
+
+        current_bc_status->tx_exist(it->first, blockchain_tx_id);
+
+        if (blockchain_tx_id != locked_tx.blockchain_tx_id)
+        {
+            // zero rows deleted means that the spendability check
+            // of some request has already removed it
+            xmr_accounts->delete_tx(locked_tx.tx_id);
+
+            publish_event({{"event"  , "tx_orphaned"},
+                           {"hash"   , it->first},
+                           {"height" , locked_tx.height}});
+
+            it = locked_txs.erase(it);
+            continue;
+        }
+
+        if (!current_bc_status->is_tx_unlocked(locked_tx.unlock_time,
+                                               locked_tx.height))
+        {
+            ++it;
+            continue;
+        }
+
+        // zero rows changed means that the spendability check
+        // of some request has already marked it. either way it
+        // is no longer selected as nonspendable.
+        xmr_accounts->mark_tx_spendable(locked_tx.tx_id);
+
+        publish_event({{"event"  , "tx_unlocked"},
+                       {"hash"   , it->first},
+                       {"height" , locked_tx.height}});
+
+        it = locked_txs.erase(it);
+    }
+}
 
 // default value of static veriables
 uint64_t TxSearch::thread_search_life {600};
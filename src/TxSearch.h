@@ -34,9 +34,33 @@ class TxSearch
 {
 
 public:
-    //                                     out_pk   , amount
-    using known_outputs_t = std::unordered_map<public_key, uint64_t>;
     using addr_view_t = std::pair<address_parse_info, secret_key>;
+    using mempool_txs_t = vector<pair<uint64_t, transaction>>;
+
+    /**
+     * State of the search that is read outside of its thread,
+     * e.g., by REST handlers.
+     *
+     * A published state is never modified. Updates publish
+     * a new one, so readers dont block the search thread,
+     * and the search thread does not block the readers.
+     */
+    struct state_t
+    {
+        address_parse_info address;
+        secret_key viewkey;
+
+        // copy of the account's row in mysql's Accounts table,
+        // including its viewkey
+        std::shared_ptr<XmrAccount const> account;
+
+        // next block to be searched
+        uint64_t searched_blk_no {0};
+
+        // mempool searched last time, and our txs found in it
+        std::shared_ptr<mempool_txs_t const> searched_mempool_txs;
+        std::shared_ptr<json const> txs_found_in_mempool;
+    };
 
 private:
 
@@ -50,23 +74,14 @@ private:
 
     bool continue_search {true};
 
-    mutex getting_known_outputs_keys;
-
     uint64_t last_ping_timestamp;
 
-    atomic<uint64_t> searched_blk_no;
+    // only accessed using std::atomic_load and update_state
+    std::shared_ptr<state_t const> state {std::make_shared<state_t const>()};
 
     // represents a row in mysql's Accounts table
     shared_ptr<XmrAccount> acc;
 
-    // stores known output public keys.
-    // used as a cash to fast look up of
-    // our public keys in key images. Saves a lot of
-    // mysql queries to Outputs table.
-    //
-
-    known_outputs_t known_outputs_keys;
-
     // this manages all mysql queries
     // its better to when each thread has its own mysql connection object.
     // this way if one thread crashes, it want take down
@@ -79,6 +94,57 @@ private:
     address_parse_info address;
     secret_key viewkey;
 
+    // spend public keys of the address's subaddresses,
+    // used to identify outputs sent to them. deriving them
+    // takes a while, so they are made by get_subaddresses
+    // when first needed, rather than by the constructor.
+    std::unique_ptr<SubaddressTable const> subaddresses;
+    std::once_flag subaddresses_made;
+
+    // our txs which are not yet spendable. used to notify
+    // subscribed websockets when they unlock, after which
+    // they are marked spendable in mysql, so that search
+    // threads started later dont notify about them again.
+    // if their blocks get orphaned before, they are deleted.
+    struct locked_tx_t
+    {
+        uint64_t tx_id;       // id in Transactions table
+        uint64_t blockchain_tx_id;
+        uint64_t unlock_time;
+        uint64_t height;
+    };
+
+    //                 tx_hash
+    unordered_map<string, locked_tx_t> locked_txs;
+
+    // set once the thread acquired outputs of its account
+    // in the known outputs index
+    bool known_outputs_acquired {false};
+    std::once_flag known_outputs_populated;
+
+    // the account has outputs in the known outputs index,
+    // so its key images can be among ring members
+    bool has_known_outputs {false};
+
+    // publishes a copy of the current state changed by update.
+    // update can be called more than once, if other thread
+    // publishes its state first.
+    template <typename F>
+    void
+    update_state(F&& update);
+
+    // reads what the search needs from mysql and makes
+    // subaddresses. called by the search thread, so that
+    // creating TxSearch, e.g., in a request handler, does not
+    // run any queries or derive any keys.
+    void
+    prepare_search();
+
+    // can be called from any thread, e.g., by
+    // find_txs_in_mempool before the search started
+    SubaddressTable const*
+    get_subaddresses();
+
 public:
 
     // make default constructor. useful in testing
@@ -107,11 +173,33 @@ public:
     virtual bool
     still_searching() const;
 
+    // reads outputs of the account from mysql into the known
+    // outputs index, once. can be called from any thread, e.g.,
+    // by find_txs_in_mempool before the search started. accounts
+    // is the connection of the calling thread, made if null.
     virtual void
-    populate_known_outputs();
+    populate_known_outputs(shared_ptr<MySqlAccounts>& accounts);
 
-    virtual known_outputs_t
-    get_known_outputs_keys();
+    virtual std::shared_ptr<state_t const>
+    get_state() const;
+
+    // null if not searching for any account
+    virtual std::shared_ptr<XmrAccount const>
+    get_account() const;
+
+    /**
+     * Search for our txs in the current mempool, if it changed
+     * since the last search.
+     *
+     * Executed by the search thread, and txs found are
+     * published in its state for get_txs_found_in_mempool.
+     */
+    virtual void
+    search_mempool();
+
+    // null if the mempool was not searched yet
+    virtual std::shared_ptr<json const>
+    get_txs_found_in_mempool() const;
 
 
     /**
@@ -124,8 +212,8 @@ public:
      * it writes what it finds into database for permament storage.
      * However txs in mempool are not permament. Also since we want to
      * give the end user quick update on incoming/outging tx, this method
-     * will be executed whenever frontend wants. By default it is every
-     * 10 seconds.
+     * is executed by search_mempool whenever the mempool changes, and
+     * for new mempool txs pushed to websockets.
      * Also since we dont write here anything to the database, we
      * return a json that will be appended to json produced by get_address_tx
      * and similar function. The outputs here cant be spent anyway. This is
@@ -133,13 +221,13 @@ public:
      * to database later on by TxSearch thread when they will be added
      * to the blockchain.
      *
-     * we pass mempool_txs by copy because we want copy of mempool txs.
-     * to avoid worrying about synchronizing threads
+     * mempool_txs are snapshots which are not modified, so
+     * we dont need to copy them or synchronize threads over them.
      *
      * @return json
      */
     virtual json
-    find_txs_in_mempool(vector<pair<uint64_t, transaction>> mempool_txs);
+    find_txs_in_mempool(mempool_txs_t const& mempool_txs);
 
     virtual addr_view_t
     get_xmr_address_viewkey() const;
@@ -150,6 +238,19 @@ public:
     virtual bool
     delete_existing_tx_if_exists(string const& tx_hash);
 
+    /**
+     * Send an event to websockets subscribed to this account.
+     *
+     * Does nothing if there are no subscribers.
+     */
+    virtual void
+    publish_event(json const& event);
+
+    // marks locked txs which became spendable, and removes
+    // those whose blocks got orphaned
+    virtual void
+    notify_about_unlocked_txs();
+
     virtual ~TxSearch();
 
 };
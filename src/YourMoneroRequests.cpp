@@ -9,10 +9,18 @@
 
 #include "ssqlses.h"
 #include "OutputInputIdentification.h"
+#include "TxSearch.h"
+#include "ResponseWriter.h"
+
+#include <openssl/sha.h>
 
 namespace xmreg
 {
 
+constexpr uint64_t YourMoneroRequests::MAX_TXS_PAGE_SIZE;
+constexpr uint64_t YourMoneroRequests::MAX_ADDRESSES_IN_BATCH;
+constexpr uint64_t YourMoneroRequests::RESTORE_DATE_MARGIN;
+
 
 handel_::handel_(const fetch_func_t& callback):
         request_callback {callback}
@@ -31,7 +39,8 @@ handel_::operator()(const shared_ptr< Session > session)
 YourMoneroRequests::YourMoneroRequests(
         shared_ptr<MySqlAccounts> _acc, 
         shared_ptr<CurrentBlockchainStatus> _current_bc_status):
-    xmr_accounts {_acc}, current_bc_status {_current_bc_status}
+    xmr_accounts {_acc}, current_bc_status {_current_bc_status},
+    session_tokens {std::make_shared<SessionTokens>()}
 {
 
 }
@@ -47,7 +56,7 @@ YourMoneroRequests::login(const shared_ptr<Session> session, const Bytes & body)
 
     if (!parse_request(body, required_values, j_request, j_response))
     {
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
@@ -62,7 +71,18 @@ YourMoneroRequests::login(const shared_ptr<Session> session, const Bytes & body)
     catch (json::exception const& e)
     {
         cerr << "json exception: " << e.what() << '\n';
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
+        return;
+    }
+
+    account_public_address address;
+
+    if (!parse_address(xmr_address, address))
+    {
+        j_response = json {{"status", "error"},
+                           {"reason", "Cant parse address"}};
+
+        session_close(session, j_response);
         return;
     }
 
@@ -119,7 +139,7 @@ YourMoneroRequests::login(const shared_ptr<Session> session, const Bytes & body)
             j_response = json {{"status", "error"},
                                {"reason", "Account creation failed"}};
 
-            session_close(session, j_response.dump());
+            session_close(session, j_response);
             return;
         }
 
@@ -133,9 +153,11 @@ YourMoneroRequests::login(const shared_ptr<Session> session, const Bytes & body)
 
 
     // so by now new account has been created or it already exists
-    // so we just login into it.
+    // so we just login into it. login always checks the viewkey,
+    // so no session token here.
 
-    if (login_and_start_search_thread(xmr_address, view_key, acc, j_response))
+    if (login_and_start_search_thread(xmr_address, address, view_key,
+                                      string {}, acc, j_response))
     {
        // if successfuly logged in and created search thread
         j_response["status"]      = "success";
@@ -143,17 +165,27 @@ YourMoneroRequests::login(const shared_ptr<Session> session, const Bytes & body)
         // we overwrite what ever was sent in login_and_start_search_thread
         // for the j_response["new_address"].
         j_response["new_address"] = new_account_created;
+
+        // later requests can use the token instead of
+        // reading the account from mysql again
+        auto search_thread = current_bc_status->get_search_thread(address);
+
+        if (search_thread)
+        {
+            j_response["token"] = session_tokens->insert(xmr_address,
+                                                         search_thread);
+        }
     }
     else
     {
         // some error with loggin in or search thread start
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
 
-    } // else  if (login_and_start_search_thread(xmr_address,
+    } // else  if (login_and_start_search_thread(xmr_address, address,
 
 
-    session_close(session, j_response.dump());
+    session_close(session, j_response);
 }
 
 void
@@ -167,29 +199,27 @@ YourMoneroRequests::get_address_txs(
 
     if (!parse_request(body, requested_values, j_request, j_response))
     {
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
     string xmr_address;
     string view_key;
+    string token; // optional, issued by login
 
     try
     {
         xmr_address = j_request["address"];
         view_key    = j_request["view_key"];
+        token       = j_request.value("token", string {});
     }
     catch (json::exception const& e)
     {
         cerr << "json exception: " << e.what() << '\n';
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
-    // make hash of the submited viewkey. we only store
-    // hash of viewkey in database, not acctual viewkey.
-    string viewkey_hash = make_hash(view_key);
-
     // initialize json response
     j_response = json {
             {"total_received"         , 0},    // calculated in this function
@@ -202,164 +232,263 @@ YourMoneroRequests::get_address_txs(
             {"transactions"           , json::array()}
     };
 
+    account_public_address address;
+
+    if (!parse_address(xmr_address, address))
+    {
+        j_response = json {{"status", "error"},
+                           {"reason", "Cant parse address"}};
+
+        session_close(session, j_response);
+        return;
+    }
+
     // a placeholder for exciting or new account data
     xmreg::XmrAccount acc;
 
     // if not logged, i.e., no search thread exist, then start one.
-    if (login_and_start_search_thread(xmr_address, view_key, acc, j_response))
+    // before fetching txs, check if provided view key
+    // is correct. this is simply to ensure that
+    // we cant fetch an account's txs using only address.
+    // knowlage of the viewkey is also needed.
+    if (!login_and_start_search_thread(xmr_address, address, view_key,
+                                       token, acc, j_response))
     {
-        // before fetching txs, check if provided view key
-        // is correct. this is simply to ensure that
-        // we cant fetch an account's txs using only address.
-        // knowlage of the viewkey is also needed.
+        // some error with loggin in or search thread start
+        session_close(session, j_response);
+        return;
+    }
 
+    // limit and before_id are optional. if limit is given,
+    // only one page of txs is returned, newest first, and
+    // totals are taken from a summary query rather than
+    // summed up from all txs of the account.
+    uint64_t page_limit {0};
+    uint64_t before_id {std::numeric_limits<uint64_t>::max()};
 
+    try
+    {
+        if (j_request.count("limit"))
+            page_limit = j_request["limit"];
 
-        uint64_t total_received {0};
-        uint64_t total_received_unlocked {0};
+        if (j_request.count("before_id"))
+            before_id = j_request["before_id"];
+    }
+    catch (json::exception const& e)
+    {
+        cerr << "json exception: " << e.what() << '\n';
 
-        j_response["total_received"]          = total_received;
-        j_response["start_height"]            = acc.start_height;
-        j_response["scanned_block_height"]    = acc.scanned_block_height;
-        j_response["scanned_block_timestamp"] = static_cast<uint64_t>(
-                    acc.scanned_block_timestamp);
-        j_response["blockchain_height"]  = get_current_blockchain_height();
+        j_response = json {{"status", "error"},
+                           {"reason", "Wrong limit or before_id"}};
 
-        vector<XmrTransaction> txs;
+        session_close(session, j_response);
+        return;
+    }
 
-        xmr_accounts->select(acc.id.data, txs);
+    bool const paginated {page_limit > 0};
 
-        if (xmr_accounts->select_txs_for_account_spendability_check(
-                    acc.id.data, txs))
-        {
-            json j_txs = json::array();
+    uint64_t total_received {0};
+    uint64_t total_received_unlocked {0};
 
-            for (XmrTransaction const& tx: txs)
-            {
-                json j_tx {
-                        {"id"             , tx.blockchain_tx_id},
-                        {"coinbase"       , bool {tx.coinbase}},
-                        {"tx_pub_key"     , tx.tx_pub_key},
-                        {"hash"           , tx.hash},
-                        {"height"         , tx.height},
-                        {"mixin"          , tx.mixin},
-                        {"payment_id"     , tx.payment_id},
-                        {"unlock_time"    , tx.unlock_time},                  
-                        {"total_sent"     , 0}, // to be field when checking for spent_outputs below
-                        {"total_received" , tx.total_received},
-                        {"timestamp"      , static_cast<uint64_t>(tx.timestamp)},
-                        {"mempool"        , false} // tx in database are never from mempool
-                };
+    vector<XmrTransaction> txs;
 
-                vector<XmrInput> inputs;
+    bool txs_selected {false};
 
-                if (xmr_accounts->select_for_tx(tx.id.data, inputs))
-                {
-                    json j_spent_outputs = json::array();
+    if (paginated)
+    {
+        page_limit = std::min(page_limit, MAX_TXS_PAGE_SIZE);
+
+        // only txs younger than 10 blocks can change their
+        // spendable status or be removed due to reorgs. so check
+        // them first, so that the summary below is up to date.
+        vector<XmrTransaction> nonspendable_txs;
+
+        txs_selected = xmr_accounts->select_nonspendable_txs(
+                                acc.id.data, nonspendable_txs)
+                && xmr_accounts->select_txs_for_account_spendability_check(
+                                nonspendable_txs)
+                && xmr_accounts->get_txs_summary(
+                                acc.id.data, total_received,
+                                total_received_unlocked)
+                && xmr_accounts->select_txs_page(
+                                acc.id.data, before_id, page_limit, txs)
+                && xmr_accounts->select_txs_for_account_spendability_check(
+                                txs);
+    }
+    else
+    {
+        xmr_accounts->select(acc.id.data, txs);
 
-                    uint64_t total_spent {0};
+        txs_selected = xmr_accounts
+                ->select_txs_for_account_spendability_check(txs);
+    }
 
-                    for (XmrInput input: inputs)
-                    {
-                        XmrOutput out;
+    if (!txs_selected)
+        txs.clear();
 
-                        if (xmr_accounts->select_by_primary_id(
-                                    input.output_id, out))
-                        {
-                            total_spent += input.amount;
+    // txs found in mempool are appended to the txs from mysql.
+    // mempool txs are newest, so they go only into the first page.
+    json j_mempool_txs;
 
-                            j_spent_outputs.push_back({
-                              {"amount"     , input.amount},
-                              {"key_image"  , input.key_image},
-                              {"tx_pub_key" , out.tx_pub_key},
-                              {"out_index"  , out.out_index},
-                              {"mixin"      , out.mixin}});
-                        }
-                    }
+    if (!j_request.count("before_id"))
+    {
+        current_bc_status->find_txs_in_mempool(address, j_mempool_txs);
+    }
 
-                    j_tx["total_sent"] = total_spent;
+    // the response can have thousands of txs, so it is written
+    // directly into a buffer as txs are processed, rather than
+    // built as json tree first.
+    ResponseWriter writer {get_response_encoding(session->get_request())};
 
-                    j_tx["spent_outputs"] = j_spent_outputs;
+    writer.begin_object()
+          .key("status").value(j_response["status"])
+          .key("new_address").value(j_response["new_address"])
+          .key("scanned_height").value(0)   // not used. just to match mymonero
+          .key("scanned_block_height").value(acc.scanned_block_height)
+          .key("scanned_block_timestamp")
+                .value(static_cast<uint64_t>(acc.scanned_block_timestamp))
+          .key("start_height").value(acc.start_height)
+          .key("blockchain_height").value(get_current_blockchain_height());
 
-                } // if (xmr_accounts->select_inputs_for_tx(tx.id, inputs))
+    writer.key("transactions").begin_array();
 
-                total_received += tx.total_received;
+    // get last tx id (i.e., index) so that we can
+    // set some ids for the mempool txs. These ids are
+    // used for sorting in the frontend. Since we want mempool
+    // tx to be first, they need to be higher than last_tx_id_db
+    uint64_t last_tx_id_db {0};
 
-                if (bool {tx.spendable})
-                {
-                    total_received_unlocked += tx.total_received;
-                }
+    // inputs of all the txs and outputs spent by them are
+    // fetched with two queries, rather than a few per tx
+    vector<uint64_t> tx_ids;
+    tx_ids.reserve(txs.size());
 
-                j_txs.push_back(j_tx);
+    for (XmrTransaction const& tx: txs)
+        tx_ids.push_back(tx.id.data);
 
-            } // for (XmrTransaction tx: txs)
+    vector<XmrInput> inputs;
+    vector<XmrOutput> spent_outputs;
 
-            j_response["total_received"]          = total_received;
-            j_response["total_received_unlocked"] = total_received_unlocked;
+    bool inputs_selected
+            = xmr_accounts->select_inputs_for_txs(tx_ids, inputs);
 
-            j_response["transactions"] = j_txs;
+    if (inputs_selected)
+    {
+        vector<uint64_t> output_ids;
+        output_ids.reserve(inputs.size());
 
-        } // if (xmr_accounts->select_txs_for_ac
+        for (XmrInput const& input: inputs)
+            output_ids.push_back(input.output_id);
 
-    } // if (login_and_start_search_thread(xmr
-    else
-    {
-        // some error with loggin in or search thread start
-        session_close(session, j_response.dump());
-        return;
+        inputs_selected = xmr_accounts->select_outputs_by_ids(
+                                output_ids, spent_outputs);
     }
 
-    // append txs found in mempool to the json returned
+    unordered_map<uint64_t, XmrOutput const*> outputs_by_id;
 
-    json j_mempool_tx;
+    for (XmrOutput const& out: spent_outputs)
+        outputs_by_id[out.id.data] = &out;
 
-    if (current_bc_status->find_txs_in_mempool(
-            xmr_address, j_mempool_tx))
+    //            tx_id, its inputs
+    unordered_map<uint64_t, vector<XmrInput const*>> inputs_by_tx;
+
+    for (XmrInput const& input: inputs)
+        inputs_by_tx[input.tx_id].push_back(&input);
+
+    for (XmrTransaction const& tx: txs)
     {
-        if(!j_mempool_tx.empty())
+        writer.begin_object()
+              .key("id").value(tx.blockchain_tx_id)
+              .key("coinbase").value(bool {tx.coinbase})
+              .key("tx_pub_key").value(tx.tx_pub_key)
+              .key("hash").value(tx.hash)
+              .key("height").value(tx.height)
+              .key("mixin").value(tx.mixin)
+              .key("payment_id").value(tx.payment_id)
+              .key("unlock_time").value(tx.unlock_time)
+              .key("total_received").value(tx.total_received)
+              .key("timestamp").value(static_cast<uint64_t>(tx.timestamp))
+              .key("mempool").value(false); // tx in database are never from mempool
+
+        uint64_t total_spent {0};
+
+        if (inputs_selected)
         {
-            uint64_t total_received_mempool {0};
-            uint64_t total_sent_mempool {0};
+            writer.key("spent_outputs").begin_array();
 
-            // get last tx id (i.e., index) so that we can
-            // set some ids for the mempool txs. These ids are
-            // used for sorting in the frontend. Since we want mempool
-            // tx to be first, they need to be higher than last_tx_id_db
-            uint64_t last_tx_id_db {0};
+            auto tx_inputs = inputs_by_tx.find(tx.id.data);
 
-            if (!j_response["transactions"].empty())
+            if (tx_inputs != inputs_by_tx.end())
             {
-                last_tx_id_db = j_response["transactions"].back()["id"];
-            }
+                for (XmrInput const* input: tx_inputs->second)
+                {
+                    auto out_it = outputs_by_id.find(input->output_id);
 
-            for (json& j_tx: j_mempool_tx)
-            {
-                //cout << "mempool j_tx[\"total_received\"]: "
-                //     << j_tx["total_received"] << endl;
+                    if (out_it == outputs_by_id.end())
+                        continue;
 
-                j_tx["id"] = ++last_tx_id_db;
+                    XmrOutput const& out = *(out_it->second);
 
-                total_received_mempool += j_tx["total_received"].get<uint64_t>();
-                total_sent_mempool     += j_tx["total_sent"].get<uint64_t>();
+                    total_spent += input->amount;
 
-                j_response["transactions"].push_back(j_tx);
+                    writer.begin_object()
+                          .key("amount").value(input->amount)
+                          .key("key_image").value(input->key_image)
+                          .key("tx_pub_key").value(out.tx_pub_key)
+                          .key("out_index").value(out.out_index)
+                          .key("mixin").value(out.mixin)
+                          .key("subaddr_index").value(out.get_subaddr_index())
+                          .end_object();
+                }
             }
 
-            j_response["total_received"]
-                    = j_response["total_received"].get<uint64_t>()
-                                           + total_received_mempool;
+            writer.end_array();
+
+        } // if (inputs_selected)
+
+        writer.key("total_sent").value(total_spent)
+              .end_object();
+
+        if (!paginated)
+        {
+            total_received += tx.total_received;
+
+            if (bool {tx.spendable})
+            {
+                total_received_unlocked += tx.total_received;
+            }
         }
 
+        last_tx_id_db = std::max<uint64_t>(last_tx_id_db,
+                                           tx.blockchain_tx_id);
+
+    } // for (XmrTransaction tx: txs)
+
+    for (json& j_tx: j_mempool_txs)
+    {
+        j_tx["id"] = ++last_tx_id_db;
+
+        total_received += j_tx["total_received"].get<uint64_t>();
+
+        writer.value(j_tx);
     }
 
-    string response_body = j_response.dump();
+    writer.end_array();
 
-    auto response_headers = make_headers({{ "Content-Length",
-                                            to_string(response_body.size())}});
+    writer.key("total_received").value(total_received)
+          .key("total_received_unlocked").value(total_received_unlocked);
 
-    session->close(OK, response_body, response_headers);
+    // full page means that there can be more txs. the cursor
+    // is "id" of the oldest tx in this page, i.e., its blockchain_tx_id.
+    if (paginated && !txs.empty() && txs.size() == page_limit)
+        writer.key("next_before_id").value(txs.back().blockchain_tx_id);
+
+    writer.end_object();
+
+    session_close(session, writer);
 }
 
+
 void
 YourMoneroRequests::get_address_info(
         const shared_ptr< Session > session, const Bytes & body)
@@ -371,29 +500,27 @@ YourMoneroRequests::get_address_info(
 
     if (!parse_request(body, requested_values, j_request, j_response))
     {
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
     string xmr_address;
     string view_key;
+    string token; // optional, issued by login
 
     try
     {
         xmr_address = j_request["address"];
         view_key    = j_request["view_key"];
+        token       = j_request.value("token", string {});
     }
     catch (json::exception const& e)
     {
         cerr << "json exception: " << e.what() << '\n';
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
-    // make hash of the submited viewkey. we only store
-    // hash of viewkey in database, not acctual viewkey.
-    string viewkey_hash = make_hash(view_key);
-
     j_response = json {
             {"locked_funds"           , 0},    // locked xmr (e.g., younger than 10 blocks)
             {"total_received"         , 0},    // calculated in this function
@@ -410,23 +537,35 @@ YourMoneroRequests::get_address_info(
                                                // only client has spent key
     };
 
+    account_public_address address;
+
+    if (!parse_address(xmr_address, address))
+    {
+        j_response = json {{"status", "error"},
+                           {"reason", "Cant parse address"}};
+
+        session_close(session, j_response);
+        return;
+    }
+
     // a placeholder for exciting or new account data
     xmreg::XmrAccount acc;
 
     // select this account if its existing one
-    if (login_and_start_search_thread(xmr_address, view_key, acc, j_response))
+    if (login_and_start_search_thread(xmr_address, address, view_key,
+                                      token, acc, j_response))
     {
 
         uint64_t total_received {0};
 
         // ping the search thread that we still need it.
         // otherwise it will finish after some time.
-        current_bc_status->ping_search_thread(xmr_address);
+        current_bc_status->ping_search_thread(address);
 
         uint64_t current_searched_blk_no {0};
 
         if (current_bc_status->get_searched_blk_no(
-                    xmr_address, current_searched_blk_no))
+                    address, current_searched_blk_no))
         {
             // if current_searched_blk_no is higher than what is in mysql, update it
             // in the search thread. This may occure when manually editing scanned_block_height
@@ -436,7 +575,7 @@ YourMoneroRequests::get_address_info(
             if (current_searched_blk_no > acc.scanned_block_height + 10)
             {
                 current_bc_status->set_new_searched_blk_no(
-                            xmr_address, acc.scanned_block_height);
+                            address, acc.scanned_block_height);
             }
         }
 
@@ -457,8 +596,7 @@ YourMoneroRequests::get_address_info(
         // now, filter out or updated transactions from txs vector that no
         // longer exisit in the recent blocks. Update is done to check for their
         // spendability status.
-        if (xmr_accounts->select_txs_for_account_spendability_check(
-                    acc.id.data, txs))
+        if (xmr_accounts->select_txs_for_account_spendability_check(txs))
         {
             json j_spent_outputs = json::array();
 
@@ -484,6 +622,7 @@ YourMoneroRequests::get_address_info(
                                     {"tx_pub_key" , out.tx_pub_key},
                                     {"out_index"  , out.out_index},
                                     {"mixin"      , out.mixin},
+                                    {"subaddr_index", out.get_subaddr_index()},
                                 });
 
                                 total_sent += in.amount;
@@ -504,22 +643,323 @@ YourMoneroRequests::get_address_info(
 
             j_response["spent_outputs"]  = j_spent_outputs;
 
-        } // if (xmr_accounts->select_txs_for_account_spendability_check(acc.id, txs))
+        } // if (xmr_accounts->select_txs_for_account_spendability_check(txs))
 
-    } //  if (login_and_start_search_thread(xmr_address, view_key, acc, j_response))
+    } //  if (login_and_start_search_thread(xmr_address, address, view_key, acc, j_response))
     else
     {
         // some error with loggin in or search thread start
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
+        return;
+    }
+
+    session_close(session, j_response);
+}
+
+
+void
+YourMoneroRequests::get_addresses_info(
+        const shared_ptr< Session > session, const Bytes & body)
+{
+    json j_response;
+    json j_request;
+
+    vector<string> requested_values {"accounts"};
+
+    if (!parse_request(body, requested_values, j_request, j_response))
+    {
+        session_close(session, j_response);
+        return;
+    }
+
+    // accounts as requested by the frontend
+    vector<string> xmr_addresses;
+    vector<string> view_keys;
+
+    //      index in xmr_addresses, cursor
+    vector<pair<size_t, uint64_t>> requested_cursors;
+
+    try
+    {
+        json const& j_accounts = j_request["accounts"];
+
+        if (!j_accounts.is_array() || j_accounts.empty()
+                || j_accounts.size() > MAX_ADDRESSES_IN_BATCH)
+        {
+            j_response = json {{"status", "error"},
+                               {"reason", "accounts must be non-empty array "
+                                          "with at most "
+                                          + to_string(MAX_ADDRESSES_IN_BATCH)
+                                          + " elements"}};
+
+            session_close(session, j_response);
+            return;
+        }
+
+        for (json const& j_account: j_accounts)
+        {
+            xmr_addresses.push_back(j_account.at("address").get<string>());
+            view_keys.push_back(j_account.at("view_key").get<string>());
+
+            if (j_account.count("cursor"))
+            {
+                requested_cursors.emplace_back(
+                            xmr_addresses.size() - 1,
+                            j_account["cursor"].get<uint64_t>());
+            }
+        }
+    }
+    catch (json::exception const& e)
+    {
+        cerr << "json exception: " << e.what() << '\n';
+
+        j_response = json {{"status", "error"},
+                           {"reason", "Each account must have address, "
+                                      "view_key and optional cursor"}};
+
+        session_close(session, j_response);
+        return;
+    }
+
+    // one query to get all the accounts
+    vector<XmrAccount> accounts;
+
+    if (!xmr_accounts->select(xmr_addresses, accounts))
+    {
+        j_response = json {{"status", "error"},
+                           {"reason", "Failed to select accounts"}};
+
+        session_close(session, j_response);
+        return;
+    }
+
+    unordered_map<string, XmrAccount*> accounts_by_address;
+
+    for (XmrAccount& acc: accounts)
+        accounts_by_address[acc.address] = &acc;
+
+    json j_accounts = json::array();
+
+    // accounts which passed viewkey check.
+    //        account_id, index in j_accounts
+    unordered_map<uint64_t, size_t> verified_accounts;
+    vector<uint64_t> account_ids;
+
+    for (size_t i = 0; i < xmr_addresses.size(); ++i)
+    {
+        json j_account {{"address", xmr_addresses[i]}};
+
+        auto it = accounts_by_address.find(xmr_addresses[i]);
+
+        if (it == accounts_by_address.end())
+        {
+            j_account["status"] = "error";
+            j_account["reason"] = "Account does not exist. Login first";
+
+            j_accounts.push_back(j_account);
+            continue;
+        }
+
+        XmrAccount& acc = *(it->second);
+
+        if (verified_accounts.count(acc.id.data))
+        {
+            j_account["status"] = "error";
+            j_account["reason"] = "Duplicate address";
+
+            j_accounts.push_back(j_account);
+            continue;
+        }
+
+        account_public_address address;
+
+        if (!parse_address(xmr_addresses[i], address))
+        {
+            j_account["status"] = "error";
+            j_account["reason"] = "Cant parse address";
+
+            j_accounts.push_back(j_account);
+            continue;
+        }
+
+        json j_status;
+
+        try
+        {
+            if (!verify_viewkey_and_start_search_thread(
+                        view_keys[i], address, acc, j_status))
+            {
+                j_account["status"] = j_status["status"];
+                j_account["reason"] = j_status["reason"];
+
+                j_accounts.push_back(j_account);
+                continue;
+            }
+        }
+        catch (std::exception const& e)
+        {
+            // TxSearch constructor throws for malformed
+            // addresses and viewkeys
+            OMERROR << xmr_addresses[i] << ": " << e.what();
+
+            j_account["status"] = "error";
+            j_account["reason"] = "Failed created search "
+                                  "thread for this account";
+
+            j_accounts.push_back(j_account);
+            continue;
+        }
+
+        // ping the search thread that we still need it.
+        // otherwise it will finish after some time.
+        current_bc_status->ping_search_thread(address);
+
+        j_account["status"]                  = "success";
+        j_account["total_received"]          = 0;
+        j_account["total_received_unlocked"] = 0;
+        j_account["total_sent"]              = 0;
+        j_account["start_height"]            = acc.start_height;
+        j_account["scanned_block_height"]    = acc.scanned_block_height;
+        j_account["scanned_block_timestamp"]
+                = static_cast<uint64_t>(acc.scanned_block_timestamp);
+        j_account["cursor"]                  = 0;
+        j_account["spent_outputs"]           = json::array();
+
+        verified_accounts[acc.id.data] = j_accounts.size();
+        account_ids.push_back(acc.id.data);
+
+        j_accounts.push_back(j_account);
+    }
+
+    // now fetch data of all verified accounts. as in
+    // get_address_txs, only nonspendable txs need to be checked
+    // for spendability and reorgs before summing up the totals.
+
+    vector<XmrTransaction> nonspendable_txs;
+    unordered_map<uint64_t, XmrTxsSummary> summaries;
+    vector<XmrInput> inputs;
+    vector<XmrOutput> spent_outputs;
+
+    bool data_selected = xmr_accounts->select_nonspendable_txs(
+                                account_ids, nonspendable_txs)
+            && xmr_accounts->select_txs_for_spendability_check(
+                                nonspendable_txs)
+            && xmr_accounts->get_txs_summaries(account_ids, summaries)
+            && xmr_accounts->select_inputs_for_accounts(account_ids, inputs);
+
+    if (data_selected)
+    {
+        vector<uint64_t> output_ids;
+        output_ids.reserve(inputs.size());
+
+        for (XmrInput const& input: inputs)
+            output_ids.push_back(input.output_id);
+
+        data_selected = xmr_accounts->select_outputs_by_ids(
+                                output_ids, spent_outputs);
+    }
+
+    vector<XmrTransaction> new_txs;
+
+    if (data_selected && !requested_cursors.empty())
+    {
+        vector<pair<uint64_t, uint64_t>> account_cursors;
+
+        for (auto const& requested_cursor: requested_cursors)
+        {
+            auto it = accounts_by_address.find(
+                        xmr_addresses[requested_cursor.first]);
+
+            if (it == accounts_by_address.end()
+                    || !verified_accounts.count(it->second->id.data))
+                continue;
+
+            uint64_t account_id = it->second->id.data;
+
+            account_cursors.emplace_back(account_id, requested_cursor.second);
+
+            j_accounts[verified_accounts[account_id]]["transactions"]
+                    = json::array();
+        }
+
+        data_selected = xmr_accounts->select_txs_after(account_cursors,
+                                                       new_txs);
+    }
+
+    if (!data_selected)
+    {
+        j_response = json {{"status", "error"},
+                           {"reason", "Failed to select accounts' data"}};
+
+        session_close(session, j_response);
         return;
     }
 
-    string response_body = j_response.dump();
+    for (auto const& summary: summaries)
+    {
+        json& j_account = j_accounts[verified_accounts[summary.first]];
+
+        j_account["total_received"]   = summary.second.total_received;
+        j_account["total_received_unlocked"]
+                = summary.second.total_received_unlocked;
+        j_account["cursor"]           = summary.second.last_tx_id;
+    }
+
+    unordered_map<uint64_t, XmrOutput const*> outputs_by_id;
+
+    for (XmrOutput const& out: spent_outputs)
+        outputs_by_id[out.id.data] = &out;
+
+    for (XmrInput const& input: inputs)
+    {
+        auto out_it = outputs_by_id.find(input.output_id);
+
+        if (out_it == outputs_by_id.end())
+            continue;
+
+        XmrOutput const& out = *(out_it->second);
+
+        json& j_account = j_accounts[verified_accounts[input.account_id]];
+
+        j_account["spent_outputs"].push_back({
+            {"amount"     , input.amount},
+            {"key_image"  , input.key_image},
+            {"tx_pub_key" , out.tx_pub_key},
+            {"out_index"  , out.out_index},
+            {"mixin"      , out.mixin},
+            {"subaddr_index", out.get_subaddr_index()},
+        });
+
+        j_account["total_sent"] = j_account["total_sent"].get<uint64_t>()
+                                  + input.amount;
+    }
+
+    for (XmrTransaction const& tx: new_txs)
+    {
+        json& j_account = j_accounts[verified_accounts[tx.account_id]];
+
+        j_account["transactions"].push_back({
+                {"id"             , tx.blockchain_tx_id},
+                {"coinbase"       , bool {tx.coinbase}},
+                {"tx_pub_key"     , tx.tx_pub_key},
+                {"hash"           , tx.hash},
+                {"height"         , tx.height},
+                {"mixin"          , tx.mixin},
+                {"payment_id"     , tx.payment_id},
+                {"unlock_time"    , tx.unlock_time},
+                {"total_received" , tx.total_received},
+                {"spendable"      , bool {tx.spendable}},
+                {"timestamp"      , static_cast<uint64_t>(tx.timestamp)}
+        });
+    }
 
-    auto response_headers = make_headers({{ "Content-Length",
-                                            to_string(response_body.size())}});
+    j_response = json {
+            {"status"           , "success"},
+            {"blockchain_height", get_current_blockchain_height()},
+            {"accounts"         , j_accounts}
+    };
 
-    session->close( OK, response_body, response_headers);
+    session_close(session, j_response);
 }
 
 
@@ -536,12 +976,13 @@ YourMoneroRequests::get_unspent_outs(
 
     if (!parse_request(body, requested_values, j_request, j_response))
     {
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
     string xmr_address;
     string view_key;
+    string token; // optional, issued by login
     uint64_t mixin {4};
     bool use_dust {false};
     uint64_t dust_threshold {1000000000};
@@ -551,6 +992,7 @@ YourMoneroRequests::get_unspent_outs(
     {
         xmr_address = j_request["address"];
         view_key    = j_request["view_key"];
+        token       = j_request.value("token", string {});
 
         mixin       = j_request["mixin"];
         use_dust    = j_request["use_dust"];
@@ -563,20 +1005,16 @@ YourMoneroRequests::get_unspent_outs(
     catch (json::exception const& e)
     {
         cerr << "json exception: " << e.what() << '\n';
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
     catch (boost::bad_lexical_cast const& e)
     {
         cerr << "Bed lexical cast" << e.what() << '\n';
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
-    // make hash of the submited viewkey. we only store
-    // hash of viewkey in database, not acctual viewkey.
-    string viewkey_hash = make_hash(view_key);
-
     j_response = json  {
             {"amount" , 0},            // total value of the outputs
             {"outputs", json::array()} // list of outputs
@@ -584,11 +1022,23 @@ YourMoneroRequests::get_unspent_outs(
                                        // no of confirmation
     };
 
+    account_public_address address;
+
+    if (!parse_address(xmr_address, address))
+    {
+        j_response = json {{"status", "error"},
+                           {"reason", "Cant parse address"}};
+
+        session_close(session, j_response);
+        return;
+    }
+
     // a placeholder for exciting or new account data
     xmreg::XmrAccount acc;
 
     // select this account if its existing one
-    if (login_and_start_search_thread(xmr_address, view_key, acc, j_response))
+    if (login_and_start_search_thread(xmr_address, address, view_key,
+                                      token, acc, j_response))
     {
         uint64_t total_outputs_amount {0};
 
@@ -668,7 +1118,8 @@ YourMoneroRequests::get_unspent_outs(
                                 {"tx_id"           , out.tx_id},
                                 {"tx_hash"         , tx.hash},
                                 {"tx_prefix_hash"  , tx.prefix_hash},
-                                {"tx_pub_key"      , tx.tx_pub_key},
+                                {"tx_pub_key"      , out.tx_pub_key},
+                                {"subaddr_index"   , out.get_subaddr_index()},
                                 {"timestamp"       , static_cast<uint64_t>(
                                             out.timestamp)},
                                 {"height"          , tx.height},
@@ -711,21 +1162,16 @@ YourMoneroRequests::get_unspent_outs(
                 ->get_dynamic_per_kb_fee_estimate();
 
 
-    } // if (login_and_start_search_thread(xmr_address, view_key, acc, j_response))
+    } // if (login_and_start_search_thread(xmr_address, address, view_key, acc, j_response))
     else
     {
         // some error with loggin in or search thread start
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
 
     }
 
-    string response_body = j_response.dump();
-
-    auto response_headers = make_headers({{ "Content-Length",
-                                            to_string(response_body.size())}});
-
-    session->close( OK, response_body, response_headers);
+    session_close(session, j_response);
 }
 
 void
@@ -739,7 +1185,7 @@ YourMoneroRequests::get_random_outs(
 
     if (!parse_request(body, requested_values, j_request, j_response))
     {
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
@@ -752,7 +1198,7 @@ YourMoneroRequests::get_random_outs(
     catch (json::exception const& e)
     {
         cerr << "json exception: " << e.what() << '\n';
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     };
 
@@ -762,7 +1208,7 @@ YourMoneroRequests::get_random_outs(
         j_response["status"] = "error";
         j_response["error"]  = fmt::format("Request ring size {:d} too large",
                                            count);
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
     }
 
     vector<uint64_t> amounts;
@@ -780,35 +1226,39 @@ YourMoneroRequests::get_random_outs(
     catch (boost::bad_lexical_cast& e)
     {
         cerr << "Bed lexical cast" << '\n';
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
     vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount>
             found_outputs;
 
-    if (current_bc_status->get_random_outputs(amounts, count, found_outputs))
+    vector<vector<tuple<string, string, string>>> rct_fields;
+
+    if (current_bc_status->get_random_outputs(amounts, count, found_outputs)
+            && current_bc_status->construct_output_rct_fields(
+                    found_outputs, rct_fields))
     {
         json& j_amount_outs = j_response["amount_outs"];
 
-        for (const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS
-             ::outs_for_amount& outs: found_outputs)
+        for (size_t i = 0; i < found_outputs.size(); ++i)
         {
+            const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS
+                 ::outs_for_amount& outs = found_outputs[i];
+
             json j_outs {{"amount", outs.amount},
                          {"outputs", json::array()}};
 
 
             json& j_outputs = j_outs["outputs"];
 
-            for (const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS
-                 ::out_entry& out: outs.outs)
+            for (size_t j = 0; j < outs.outs.size(); ++j)
             {
-                uint64_t global_amount_index = out.global_amount_index;
+                const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS
+                     ::out_entry& out = outs.outs[j];
 
-                tuple<string, string, string>
-                        rct_field = current_bc_status
-                            ->construct_output_rct_field(
-                                    global_amount_index, outs.amount);
+                tuple<string, string, string> const& rct_field
+                        = rct_fields[i][j];
 
                 string rct = std::get<0>(rct_field)    // rct_pk
                              + std::get<1>(rct_field)  // rct_mask
@@ -822,11 +1272,11 @@ YourMoneroRequests::get_random_outs(
 
                 j_outputs.push_back(out_details);
 
-            } // for (const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AM
+            } // for (size_t j = 0; j < outs.outs.size(); ++j)
 
             j_amount_outs.push_back(j_outs);
 
-        } // for (const COMMAND_RPC_GET_RANDOM_OUTPUTS_
+        } // for (size_t i = 0; i < found_outputs.size(); ++i)
 
     } // if (current_bc_status->get_random_outputs(amounts,
     else
@@ -836,12 +1286,7 @@ YourMoneroRequests::get_random_outs(
                                            "outputs from monero deamon");
     }
 
-    string response_body = j_response.dump();
-
-    auto response_headers = make_headers({{ "Content-Length",
-                                            to_string(response_body.size())}});
-
-    session->close( OK, response_body, response_headers);
+    session_close(session, j_response);
 }
 
 
@@ -873,11 +1318,11 @@ YourMoneroRequests::submit_raw_tx(
 
     std::string tx_blob;
 
-    if(!epee::string_tools::parse_hexstr_to_binbuff(raw_tx_blob, tx_blob))
+    if(!hex_to_buff(raw_tx_blob, tx_blob))
     {
         j_response["status"] = "error";
         j_response["error"]  = "Tx faild parse_hexstr_to_binbuff";
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
@@ -887,7 +1332,7 @@ YourMoneroRequests::submit_raw_tx(
     {
         j_response["status"] = "error";
         j_response["error"]  = "Tx faild parse_and_validate_tx_from_blob";
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
@@ -898,7 +1343,7 @@ YourMoneroRequests::submit_raw_tx(
                                "in the mempool. "
                                "Please wait till your previous tx(s) "
                                "get mined";
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
@@ -908,19 +1353,14 @@ YourMoneroRequests::submit_raw_tx(
     {
         j_response["status"] = "error";
         j_response["error"]  = error_msg;
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
     j_response["status"] = "success";
 
 
-    string response_body = j_response.dump();
-
-    auto response_headers = make_headers({{ "Content-Length",
-                                            to_string(response_body.size())}});
-
-    session->close( OK, response_body, response_headers);
+    session_close(session, j_response);
 }
 
 void
@@ -929,8 +1369,6 @@ YourMoneroRequests::import_wallet_request(
 {
     json j_request = body_to_json(body);
 
-    string xmr_address   = j_request["address"];
-
     json j_response;
 
     j_response["request_fulfilled"] = false;
@@ -939,14 +1377,70 @@ YourMoneroRequests::import_wallet_request(
     j_response["status"] = "error";
     j_response["error"]  = "Some error occured";
 
-    // if current_bc_status-> is zero, we just import the wallet.
-    // we dont care about any databases or anything, as importin all
-    // wallet is free.
-    // just reset the scanned block height in mysql and finish.
-    if (current_bc_status->get_bc_setup().import_fee == 0)
+    // whole blockchain is scanned, unless restore_date (YYYY-MM-DD)
+    // is given. then scanning starts from the first block which
+    // could be mined on that date, found in the block timestamp
+    // index. the date can be given with any of the requests,
+    // including the one after the import fee is paid.
+    bool const from_restore_date = j_request.count("restore_date") > 0;
+
+    string xmr_address;
+    string restore_date;
+
+    try
     {
-        // change search blk number in the search thread
-        if (!current_bc_status->set_new_searched_blk_no(xmr_address, 0))
+        xmr_address = j_request["address"];
+
+        if (from_restore_date)
+            restore_date = j_request["restore_date"];
+    }
+    catch (json::exception const& e)
+    {
+        cerr << "json exception: " << e.what() << '\n';
+        session_close(session, j_response);
+        return;
+    }
+
+    uint64_t restore_height {0};
+
+    if (from_restore_date)
+    {
+        string error_msg;
+
+        if (!get_restore_height(restore_date, restore_height, error_msg))
+        {
+            cerr << error_msg << '\n';
+
+            j_response["error"] = error_msg;
+            session_close(session, j_response);
+            return;
+        }
+    }
+
+    account_public_address address;
+
+    if (!parse_address(xmr_address, address))
+    {
+        j_response["error"] = "Cant parse address";
+        session_close(session, j_response);
+        return;
+    }
+
+    // if current_bc_status-> is zero, we just import the wallet.
+    // we dont care about any databases or anything, as importin all
+    // wallet is free.
+    // just reset the scanned block height in mysql and finish.
+    if (current_bc_status->get_bc_setup().import_fee == 0)
+    {
+        uint64_t searched_blk_no {0};
+
+        // change search blk number in the search thread. only
+        // backward, as later blocks will be scanned anyway.
+        if (!current_bc_status->get_searched_blk_no(address,
+                                                    searched_blk_no)
+                || (restore_height < searched_blk_no
+                    && !current_bc_status->set_new_searched_blk_no(
+                            address, restore_height)))
         {
             cerr << "Updating searched_blk_no failed!" << endl;
             j_response["error"] = "Updating searched_blk_no failed!";
@@ -957,13 +1451,7 @@ YourMoneroRequests::import_wallet_request(
         j_response["new_request"]       = true;
         j_response["error"]             = "";
 
-        string response_body = j_response.dump();
-
-        auto response_headers
-                = make_headers({{ "Content-Length",
-                                         to_string(response_body.size())}});
-
-        session->close( OK, response_body, response_headers);
+        session_close(session, j_response);
 
         return;
     }
@@ -975,12 +1463,7 @@ YourMoneroRequests::import_wallet_request(
         cerr << "xmr_address does not exists! " << endl;
         j_response["error"] = "The account does not exists!";
 
-        string response_body = j_response.dump();
-        auto response_headers
-                = make_headers({{ "Content-Length",
-                                     to_string(response_body.size())}});
-
-        session->close( OK, response_body, response_headers);
+        session_close(session, j_response);
         return;
     }
 
@@ -1001,12 +1484,7 @@ YourMoneroRequests::import_wallet_request(
             cerr << "More than one payment record found! " << endl;
             j_response["error"] = "TMore than one payment record found!";
 
-            string response_body = j_response.dump();
-            auto response_headers
-                    = make_headers({{ "Content-Length",
-                                      to_string(response_body.size())}});
-
-            session->close( OK, response_body, response_headers);
+            session_close(session, j_response);
             return;
         }
 
@@ -1056,16 +1534,34 @@ YourMoneroRequests::import_wallet_request(
                     {
                         XmrAccount updated_acc = acc;
 
-                        updated_acc.scanned_block_height = 0;
+                        // as in import_recent_wallet_request, scanning
+                        // is only moved backward, and start_height
+                        // is never moved forward.
+                        bool const move_scanning_back
+                                = restore_height
+                                  < updated_acc.scanned_block_height;
+
+                        if (move_scanning_back)
+                        {
+                            updated_acc.scanned_block_height
+                                    = restore_height;
+                            updated_acc.start_height
+                                    = std::min<uint64_t>(
+                                        updated_acc.start_height,
+                                        restore_height);
+                        }
 
-                        if (xmr_accounts->update(acc, updated_acc))
+                        if (!move_scanning_back
+                                || xmr_accounts->update(acc, updated_acc))
                         {
                             // if success, set acc to updated_acc;
                             request_fulfilled = true;
 
                             // change search blk number in the search thread
-                            if (!current_bc_status
-                                    ->set_new_searched_blk_no(xmr_address, 0))
+                            if (move_scanning_back
+                                    && !current_bc_status
+                                        ->set_new_searched_blk_no(address,
+                                                        restore_height))
                             {
                                 cerr << "Updating searched_blk_no failed!\n";
                                 j_response["error"] = "Updating searched_blk_no"
@@ -1151,12 +1647,7 @@ YourMoneroRequests::import_wallet_request(
         }
     }
 
-    string response_body = j_response.dump();
-
-    auto response_headers = make_headers({{ "Content-Length",
-                                            to_string(response_body.size())}});
-
-    session->close( OK, response_body, response_headers);
+    session_close(session, j_response);
 }
 
 
@@ -1172,60 +1663,111 @@ YourMoneroRequests::import_recent_wallet_request(
 
     j_response["request_fulfilled"] = false;
 
-    vector<string> requested_values {"address" , "view_key",
-                                     "no_blocks_to_import"};
+    vector<string> requested_values {"address" , "view_key"};
 
     if (!parse_request(body, requested_values, j_request, j_response))
     {
         j_response["Error"] = "Cant parse json body";
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
     string xmr_address;
     string view_key;
 
+    // either no_blocks_to_import or restore_date (YYYY-MM-DD)
+    // must be given. with restore_date, import starts from the
+    // first block which could be mined on that date.
+    bool const from_restore_date = j_request.count("restore_date") > 0;
+
+    string restore_date;
+
     try
     {
         xmr_address = j_request["address"];
         view_key    = j_request["view_key"];
+
+        if (from_restore_date)
+            restore_date = j_request["restore_date"];
     }
     catch (json::exception const& e)
     {
         cerr << "json exception: " << e.what() << '\n';
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
-    uint64_t no_blocks_to_import {1000};
-
-    try
+    if (!from_restore_date && j_request.count("no_blocks_to_import") == 0)
     {
-        no_blocks_to_import
-                = boost::lexical_cast<uint64_t>(
-                    j_request["no_blocks_to_import"].get<string>());
+        j_response["Error"] = "no_blocks_to_import or restore_date"
+                              " value not provided";
+        session_close(session, j_response);
+        return;
     }
-    catch (boost::bad_lexical_cast& e)
-    {
-        string msg = "Cant parse "
-                + j_request["no_blocks_to_import"].get<string>()
-                + " into number";
 
-        cerr << msg << '\n';
+    account_public_address address;
 
-        j_response["Error"] = msg;
-        session_close(session, j_response.dump());
+    if (!parse_address(xmr_address, address))
+    {
+        j_response["Error"] = "Cant parse address";
+        session_close(session, j_response);
         return;
     }
 
+    uint64_t current_blockchain_height = get_current_blockchain_height();
+
     // make sure that we dont import more that the maximum alowed no of blocks
-    no_blocks_to_import = std::min(no_blocks_to_import,
-                                   current_bc_status->get_bc_setup()
-                                   .max_number_of_blocks_to_import);
+    uint64_t const max_number_of_blocks_to_import
+            = std::min(current_bc_status->get_bc_setup()
+                            .max_number_of_blocks_to_import,
+                       current_blockchain_height);
 
-    no_blocks_to_import
-            = std::min(no_blocks_to_import,
-                      current_bc_status->get_current_blockchain_height());
+    uint64_t no_blocks_to_import {1000};
+
+    // height from which to start importing, when restore_date is given
+    uint64_t restore_height {0};
+
+    if (from_restore_date)
+    {
+        string error_msg;
+
+        if (!get_restore_height(restore_date, restore_height, error_msg))
+        {
+            cerr << error_msg << '\n';
+
+            j_response["Error"] = error_msg;
+            session_close(session, j_response);
+            return;
+        }
+
+        restore_height = std::max(restore_height,
+                                  current_blockchain_height
+                                  - max_number_of_blocks_to_import);
+    }
+    else
+    {
+        try
+        {
+            no_blocks_to_import
+                    = boost::lexical_cast<uint64_t>(
+                        j_request["no_blocks_to_import"].get<string>());
+        }
+        catch (boost::bad_lexical_cast& e)
+        {
+            string msg = "Cant parse "
+                    + j_request["no_blocks_to_import"].get<string>()
+                    + " into number";
+
+            cerr << msg << '\n';
+
+            j_response["Error"] = msg;
+            session_close(session, j_response);
+            return;
+        }
+
+        no_blocks_to_import = std::min(no_blocks_to_import,
+                                       max_number_of_blocks_to_import);
+    }
 
     XmrAccount acc;
 
@@ -1233,11 +1775,27 @@ YourMoneroRequests::import_recent_wallet_request(
     {
         XmrAccount updated_acc = acc;
 
+        bool move_scanning_back {false};
+
+        if (from_restore_date)
+        {
+            // only move scanning backward, as blocks after
+            // scanned_block_height will be scanned anyway.
+            // start_height is moved back to restore height, if
+            // its later. its never moved forward, as txs before
+            // it could have been found already.
+            if (restore_height < updated_acc.scanned_block_height)
+            {
+                updated_acc.scanned_block_height = restore_height;
+                updated_acc.start_height = std::min<uint64_t>(
+                            updated_acc.start_height, restore_height);
+                move_scanning_back = true;
+            }
+        }
         // make sure scanned_block_height is larger than
         // no_blocks_to_import so we dont
         // end up with overflowing uint64_t.
-
-        if (updated_acc.scanned_block_height >= no_blocks_to_import)
+        else if (updated_acc.scanned_block_height >= no_blocks_to_import)
         {
             // repetead calls to import_recent_wallet_request will be
             // moving the scanning backward.
@@ -1247,12 +1805,16 @@ YourMoneroRequests::import_recent_wallet_request(
             // wallet multiple times in a row.
             updated_acc.scanned_block_height
                     = updated_acc.scanned_block_height - no_blocks_to_import;
+            move_scanning_back = true;
+        }
 
+        if (move_scanning_back)
+        {
             if (xmr_accounts->update(acc, updated_acc))
             {
                 // change search blk number in the search thread
                 if (!current_bc_status
-                        ->set_new_searched_blk_no(xmr_address,
+                        ->set_new_searched_blk_no(address,
                                     updated_acc.scanned_block_height))
                 {
                     cerr << "Updating searched_blk_no failed!" << endl;
@@ -1265,7 +1827,12 @@ YourMoneroRequests::import_recent_wallet_request(
                 }
             }
 
-        }  // if (updated_acc.scanned_block_height > no_blocks_to_import)
+        }  // if (move_scanning_back)
+        else if (from_restore_date)
+        {
+            // blocks from the restore date are already scanned
+            request_fulfilled = true;
+        }
     }
     else
     {
@@ -1281,12 +1848,7 @@ YourMoneroRequests::import_recent_wallet_request(
                                 " importing recent txs successeful.";
     }
 
-    string response_body = j_response.dump();
-
-    auto response_headers = make_headers({{ "Content-Length",
-                                            to_string(response_body.size())}});
-
-    session->close( OK, response_body, response_headers);
+    session_close(session, j_response);
 }
 
 
@@ -1302,7 +1864,7 @@ YourMoneroRequests::get_tx(
 
     if (!parse_request(body, requested_values, j_request, j_response))
     {
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
@@ -1319,7 +1881,7 @@ YourMoneroRequests::get_tx(
     catch (json::exception const& e)
     {
         cerr << "json exception: " << e.what() << '\n';
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
@@ -1333,7 +1895,7 @@ YourMoneroRequests::get_tx(
     {
         cerr << "Cant parse tx hash! : " << tx_hash_str  << '\n';
         j_response["status"] = "Cant parse tx hash! : " + tx_hash_str;
-        session_close(session, j_response.dump());
+        session_close(session, j_response);
         return;
     }
 
@@ -1389,12 +1951,6 @@ YourMoneroRequests::get_tx(
 
         j_response["coinbase"] = coinbase;
 
-        // key images of inputs
-        vector<txin_to_key> input_key_imgs;
-
-        // public keys and xmr amount of outputs
-        vector<pair<txout_to_key, uint64_t>> output_pub_keys;
-
         uint64_t xmr_inputs;
         uint64_t xmr_outputs;
         uint64_t num_nonrct_inputs;
@@ -1403,19 +1959,18 @@ YourMoneroRequests::get_tx(
         uint64_t size;
 
         // sum xmr in inputs and ouputs in the given tx
-        array<uint64_t, 4> const& sum_data = xmreg::summary_of_in_out_rct(
-                tx, output_pub_keys, input_key_imgs);
+        array<uint64_t, 6> const& sum_data = xmreg::summary_of_in_out_rct(tx);
 
         xmr_outputs       = sum_data[0];
         xmr_inputs        = sum_data[1];
-        mixin_no          = sum_data[2];
-        num_nonrct_inputs = sum_data[3];
+        mixin_no          = sum_data[4];
+        num_nonrct_inputs = sum_data[5];
 
         j_response["xmr_outputs"]    = xmr_outputs;
         j_response["xmr_inputs"]     = xmr_inputs;
         j_response["mixin_no"]       = mixin_no;
-        j_response["num_of_outputs"] = output_pub_keys.size();
-        j_response["num_of_inputs"]  = input_key_imgs.size();
+        j_response["num_of_outputs"] = sum_data[2];
+        j_response["num_of_inputs"]  = sum_data[3];
 
         if (!coinbase &&  tx.vin.size() > 0)
         {
@@ -1457,6 +2012,7 @@ YourMoneroRequests::get_tx(
         j_response["payment_id"] = string {};
         j_response["timestamp"]  = default_timestamp;
 
+        account_public_address address;
         address_parse_info address_info;
         secret_key viewkey;
 
@@ -1469,8 +2025,9 @@ YourMoneroRequests::get_tx(
         // but its worth double checking
         // the mysql data, and also allows for new
         // implementation in the frontend.
-        if (current_bc_status->get_xmr_address_viewkey(
-                    xmr_address, address_info, viewkey))
+        if (parse_address(xmr_address, address)
+                && current_bc_status->get_xmr_address_viewkey(
+                    address, address_info, viewkey))
         {
             OutputInputIdentification oi_identification {
                 &address_info, &viewkey, &tx, tx_hash,
@@ -1551,7 +2108,8 @@ YourMoneroRequests::get_tx(
                                           {"key_image"  , input.key_image},
                                           {"tx_pub_key" , out.tx_pub_key},
                                           {"out_index"  , out.out_index},
-                                          {"mixin"      , out.mixin}});
+                                          {"mixin"      , out.mixin},
+                                          {"subaddr_index", out.get_subaddr_index()}});
                                 }
 
                             } // for (XmrInput input: inputs)
@@ -1572,61 +2130,57 @@ YourMoneroRequests::get_tx(
 
                     // we have to redo this info from basically from scrach.
 
-                    unordered_map<public_key, uint64_t> known_outputs_keys;
+                    // outputs of the account are in the known outputs
+                    // index while its search thread is running.
+                    // so now we can use OutputInputIdentification to
+                    // get info about inputs.
 
-                    if (current_bc_status->get_known_outputs_keys(
-                            xmr_address, known_outputs_keys))
-                    {
-                        // we got known_outputs_keys from the search thread.
-                        // so now we can use OutputInputIdentification to
-                        // get info about inputs.
+                    // Class that is resposnible for idenficitaction
+                    // of our outputs
+                    // and inputs in a given tx.
+                    OutputInputIdentification oi_identification
+                            {&address_info, &viewkey, &tx, tx_hash,
+                                coinbase, current_bc_status};
 
-                        // Class that is resposnible for idenficitaction
-                        // of our outputs
-                        // and inputs in a given tx.
-                        OutputInputIdentification oi_identification
-                                {&address_info, &viewkey, &tx, tx_hash,
-                                    coinbase, current_bc_status};
+                    // no need mutex here, as this will be exectued only
+                    // after the above. there is no threads here.
+                    oi_identification.identify_inputs(
+                            current_bc_status->get_known_outputs_index(),
+                            acc.id.data);
 
-                        // no need mutex here, as this will be exectued only
-                        // after the above. there is no threads here.
-                        oi_identification.identify_inputs(known_outputs_keys);
-
-                        json j_spent_outputs = json::array();
-
-                        uint64_t total_spent {0};
+                    json j_spent_outputs = json::array();
 
-                        for (auto& in_info: oi_identification.identified_inputs)
-                        {
+                    uint64_t total_spent {0};
 
-                            // need to get output info from mysql, as we need
-                            // to know output's amount, its orginal
-                            // tx public key and its index in that tx
-                            XmrOutput out;
+                    for (auto& in_info: oi_identification.identified_inputs)
+                    {
 
-                            string out_pub_key
-                                    = pod_to_hex(in_info.out_pub_key);
+                        // need to get output info from mysql, as we need
+                        // to know output's amount, its orginal
+                        // tx public key and its index in that tx
+                        XmrOutput out;
 
-                            if (xmr_accounts->output_exists(out_pub_key, out))
-                            {
-                                total_spent += out.amount;
+                        string out_pub_key
+                                = pod_to_hex(in_info.out_pub_key);
 
-                                j_spent_outputs.push_back({
-                                          {"amount"     , in_info.amount},
-                                          {"key_image"  , in_info.key_img},
-                                          {"tx_pub_key" , out.tx_pub_key},
-                                          {"out_index"  , out.out_index},
-                                          {"mixin"      , out.mixin}});
-                            }
+                        if (xmr_accounts->output_exists(out_pub_key, out))
+                        {
+                            total_spent += out.amount;
 
-                        } //  for (auto& in_info: oi_identification
+                            j_spent_outputs.push_back({
+                                      {"amount"     , in_info.amount},
+                                      {"key_image"  , in_info.key_img},
+                                      {"tx_pub_key" , out.tx_pub_key},
+                                      {"out_index"  , out.out_index},
+                                      {"mixin"      , out.mixin},
+                                      {"subaddr_index", out.get_subaddr_index()}});
+                        }
 
-                        j_response["total_sent"]    = total_spent;
+                    } //  for (auto& in_info: oi_identification
 
-                        j_response["spent_outputs"] = j_spent_outputs;
+                    j_response["total_sent"]    = total_spent;
 
-                    } //if (current_bc_status->get_known_outputs_keys(
-                      //    xmr_address, known_outputs_keys))
+                    j_response["spent_outputs"] = j_spent_outputs;
 
                 } //  else
 
@@ -1645,12 +2199,7 @@ YourMoneroRequests::get_tx(
         j_response["status"] = "Cant get tx details for tx hash! : " + tx_hash_str;
     }
 
-    string response_body = j_response.dump();
-
-    auto response_headers = make_headers({{ "Content-Length",
-                                            to_string(response_body.size())}});
-
-    session->close( OK, response_body, response_headers);
+    session_close(session, j_response);
 }
 
 
@@ -1672,12 +2221,161 @@ YourMoneroRequests::get_version(
         {"blockchain_height"   , get_current_blockchain_height()}
     };
 
-    string response_body = j_response.dump();
+    session_close(session, j_response);
+}
 
-    auto response_headers = make_headers({{ "Content-Length",
-                                            to_string(response_body.size())}});
+void
+YourMoneroRequests::subscribe(const shared_ptr< Session > session)
+{
+    const auto request = session->get_request();
+
+    const string connection_header
+            = request->get_header("connection", String::lowercase);
 
-    session->close( OK, response_body, response_headers);
+    const string upgrade_header
+            = request->get_header("upgrade", String::lowercase);
+
+    if (connection_header.find("upgrade") == string::npos
+            || upgrade_header != "websocket")
+    {
+        session->close(BAD_REQUEST);
+        return;
+    }
+
+    shared_ptr<AccountEvents> account_events
+            = current_bc_status->get_account_events();
+
+    if (!account_events)
+    {
+        session->close(SERVICE_UNAVAILABLE);
+        return;
+    }
+
+    session->upgrade(SWITCHING_PROTOCOLS,
+                     make_websocket_handshake_headers(request),
+                     [this, account_events](const shared_ptr< WebSocket > socket)
+    {
+        if (!socket->is_open())
+            return;
+
+        socket->set_message_handler(
+                    [this](const shared_ptr< WebSocket > socket,
+                           const shared_ptr< WebSocketMessage > message)
+        {
+            subscribe_message_handler(socket, message);
+        });
+
+        socket->set_close_handler(
+                    [account_events](const shared_ptr< WebSocket > socket)
+        {
+            account_events->unsubscribe(socket);
+        });
+
+        socket->set_error_handler(
+                    [account_events](const shared_ptr< WebSocket > socket,
+                                     const error_code error)
+        {
+            cerr << "websocket error: " << error.message() << '\n';
+            account_events->unsubscribe(socket);
+        });
+    });
+}
+
+void
+YourMoneroRequests::subscribe_message_handler(
+        const shared_ptr< WebSocket > socket,
+        const shared_ptr< WebSocketMessage > message)
+{
+    const auto opcode = message->get_opcode();
+
+    if (opcode == WebSocketMessage::PING_FRAME)
+    {
+        socket->send(make_shared<WebSocketMessage>(
+                         WebSocketMessage::PONG_FRAME,
+                         message->get_data()));
+        return;
+    }
+
+    if (opcode == WebSocketMessage::CONNECTION_CLOSE_FRAME)
+    {
+        socket->close();
+        return;
+    }
+
+    if (opcode != WebSocketMessage::TEXT_FRAME)
+        return;
+
+    json j_response;
+    json j_request;
+
+    vector<string> requested_values {"address", "view_key"};
+
+    if (!parse_request(message->get_data(), requested_values,
+                       j_request, j_response))
+    {
+        socket->send(j_response.dump());
+        return;
+    }
+
+    string xmr_address;
+    string view_key;
+    string token; // optional, issued by login
+
+    try
+    {
+        xmr_address = j_request["address"];
+        view_key    = j_request["view_key"];
+        token       = j_request.value("token", string {});
+    }
+    catch (json::exception const& e)
+    {
+        cerr << "json exception: " << e.what() << '\n';
+
+        j_response = json {{"status", "error"},
+                           {"reason", "Wrong address or view_key"}};
+
+        socket->send(j_response.dump());
+        return;
+    }
+
+    account_public_address address;
+
+    if (!parse_address(xmr_address, address))
+    {
+        j_response = json {{"status", "error"},
+                           {"reason", "Cant parse address"}};
+
+        socket->send(j_response.dump());
+        return;
+    }
+
+    XmrAccount acc;
+
+    // only existing accounts can subscribe, i.e., wallets
+    // must login first.
+    if (!login_and_start_search_thread(xmr_address, address, view_key,
+                                       token, acc, j_response))
+    {
+        if (j_response.empty())
+        {
+            j_response = json {{"status", "error"},
+                               {"reason", "Account does not exist"}};
+        }
+
+        socket->send(j_response.dump());
+        return;
+    }
+
+    current_bc_status->get_account_events()->subscribe(xmr_address, socket);
+
+    j_response = json {
+            {"event"               , "subscribed"},
+            {"status"              , "success"},
+            {"scanned_block_height", acc.scanned_block_height},
+            {"blockchain_height"   , get_current_blockchain_height()}
+    };
+
+    socket->send(j_response.dump());
 }
 
 
@@ -1701,6 +2399,24 @@ YourMoneroRequests::make_resource(
 }
 
 
+shared_ptr<Resource>
+YourMoneroRequests::make_websocket_resource(
+        function< void (YourMoneroRequests&,
+                        const shared_ptr< Session >) > handle_func,
+        const string& path)
+{
+    auto a_request = std::bind(handle_func, *this,
+                               std::placeholders::_1);
+
+    shared_ptr<Resource> resource_ptr = make_shared<Resource>();
+
+    resource_ptr->set_path(path);
+    resource_ptr->set_method_handler( "GET", a_request);
+
+    return resource_ptr;
+}
+
+
 void
 YourMoneroRequests::generic_options_handler(
         const shared_ptr< Session > session )
@@ -1759,102 +2475,264 @@ YourMoneroRequests::get_current_blockchain_height()
 {
     return current_bc_status->get_current_blockchain_height();
 }
+multimap<string, string>
+YourMoneroRequests::make_websocket_handshake_headers(
+        const shared_ptr< const Request > request)
+{
+    // based on restbed's web_socket_service example
+    string key = request->get_header("Sec-WebSocket-Key");
+    key.append("258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+
+    unsigned char hash[SHA_DIGEST_LENGTH];
+
+    SHA1(reinterpret_cast<const unsigned char*>(key.data()),
+         key.length(), hash);
+
+    return multimap<string, string> {
+            {"Upgrade"             , "websocket"},
+            {"Connection"          , "Upgrade"},
+            {"Sec-WebSocket-Accept", epee::string_encoding::base64_encode(
+                                        hash, SHA_DIGEST_LENGTH)}
+    };
+}
+
+bool
+YourMoneroRequests::parse_address(
+                        const string& xmr_address,
+                        account_public_address& address) const
+{
+    address_parse_info address_info;
+
+    if (!parse_str_address(xmr_address, address_info,
+                           current_bc_status->get_bc_setup().net_type))
+        return false;
+
+    address = address_info.address;
+
+    return true;
+}
 
 bool
 YourMoneroRequests::login_and_start_search_thread(
                         const string& xmr_address,
+                        account_public_address const& address,
                         const string& view_key,
+                        const string& token,
                         XmrAccount& acc,
                         json& j_response)
 {
+    // select this account if its existing one. the row is read
+    // even with a valid token, as it can be changed by imports,
+    // rescans or manually, after the search thread got its copy.
+    if (!xmr_accounts->select(xmr_address, acc))
+        return false;
 
-    // select this account if its existing one
-    if (xmr_accounts->select(xmr_address, acc))
+    // viewkey of the account with a valid token was already
+    // verified at login. so no need for hashing it again.
+    if (!token.empty())
     {
-        // we got accunt from the database. we double check
-        // if hash of provided viewkey by the frontend, matches
-        // what we have in database.
+        auto search_thread = session_tokens->find(token, xmr_address);
 
-        // make hash of the submited viewkey. we only store
-        // hash of viewkey in database, not acctual viewkey.
-        string viewkey_hash = make_hash(view_key);
-
-        if (viewkey_hash == acc.viewkey_hash)
+        if (search_thread)
         {
-            // if match, than save the viewkey in account object
-            // and proceed to checking if a search thread exisits
-            // for this account. if not, then create new thread
-
-            acc.viewkey = view_key;
-
-            // so we have an account now. Either existing or
-            // newly created. Thus, we can start a tread
-            // which will scan for transactions belonging to
-            // that account, using its address and view key.
-            // the thread will scan the blockchain for txs belonging
-            // to that account and updated mysql database whenever it
-            // will find something.
-            //
-            // The other client (i.e., a webbrowser) will query other
-            // functions to retrieve
-            // any belonging transactions in a loop.
-            // Thus the thread does not need
-            // to do anything except looking for tx and updating mysql
-            // with relative tx information
-
-            if (!current_bc_status->search_thread_exist(acc.address))
-            {
-                auto tx_search
-                        = std::make_unique<TxSearch>(acc, current_bc_status);
+            std::shared_ptr<XmrAccount const> account
+                    = search_thread->get_functor().get_account();
 
-                if (current_bc_status->start_tx_search_thread(
-                            acc, std::move(tx_search)))
-                {
-                    j_response["status"]      = "success";
-                    j_response["new_address"] = false;
+            if (account && account->id.data == acc.id.data
+                    && account->viewkey == view_key)
+            {
+                acc.viewkey = view_key;
 
-                    // thread has been started
-                    // everything seems fine.
+                j_response["status"]      = "success";
+                j_response["new_address"] = false;
 
-                    return true;
-                }
+                return true;
             }
-            else
+        }
+
+        // if token is not valid anymore, e.g., because search
+        // thread stopped, login as if there was no token
+    }
+
+    return verify_viewkey_and_start_search_thread(view_key, address,
+                                                  acc, j_response);
+}
+
+bool
+YourMoneroRequests::verify_viewkey_and_start_search_thread(
+                        const string& view_key,
+                        account_public_address const& address,
+                        XmrAccount& acc,
+                        json& j_response)
+{
+    // we got accunt from the database. we double check
+    // if hash of provided viewkey by the frontend, matches
+    // what we have in database.
+    // make hash of the submited viewkey. we only store
+    // hash of viewkey in database, not acctual viewkey.
+    string viewkey_hash = make_hash(view_key);
+
+    if (viewkey_hash == acc.viewkey_hash)
+    {
+        // if match, than save the viewkey in account object
+        // and proceed to checking if a search thread exisits
+        // for this account. if not, then create new thread
+
+        acc.viewkey = view_key;
+
+        // so we have an account now. Either existing or
+        // newly created. Thus, we can start a tread
+        // which will scan for transactions belonging to
+        // that account, using its address and view key.
+        // the thread will scan the blockchain for txs belonging
+        // to that account and updated mysql database whenever it
+        // will find something.
+        //
+        // The other client (i.e., a webbrowser) will query other
+        // functions to retrieve
+        // any belonging transactions in a loop.
+        // Thus the thread does not need
+        // to do anything except looking for tx and updating mysql
+        // with relative tx information
+
+        if (!current_bc_status->search_thread_exist(address))
+        {
+            auto tx_search
+                    = std::make_unique<TxSearch>(acc, current_bc_status);
+
+            if (current_bc_status->start_tx_search_thread(
+                        acc, std::move(tx_search)))
             {
                 j_response["status"]      = "success";
                 j_response["new_address"] = false;
 
-                // thread already exists
+                // thread has been started
                 // everything seems fine.
 
                 return true;
             }
-
-            j_response = json {{"status", "error"},
-                               {"reason", "Failed created search "
-                                          "thread for this account"}};
         }
         else
         {
-            j_response = json {{"status", "error"},
-                               {"reason", "Viewkey provided is incorrect"}};
+            j_response["status"]      = "success";
+            j_response["new_address"] = false;
+
+            // thread already exists
+            // everything seems fine.
+
+            return true;
         }
+
+        j_response = json {{"status", "error"},
+                           {"reason", "Failed created search "
+                                      "thread for this account"}};
+    }
+    else
+    {
+        j_response = json {{"status", "error"},
+                           {"reason", "Viewkey provided is incorrect"}};
     }
 
     return false;
 }
 
+bool
+YourMoneroRequests::get_restore_height(
+        string const& restore_date,
+        uint64_t& restore_height,
+        string& error_msg)
+{
+    uint64_t restore_timestamp {0};
+
+    if (!parse_date(restore_date, restore_timestamp))
+    {
+        error_msg = "Cant parse " + restore_date + " into YYYY-MM-DD date";
+        return false;
+    }
+
+    restore_timestamp = restore_timestamp > RESTORE_DATE_MARGIN
+                        ? restore_timestamp - RESTORE_DATE_MARGIN : 0;
+
+    if (!current_bc_status->get_height_for_timestamp(
+                restore_timestamp, restore_height))
+    {
+        error_msg = "Block timestamps are not indexed yet";
+        return false;
+    }
+
+    return true;
+}
+
 
 
 void
 YourMoneroRequests::session_close(
-        const shared_ptr< Session > session, string response_body)
+        const shared_ptr< Session > session, json const& j_response)
 {
+    ResponseEncoding encoding = get_response_encoding(session->get_request());
+
+    if (encoding == ResponseEncoding::JSON)
+    {
+        string response_body = j_response.dump();
+
+        auto response_headers = make_headers({{"Content-Length",
+                                               to_string(response_body.size())},
+                                              {"Vary", "Accept"}});
+
+        session->close(OK, response_body, response_headers);
+        return;
+    }
+
+    // binary encodings carry keys and hashes as byte strings.
+    // ResponseWriter writes them straight from j_response.
+    ResponseWriter writer {encoding};
+
+    writer.value(j_response);
+
+    session_close(session, writer);
+}
+
+void
+YourMoneroRequests::session_close(
+        const shared_ptr< Session > session, ResponseWriter const& writer)
+{
+    string const& response_body = writer.str();
+
     auto response_headers = make_headers({{"Content-Length",
-                                           to_string(response_body.size())}});
+                                           to_string(response_body.size())},
+                                          {"Vary", "Accept"}});
+
+    if (writer.get_format() != ResponseEncoding::JSON)
+    {
+        response_headers.erase("Content-Type");
+        response_headers.emplace("Content-Type",
+                                 writer.get_format() == ResponseEncoding::CBOR
+                                 ? "application/cbor" : "application/msgpack");
+    }
+
     session->close(OK, response_body, response_headers);
 }
 
+YourMoneroRequests::ResponseEncoding
+YourMoneroRequests::get_response_encoding(
+        const shared_ptr< const Request > request)
+{
+    if (!request)
+        return ResponseEncoding::JSON;
+
+    string accept = request->get_header("Accept", String::lowercase);
+
+    // we dont do full q-value negotiation. clients asking for binary
+    // encoding are our native clients, which list only one type.
+    if (accept.find("application/cbor") != string::npos)
+        return ResponseEncoding::CBOR;
+
+    if (accept.find("application/msgpack") != string::npos
+            || accept.find("application/x-msgpack") != string::npos)
+        return ResponseEncoding::MSGPACK;
+
+    return ResponseEncoding::JSON;
+}
 
 bool
 YourMoneroRequests::parse_request(
@@ -13,6 +13,8 @@
 
 #include "CurrentBlockchainStatus.h"
 #include "MySqlAccounts.h"
+#include "SessionTokens.h"
+#include "ResponseWriter.h"
 #include "../gen/version.h"
 
 #include "../ext/restbed/source/restbed"
@@ -32,7 +34,7 @@
 // advance which version they will stop working with
 // Don't go over 32767 for any of these
 #define OPENMONERO_RPC_VERSION_MAJOR 1
-#define OPENMONERO_RPC_VERSION_MINOR 3
+#define OPENMONERO_RPC_VERSION_MINOR 8
 #define MAKE_OPENMONERO_RPC_VERSION(major,minor) (((major)<<16)|(minor))
 #define OPENMONERO_RPC_VERSION \
     MAKE_OPENMONERO_RPC_VERSION(OPENMONERO_RPC_VERSION_MAJOR, OPENMONERO_RPC_VERSION_MINOR)
@@ -60,11 +62,31 @@ struct handel_
 
 class YourMoneroRequests
 {
+public:
+
+    // how response bodies are serialized, see session_close
+    using ResponseEncoding = ResponseWriter::Format;
+
+private:
+
+    // max number of txs returned in one page by get_address_txs
+    static constexpr uint64_t MAX_TXS_PAGE_SIZE {1000};
+
+    // max number of accounts in one get_addresses_info request
+    static constexpr uint64_t MAX_ADDRESSES_IN_BATCH {500};
+
+    // wallets imported from a restore date are scanned from a day
+    // before it, as block timestamps can be off by hours, and the
+    // dates are in users' local time zones
+    static constexpr uint64_t RESTORE_DATE_MARGIN {24 * 3600};
 
     // this manages all mysql queries
    shared_ptr<MySqlAccounts> xmr_accounts;
    shared_ptr<CurrentBlockchainStatus> current_bc_status;
 
+   // shared, as handlers are bound to copies of this object
+   shared_ptr<SessionTokens> session_tokens;
+
 public:
 
     YourMoneroRequests(shared_ptr<MySqlAccounts> _acc,
@@ -80,6 +102,12 @@ public:
      * Once this complites, a thread is started that looks
      * for txs belonging to that account.
      *
+     * The response includes a session "token". Other requests
+     * can send it along with address and viewkey, so that they
+     * dont verify the viewkey's hash again. It expires
+     * together with the search thread, after which requests
+     * work as if there was no token.
+     *
      * @param session a Restbed session
      * @param body a POST body, i.e., json string
      */
@@ -92,6 +120,31 @@ public:
     void
     get_address_info(const shared_ptr< Session > session, const Bytes & body);
 
+    /**
+     * Batch version of get_address_info.
+     *
+     * Intended for merchants and exchanges watching many
+     * accounts. The request is
+     * {"accounts": [{"address": ..., "view_key": ..., "cursor": ...}, ...]}
+     * where cursor is optional. Accounts are checked and their data
+     * fetched using IN (...) queries, so the number of mysql queries
+     * does not depend on the number of accounts: at most eight,
+     * including updates of txs which became spendable or were
+     * orphaned. Search threads of accounts without one are
+     * started, but they read from mysql in their own threads.
+     *
+     * Each account in the response has its own status, so one
+     * wrong viewkey does not fail the whole request. Returned "cursor"
+     * is id of the newest tx of the account. If it is given
+     * in the next request, txs newer than it are
+     * returned in "transactions".
+     *
+     * @param session a Restbed session
+     * @param body a POST body, i.e., json string
+     */
+    void
+    get_addresses_info(const shared_ptr< Session > session, const Bytes & body);
+
     void
     get_unspent_outs(const shared_ptr< Session > session, const Bytes & body);
 
@@ -113,10 +166,37 @@ public:
     void
     get_version(const shared_ptr< Session > session, const Bytes & body);
 
+    /**
+     * A websocket handler for push based account updates.
+     *
+     * After the connection is upgraded, the client sends text message
+     * {"address": ..., "view_key": ...}. Once the viewkey is verified,
+     * the socket gets subscribed to the account's events, and
+     * account's search thread is kept alive as long as
+     * the socket is open. Events are json text messages
+     * with "event" field being one of:
+     *  - subscribed: confirmation of the subscription
+     *  - tx_confirmed: our tx found in a block
+     *  - tx_unlocked: our tx became spendable
+     *  - tx_orphaned: block of our locked tx got orphaned
+     *  - mempool_tx: our tx seen in the mempool
+     *  - scan_progress: search thread scanned more blocks
+     *  - unsubscribed: search thread stopped, so the socket
+     *    is closed. the client can subscribe again.
+     *
+     * @param session a Restbed session
+     */
+    void
+    subscribe(const shared_ptr< Session > session);
+
     shared_ptr<Resource>
     make_resource(function< void (YourMoneroRequests&, const shared_ptr< Session >, const Bytes& ) > handle_func,
                   const string& path);
 
+    shared_ptr<Resource>
+    make_websocket_resource(function< void (YourMoneroRequests&, const shared_ptr< Session >) > handle_func,
+                            const string& path);
+
     static void
     generic_options_handler( const shared_ptr< Session > session );
 
@@ -125,6 +205,10 @@ public:
             const multimap<string, string>& extra_headers
             = multimap<string, string>());
 
+    // response headers accepting websocket upgrade request
+    static multimap<string, string>
+    make_websocket_handshake_headers(const shared_ptr< const Request > request);
+
     static void
     print_json_log(const string& text, const json& j);
 
@@ -139,16 +223,60 @@ public:
 
 private:
 
+    // requests parse their address once, and pass it
+    // to all calls for its search thread
+    bool
+    parse_address(const string& xmr_address,
+                  account_public_address& address) const;
+
     bool
     login_and_start_search_thread(
             const string& xmr_address,
+            account_public_address const& address,
             const string& viewkey,
+            const string& token,
             XmrAccount& acc,
             json& j_response);
 
+    bool
+    verify_viewkey_and_start_search_thread(
+            const string& viewkey,
+            account_public_address const& address,
+            XmrAccount& acc,
+            json& j_response);
 
-    inline void
-    session_close(const shared_ptr< Session > session, string response_body);
+    // height from which to import a wallet, given its restore
+    // date in YYYY-MM-DD format. error_msg is set on failure.
+    bool
+    get_restore_height(string const& restore_date,
+                       uint64_t& restore_height,
+                       string& error_msg);
+
+
+    /**
+     * Close the session with j_response as its body.
+     *
+     * The body is json by default. Native clients can ask for
+     * compact binary encoding using Accept header with
+     * application/cbor or application/msgpack. In these
+     * encodings keys and hashes are byte strings instead of
+     * hex strings, see ResponseWriter.
+     */
+    void
+    session_close(const shared_ptr< Session > session, json const& j_response);
+
+    // same as above, for response already written by ResponseWriter
+    // in the encoding given by get_response_encoding
+    void
+    session_close(const shared_ptr< Session > session,
+                  ResponseWriter const& writer);
+
+    static ResponseEncoding
+    get_response_encoding(const shared_ptr< const Request > request);
+
+    void
+    subscribe_message_handler(const shared_ptr< WebSocket > socket,
+                              const shared_ptr< WebSocketMessage > message);
 
     bool
     parse_request(const Bytes& body,
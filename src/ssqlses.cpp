@@ -78,6 +78,7 @@ XmrOutput::to_json() const
             {"global_index"        , global_index},
             {"out_index"           , out_index},
             {"mixin"               , mixin},
+            {"subaddr_index"       , get_subaddr_index()},
             {"timestamp"           , static_cast<uint64_t>(timestamp)}
     };
 
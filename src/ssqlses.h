@@ -52,6 +52,11 @@ struct XmrAccount : public Accounts, Table
         SELECT * FROM `Accounts` WHERE `address` = (%0q)
     )";
 
+    // %0 is comma separated list of already escaped and quoted addresses
+    static constexpr const char* SELECT_IN_STMT = R"(
+        SELECT * FROM `Accounts` WHERE `address` IN (%0)
+    )";
+
     // SELECT_STMT3 same as SELECT_STMT which is fine
     // easier to work with templates later
     static constexpr const char* SELECT_STMT3 = R"(
@@ -147,6 +152,16 @@ struct XmrTransaction : public Transactions, Table
                              WHERE `id` = %0q;
     )";
 
+    // %0 is comma separated list of tx ids
+    static constexpr const char* MARK_AS_SPENDABLE_IN_STMT = R"(
+       UPDATE `Transactions` SET `spendable` = 1,  `timestamp` = CURRENT_TIMESTAMP
+                             WHERE `id` IN (%0);
+    )";
+
+    static constexpr const char* DELETE_IN_STMT = R"(
+       DELETE FROM `Transactions` WHERE `id` IN (%0)
+    )";
+
     static constexpr const char* SUM_XMR_RECIEVED = R"(
         SELECT SUM(`total_received`) AS total_received
                FROM `Transactions`
@@ -154,6 +169,49 @@ struct XmrTransaction : public Transactions, Table
                GROUP BY `account_id`
     )";
 
+    // keyset pagination over account's txs, newest first.
+    // served by the account_id_blockchain_tx_id index.
+    static constexpr const char* SELECT_PAGE_STMT = R"(
+        SELECT * FROM `Transactions`
+                 WHERE `account_id` = (%0q) AND `blockchain_tx_id` < (%1q)
+                 ORDER BY `blockchain_tx_id` DESC
+                 LIMIT %2q
+    )";
+
+    static constexpr const char* SELECT_NONSPENDABLE_STMT = R"(
+        SELECT * FROM `Transactions`
+                 WHERE `account_id` = (%0q) AND `spendable` = 0
+    )";
+
+    // batch versions of the above statements.
+    // %0 is comma separated list of account ids.
+    static constexpr const char* SELECT_NONSPENDABLE_IN_STMT = R"(
+        SELECT * FROM `Transactions`
+                 WHERE `account_id` IN (%0) AND `spendable` = 0
+    )";
+
+    // totals are maintained in AccountSummaries by triggers
+    // on Transactions, so they are not summed up here.
+    // accounts without any txs have no row there.
+    static constexpr const char* SUMMARY_IN_STMT = R"(
+        SELECT `account_id`, `no_of_txs`, `total_received`,
+               `total_received_unlocked`, `last_tx_id`
+               FROM `AccountSummaries`
+               WHERE `account_id` IN (%0)
+    )";
+
+    // %0 is list of "(`account_id` = x AND `id` > y)" conditions
+    // joined with OR
+    static constexpr const char* SELECT_AFTER_STMT = R"(
+        SELECT * FROM `Transactions` WHERE %0 ORDER BY `id`
+    )";
+
+    static constexpr const char* SUMMARY_STMT = R"(
+        SELECT `no_of_txs`, `total_received`, `total_received_unlocked`
+               FROM `AccountSummaries`
+               WHERE `account_id` = %0q
+    )";
+
 
 
 
@@ -169,7 +227,7 @@ struct XmrTransaction : public Transactions, Table
 
 };
 
-sql_create_13(Outputs, 1, 13,
+sql_create_15(Outputs, 1, 15,
               sql_bigint_unsigned_null, id,               // this is null so that we can set it to mysqlpp:null when inserting rows
               sql_bigint_unsigned, account_id,            // this way auto_increment of the id will take place and we can
               sql_bigint_unsigned, tx_id,                 // use vector of outputs to write at once to mysql
@@ -182,6 +240,8 @@ sql_create_13(Outputs, 1, 13,
               sql_bigint_unsigned, global_index,
               sql_bigint_unsigned, out_index,
               sql_bigint_unsigned, mixin,
+              sql_int_unsigned   , subaddr_major,         // subaddress the output was sent to,
+              sql_int_unsigned   , subaddr_minor,         // (0, 0) for the main address
               sql_timestamp      , timestamp);
 
 struct XmrOutput : public Outputs, Table
@@ -203,17 +263,26 @@ struct XmrOutput : public Outputs, Table
       SELECT * FROM `Outputs` WHERE `out_pub_key` = (%0q)
     )";
 
+    // %0 is comma separated list of output ids
+    static constexpr const char* SELECT_IN_STMT = R"(
+      SELECT * FROM `Outputs` WHERE `id` IN (%0)
+    )";
+
     static constexpr const char* INSERT_STMT = R"(
       INSERT IGNORE INTO `Outputs` (`account_id`, `tx_id`, `out_pub_key`,
                                      `tx_pub_key`,
                                      `rct_outpk`, `rct_mask`, `rct_amount`,
                                      `amount`, `global_index`,
-                                     `out_index`, `mixin`, `timestamp`)
+                                     `out_index`, `mixin`,
+                                     `subaddr_major`, `subaddr_minor`,
+                                     `timestamp`)
                             VALUES (%0q, %1q, %2q,
                                     %3q,
                                     %4q, %5q, %6q,
                                     %7q, %8q,
-                                    %9q, %10q, %11q);
+                                    %9q, %10q,
+                                    %11q, %12q,
+                                    %13q);
     )";
 
 
@@ -226,6 +295,14 @@ struct XmrOutput : public Outputs, Table
         return rct_outpk + rct_mask + rct_amount;
     }
 
+    // same as subaddr_index of monero's wallet rpc,
+    // e.g., {"major": 0, "minor": 1}
+    json
+    get_subaddr_index() const
+    {
+        return json {{"major", subaddr_major}, {"minor", subaddr_minor}};
+    }
+
 
     string table_name() const override { return this->table();};
 
@@ -263,6 +340,16 @@ struct XmrInput : public Inputs, Table
      SELECT * FROM `Inputs` WHERE `output_id` = (%0q)
     )";
 
+    // %0 is comma separated list of account ids
+    static constexpr const char* SELECT_IN_STMT = R"(
+     SELECT * FROM `Inputs` WHERE `account_id` IN (%0)
+    )";
+
+    // %0 is comma separated list of tx ids
+    static constexpr const char* SELECT_FOR_TXS_IN_STMT = R"(
+     SELECT * FROM `Inputs` WHERE `tx_id` IN (%0)
+    )";
+
     static constexpr const char* INSERT_STMT = R"(
       INSERT IGNORE INTO `Inputs` (`account_id`, `tx_id`, `output_id`,
                                 `key_image`, `amount` , `timestamp`)
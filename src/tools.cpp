@@ -5,6 +5,11 @@
 #include "tools.h"
 #include <codecvt>
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#define XMREG_HEX_X86
+#include <immintrin.h>
+#endif
+
 
 namespace xmreg
 {
@@ -96,8 +101,8 @@ print_sig (const signature& sig)
 {
     stringstream ss;
 
-    ss << "c: <" << epee::string_tools::pod_to_hex(sig.c) << "> "
-       << "r: <" << epee::string_tools::pod_to_hex(sig.r) << ">";
+    ss << "c: <" << pod_to_hex(sig.c) << "> "
+       << "r: <" << pod_to_hex(sig.r) << ">";
 
     return ss.str();
 }
@@ -299,51 +304,23 @@ get_blockchain_path(string& blockchain_path,
 }
 
 
-array<uint64_t, 4>
-summary_of_in_out_rct(
-        const transaction& tx,
-        vector<pair<txout_to_key, uint64_t>>& output_pub_keys,
-        vector<txin_to_key>& input_key_imgs)
+array<uint64_t, 6>
+summary_of_in_out_rct(const transaction& tx)
 {
 
     uint64_t xmr_outputs       {0};
     uint64_t xmr_inputs        {0};
+    uint64_t no_inputs         {0};
     uint64_t mixin_no          {0};
     uint64_t num_nonrct_inputs {0};
 
-
-    for (const tx_out& txout: tx.vout)
+    for (output_to_key_ref const& out: outputs_to_key(tx))
     {
-        if (txout.target.type() != typeid(txout_to_key))
-        {
-            // push empty pair.
-            output_pub_keys.push_back(pair<txout_to_key, uint64_t>{});
-            continue;
-        }
-
-        // get tx input key
-        const txout_to_key& txout_key
-                = boost::get<cryptonote::txout_to_key>(txout.target);
-
-        output_pub_keys.push_back(make_pair(txout_key, txout.amount));
-
-        xmr_outputs += txout.amount;
+        xmr_outputs += out.amount;
     }
 
-    size_t input_no = tx.vin.size();
-
-    for (size_t i = 0; i < input_no; ++i)
+    for (txin_to_key const& tx_in_to_key: inputs_to_key(tx))
     {
-
-        if(tx.vin[i].type() != typeid(cryptonote::txin_to_key))
-        {
-            continue;
-        }
-
-        // get tx input key
-        const cryptonote::txin_to_key& tx_in_to_key
-                = boost::get<cryptonote::txin_to_key>(tx.vin[i]);
-
         xmr_inputs += tx_in_to_key.amount;
 
         if (tx_in_to_key.amount != 0)
@@ -356,12 +333,14 @@ summary_of_in_out_rct(
             mixin_no = tx_in_to_key.key_offsets.size();
         }
 
-        input_key_imgs.push_back(tx_in_to_key);
+        ++no_inputs;
 
-    } //  for (size_t i = 0; i < input_no; ++i)
+    } //  for (txin_to_key const& tx_in_to_key: inputs_to_key(tx))
 
 
-    return {xmr_outputs, xmr_inputs, mixin_no, num_nonrct_inputs};
+    return {xmr_outputs, xmr_inputs,
+            static_cast<uint64_t>(tx.vout.size()), no_inputs,
+            mixin_no, num_nonrct_inputs};
 };
 
 
@@ -564,20 +543,8 @@ get_ouputs_tuple(const transaction& tx)
 {
     vector<tuple<txout_to_key, uint64_t, uint64_t>> outputs;
 
-    for (uint64_t n = 0; n < tx.vout.size(); ++n)
-    {
-
-        if (tx.vout[n].target.type() != typeid(txout_to_key))
-        {
-            continue;
-        }
-
-        // get tx input key
-        const txout_to_key& txout_key
-                = boost::get<cryptonote::txout_to_key>(tx.vout[n].target);
-
-        outputs.push_back(make_tuple(txout_key, tx.vout[n].amount, n));
-    }
+    for (output_to_key_ref const& out: outputs_to_key(tx))
+        outputs.push_back(make_tuple(out.txout_k, out.amount, out.idx_in_tx));
 
     return outputs;
 };
@@ -656,57 +623,93 @@ get_key_images(const transaction& tx)
 {
     vector<txin_to_key> key_images;
 
-    size_t input_no = tx.vin.size();
-
-    for (size_t i = 0; i < input_no; ++i)
-    {
+    for (txin_to_key const& tx_in_to_key: inputs_to_key(tx))
+        key_images.push_back(tx_in_to_key);
 
-        if(tx.vin[i].type() != typeid(txin_to_key))
-        {
-            continue;
-        }
+    return key_images;
+}
 
-        // get tx input key
-        const txin_to_key& tx_in_to_key
-                = boost::get<cryptonote::txin_to_key>(tx.vin[i]);
+string
+tx_extra_info::get_payment_id_str() const
+{
+    if (payment_id != null_hash)
+        return pod_to_hex(payment_id);
 
-        key_images.push_back(tx_in_to_key);
-    }
+    if (payment_id8 != null_hash8)
+        return pod_to_hex(payment_id8);
 
-    return key_images;
+    return string {};
 }
 
-bool
-get_payment_id(const vector<uint8_t>& extra,
-               crypto::hash& payment_id,
-               crypto::hash8& payment_id8)
+tx_extra_info
+parse_tx_extra_info(const vector<uint8_t>& extra)
 {
-    payment_id = null_hash;
-    payment_id8 = null_hash8;
+    tx_extra_info info;
 
     std::vector<tx_extra_field> tx_extra_fields;
 
-    if(!parse_tx_extra(extra, tx_extra_fields))
-    {
-        return false;
-    }
+    // Extra may only be partially parsed, it's OK if
+    // tx_extra_fields contains public keys
+    bool const fully_parsed = parse_tx_extra(extra, tx_extra_fields);
 
-    tx_extra_nonce extra_nonce;
+    size_t no_of_pub_keys {0};
+    bool nonce_found {false};
 
-    if (find_tx_extra_field_by_type(tx_extra_fields, extra_nonce))
+    for (tx_extra_field const& field: tx_extra_fields)
     {
-        // first check for encrypted id and then for normal one
-        if(get_encrypted_payment_id_from_tx_extra_nonce(extra_nonce.nonce, payment_id8))
+        if (field.type() == typeid(tx_extra_pub_key))
         {
-            return true;
+            // Due to a previous bug, there might be more than one tx
+            // pubkey in extra, one being the result of a previously
+            // discarded signature. The second one is used then, which
+            // does not require private view key to pick.
+            if (no_of_pub_keys < 2)
+                info.tx_pub_key = boost::get<tx_extra_pub_key>(field).pub_key;
+
+            ++no_of_pub_keys;
         }
-        else if (get_payment_id_from_tx_extra_nonce(extra_nonce.nonce, payment_id))
+        else if (field.type() == typeid(tx_extra_additional_pub_keys)
+                 && info.additional_tx_pub_keys.empty())
         {
-            return true;
+            info.additional_tx_pub_keys
+                    = boost::get<tx_extra_additional_pub_keys>(field).data;
+        }
+        else if (field.type() == typeid(tx_extra_nonce)
+                 && !nonce_found && fully_parsed)
+        {
+            nonce_found = true;
+            info.nonce = boost::get<tx_extra_nonce>(field).nonce;
         }
     }
 
-    return false;
+    if (nonce_found)
+    {
+        // first check for encrypted id and then for normal one
+        if (!get_encrypted_payment_id_from_tx_extra_nonce(info.nonce,
+                                                          info.payment_id8))
+        {
+            info.payment_id8 = null_hash8;
+
+            if (!get_payment_id_from_tx_extra_nonce(info.nonce,
+                                                    info.payment_id))
+                info.payment_id = null_hash;
+        }
+    }
+
+    return info;
+}
+
+bool
+get_payment_id(const vector<uint8_t>& extra,
+               crypto::hash& payment_id,
+               crypto::hash8& payment_id8)
+{
+    tx_extra_info const info = parse_tx_extra_info(extra);
+
+    payment_id = info.payment_id;
+    payment_id8 = info.payment_id8;
+
+    return payment_id != null_hash || payment_id8 != null_hash8;
 }
 
 
@@ -820,6 +823,16 @@ decode_ringct(const rct::rctSig& rv,
         return false;
     }
 
+    return decode_ringct(rv, derivation, i, mask, amount);
+}
+
+bool
+decode_ringct(const rct::rctSig& rv,
+              const crypto::key_derivation &derivation,
+              unsigned int i,
+              rct::key & mask,
+              uint64_t & amount)
+{
     crypto::secret_key scalar1;
 
     crypto::derivation_to_scalar(derivation, i, scalar1);
@@ -930,43 +943,7 @@ parse_crow_post_data(const string& req_body)
 public_key
 get_tx_pub_key_from_received_outs(const transaction &tx)
 {
-    std::vector<tx_extra_field> tx_extra_fields;
-
-    if(!parse_tx_extra(tx.extra, tx_extra_fields))
-    {
-        // Extra may only be partially parsed, it's OK if tx_extra_fields contains public key
-    }
-
-    // Due to a previous bug, there might be more than one tx pubkey in extra, one being
-    // the result of a previously discarded signature.
-    // For speed, since scanning for outputs is a slow process, we check whether extra
-    // contains more than one pubkey. If not, the first one is returned. If yes, they're
-    // checked for whether they yield at least one output
-    tx_extra_pub_key pub_key_field;
-
-    if (!find_tx_extra_field_by_type(tx_extra_fields, pub_key_field, 0))
-    {
-        return null_pkey;
-    }
-
-    public_key tx_pub_key = pub_key_field.pub_key;
-
-    bool two_found = find_tx_extra_field_by_type(tx_extra_fields, pub_key_field, 1);
-
-    if (!two_found)
-    {
-        // easy case, just one found
-        return tx_pub_key;
-    }
-    else
-    {
-        // just return second one if there are two.
-        // this does not require private view key, as
-        // its not needed for my use case.
-        return pub_key_field.pub_key;
-    }
-
-    return null_pkey;
+    return parse_tx_extra_info(tx.extra).tx_pub_key;
 }
 
 
@@ -1079,7 +1056,7 @@ make_tx_from_json(const string& json_str, transaction& tx)
 
         public_key out_pub_key;
 
-        if (!epee::string_tools::hex_to_pod(vo["target"]["key"], out_pub_key))
+        if (!hex_to_pod(vo["target"]["key"], out_pub_key))
         {
             cerr << "Faild to parse public_key of an output from json" << endl;
             return false;
@@ -1099,7 +1076,7 @@ make_tx_from_json(const string& json_str, transaction& tx)
 
         key_image in_key_image;
 
-        if (!epee::string_tools::hex_to_pod(vi["key"]["k_image"], in_key_image))
+        if (!hex_to_pod(vi["key"]["k_image"], in_key_image))
         {
             cerr << "Faild to parse key_image of an input from json" << endl;
             return false;
@@ -1133,7 +1110,7 @@ make_tx_from_json(const string& json_str, transaction& tx)
             {
                 signature a_sig;
 
-                if (!epee::string_tools::hex_to_pod(string(b, e), a_sig))
+                if (!hex_to_pod(string(b, e), a_sig))
                 {
                     cerr << "Faild to parse signature from json" << endl;
                     return false;
@@ -1165,7 +1142,7 @@ make_tx_from_json(const string& json_str, transaction& tx)
             {
                 rct::key pOut_key;
 
-                if (!epee::string_tools::hex_to_pod(pOut, pOut_key))
+                if (!hex_to_pod(pOut, pOut_key))
                 {
                     cerr << "Faild to parse pOut_key of pseudoOuts from json" << endl;
                     return false;
@@ -1183,15 +1160,15 @@ make_tx_from_json(const string& json_str, transaction& tx)
 
             //cout << "ecdhI[\"amount\"]: " << ecdhI["amount"] << endl;
 
-            if (!epee::string_tools::hex_to_pod(ecdhI["amount"], a_tuple.amount))
+            if (!hex_to_pod(ecdhI["amount"], a_tuple.amount))
             {
                 cerr << "Faild to parse ecdhInfo of an amount from json" << endl;
                 return false;
             }
 
-            //cout << epee::string_tools::pod_to_hex(a_tuple.amount) << endl;
+            //cout << pod_to_hex(a_tuple.amount) << endl;
 
-            if (!epee::string_tools::hex_to_pod(ecdhI["mask"], a_tuple.mask))
+            if (!hex_to_pod(ecdhI["mask"], a_tuple.mask))
             {
                 cerr << "Faild to parse ecdhInfo of an mask from json" << endl;
                 return false;
@@ -1208,13 +1185,13 @@ make_tx_from_json(const string& json_str, transaction& tx)
 
             rct::key& mask = outPk.back().mask;
 
-            if (!epee::string_tools::hex_to_pod(pk, mask))
+            if (!hex_to_pod(pk, mask))
             {
                 cerr << "Faild to parse rct::key of an outPk from json" << endl;
                 return false;
             }
 
-            // cout << "dest: " << epee::string_tools::pod_to_hex(outPk.back().mask) << endl;
+            // cout << "dest: " << pod_to_hex(outPk.back().mask) << endl;
         }
 
         rct_signatures.txnFee = j["rct_signatures"]["txnFee"].get<uint64_t>();
@@ -1233,7 +1210,7 @@ make_tx_from_json(const string& json_str, transaction& tx)
         {
             rct::boroSig asig;
 
-            if (!epee::string_tools::hex_to_pod(range_s["asig"], asig))
+            if (!hex_to_pod(range_s["asig"], asig))
             {
                 cerr << "Faild to parse asig of an asnlSig from json" << endl;
                 return false;
@@ -1244,7 +1221,7 @@ make_tx_from_json(const string& json_str, transaction& tx)
                 rct::key64 Ci;
             } key64_contained;
 
-            if (!epee::string_tools::hex_to_pod(range_s["Ci"], key64_contained))
+            if (!hex_to_pod(range_s["Ci"], key64_contained))
             {
                 cerr << "Faild to parse Ci of an asnlSig from json" << endl;
                 return false;
@@ -1271,7 +1248,7 @@ make_tx_from_json(const string& json_str, transaction& tx)
             {
                 rct::key a_key1;
 
-                if (!epee::string_tools::hex_to_pod(ss_j[0], a_key1))
+                if (!hex_to_pod(ss_j[0], a_key1))
                 {
                     cerr << "Faild to parse ss a_key1 of an MGs from json" << endl;
                     return false;
@@ -1279,7 +1256,7 @@ make_tx_from_json(const string& json_str, transaction& tx)
 
                 rct::key a_key2;
 
-                if (!epee::string_tools::hex_to_pod(ss_j[1], a_key2))
+                if (!hex_to_pod(ss_j[1], a_key2))
                 {
                     cerr << "Faild to parse ss a_key2 of an MGs from json" << endl;
                     return false;
@@ -1290,7 +1267,7 @@ make_tx_from_json(const string& json_str, transaction& tx)
 
             json& cc_j = a_mgs["cc"];
 
-            if (!epee::string_tools::hex_to_pod(cc_j, new_mg_sig.cc))
+            if (!hex_to_pod(cc_j, new_mg_sig.cc))
             {
                 cerr << "Faild to parse cc an MGs from json" << endl;
                 return false;
@@ -1341,7 +1318,7 @@ hex_to_tx(string const& tx_hex, transaction& tx, crypto::hash& tx_hash,  crypto:
 {
     std::string tx_blob;
 
-    epee::string_tools::parse_hexstr_to_binbuff(tx_hex, tx_blob);
+    hex_to_buff(tx_hex, tx_blob);
 
     return parse_and_validate_tx_from_blob(tx_blob, tx, tx_hash, tx_prefix_hash);
 }
@@ -1349,7 +1326,7 @@ hex_to_tx(string const& tx_hex, transaction& tx, crypto::hash& tx_hash,  crypto:
 string
 tx_to_hex(transaction const& tx)
 {
-    return epee::string_tools::buff_to_hex_nodelimer(t_serializable_object_to_blob(tx));
+    return buff_to_hex(t_serializable_object_to_blob(tx));
 }
 
 string
@@ -1357,10 +1334,381 @@ hex_to_tx_blob(string const& tx_hex)
 {
     std::string tx_blob;
 
-    epee::string_tools::parse_hexstr_to_binbuff(tx_hex, tx_blob);
+    hex_to_buff(tx_hex, tx_blob);
 
     return tx_blob;
 }
 
+bool
+parse_date(string const& date_str, uint64_t& timestamp)
+{
+    int year, month, day;
+    char end;
+
+    if (sscanf(date_str.c_str(), "%4d-%2d-%2d%c",
+               &year, &month, &day, &end) != 3)
+        return false;
+
+    if (year < 1970 || month < 1 || month > 12 || day < 1)
+        return false;
+
+    bool const leap_year = (year % 4 == 0 && year % 100 != 0)
+                           || year % 400 == 0;
+
+    int const days_in_month[] {31, leap_year ? 29 : 28, 31, 30, 31, 30,
+                               31, 31, 30, 31, 30, 31};
+
+    if (day > days_in_month[month - 1])
+        return false;
+
+    // days since 1970-01-01, based on days_from_civil
+    // from http://howardhinnant.github.io/date_algorithms.html
+    int const y   = month <= 2 ? year - 1 : year;
+    int const era = y / 400;
+    int const yoe = y - era * 400;
+    int const doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    int64_t const days = static_cast<int64_t>(era) * 146097 + doe - 719468;
+
+    timestamp = static_cast<uint64_t>(days) * 86400;
+
+    return true;
+}
+
+/**
+ * Hex codec used by pod_to_hex and hex_to_pod.
+ *
+ * Keys, key images and hashes are converted to and from hex for
+ * every output, input and tx we send or get, so on x86-64 the
+ * conversion is done 16 (SSE2) or 32 (AVX2) bytes at a time.
+ * Which one is used is decided once, based on the cpu we run on.
+ */
+namespace
+{
+
+char const hex_digits[] = "0123456789abcdef";
+
+// value of hex digit, -1 for other chars
+inline int
+hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+
+    return -1;
+}
+
+void
+hex_encode_scalar(unsigned char const* in, size_t no_of_bytes, char* out)
+{
+    for (size_t i = 0; i < no_of_bytes; ++i)
+    {
+        out[2 * i]     = hex_digits[in[i] >> 4];
+        out[2 * i + 1] = hex_digits[in[i] & 0x0f];
+    }
+}
+
+bool
+hex_decode_scalar(char const* in, size_t no_of_bytes, unsigned char* out)
+{
+    for (size_t i = 0; i < no_of_bytes; ++i)
+    {
+        int const hi = hex_value(in[2 * i]);
+        int const lo = hex_value(in[2 * i + 1]);
+
+        if ((hi | lo) < 0)
+            return false;
+
+        out[i] = static_cast<unsigned char>(hi << 4 | lo);
+    }
+
+    return true;
+}
+
+#ifdef XMREG_HEX_X86
+
+// nibbles in 0..15 into '0'..'9', 'a'..'f'
+inline __m128i
+nibbles_to_hex_sse2(__m128i nibbles)
+{
+    __m128i const letters = _mm_and_si128(
+                _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)),
+                _mm_set1_epi8('a' - '0' - 10));
+
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+// hex digits into their values, in 16-bit lanes as
+// first digit << 4 | second digit. valid is set to
+// zero if any char is not a hex digit.
+inline __m128i
+hex_to_pairs_sse2(__m128i chars, __m128i& valid)
+{
+    // c - '0' in 0..9 only for '0'..'9', and lowercased
+    // c - 'a' in 0..5 only for 'a'..'f' and 'A'..'F'
+    __m128i const digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i const letters = _mm_sub_epi8(
+                _mm_or_si128(chars, _mm_set1_epi8(0x20)),
+                _mm_set1_epi8('a'));
+
+    __m128i const is_digit = _mm_and_si128(
+                _mm_cmpgt_epi8(digits, _mm_set1_epi8(-1)),
+                _mm_cmplt_epi8(digits, _mm_set1_epi8(10)));
+
+    __m128i const is_letter = _mm_and_si128(
+                _mm_cmpgt_epi8(letters, _mm_set1_epi8(-1)),
+                _mm_cmplt_epi8(letters, _mm_set1_epi8(6)));
+
+    valid = _mm_and_si128(valid, _mm_or_si128(is_digit, is_letter));
+
+    __m128i const values = _mm_or_si128(
+                _mm_and_si128(is_digit, digits),
+                _mm_and_si128(is_letter,
+                              _mm_add_epi8(letters, _mm_set1_epi8(10))));
+
+    return _mm_or_si128(
+                _mm_and_si128(_mm_slli_epi16(values, 4),
+                              _mm_set1_epi16(0x00f0)),
+                _mm_srli_epi16(values, 8));
+}
+
+void
+hex_encode_sse2(unsigned char const* in, size_t no_of_bytes, char* out)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= no_of_bytes; i += 16)
+    {
+        __m128i const bytes = _mm_loadu_si128(
+                    reinterpret_cast<__m128i const*>(in + i));
+
+        __m128i const hi = nibbles_to_hex_sse2(_mm_and_si128(
+                    _mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0f)));
+        __m128i const lo = nibbles_to_hex_sse2(_mm_and_si128(
+                    bytes, _mm_set1_epi8(0x0f)));
+
+        __m128i* dst = reinterpret_cast<__m128i*>(out + 2 * i);
+
+        _mm_storeu_si128(dst,     _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi8(hi, lo));
+    }
+
+    hex_encode_scalar(in + i, no_of_bytes - i, out + 2 * i);
+}
+
+bool
+hex_decode_sse2(char const* in, size_t no_of_bytes, unsigned char* out)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= no_of_bytes; i += 16)
+    {
+        __m128i const* src = reinterpret_cast<__m128i const*>(in + 2 * i);
+
+        __m128i valid = _mm_set1_epi8(-1);
+
+        __m128i const first = hex_to_pairs_sse2(_mm_loadu_si128(src), valid);
+        __m128i const second = hex_to_pairs_sse2(_mm_loadu_si128(src + 1), valid);
+
+        if (_mm_movemask_epi8(valid) != 0xffff)
+            return false;
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_packus_epi16(first, second));
+    }
+
+    return hex_decode_scalar(in + 2 * i, no_of_bytes - i, out + i);
+}
+
+__attribute__((target("avx2")))
+inline __m256i
+nibbles_to_hex_avx2(__m256i nibbles)
+{
+    __m256i const letters = _mm256_and_si256(
+                _mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9)),
+                _mm256_set1_epi8('a' - '0' - 10));
+
+    return _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')),
+                           letters);
+}
+
+__attribute__((target("avx2")))
+inline __m256i
+hex_to_pairs_avx2(__m256i chars, __m256i& valid)
+{
+    __m256i const digits = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    __m256i const letters = _mm256_sub_epi8(
+                _mm256_or_si256(chars, _mm256_set1_epi8(0x20)),
+                _mm256_set1_epi8('a'));
+
+    __m256i const is_digit = _mm256_andnot_si256(
+                _mm256_cmpgt_epi8(digits, _mm256_set1_epi8(9)),
+                _mm256_cmpgt_epi8(digits, _mm256_set1_epi8(-1)));
+
+    __m256i const is_letter = _mm256_andnot_si256(
+                _mm256_cmpgt_epi8(letters, _mm256_set1_epi8(5)),
+                _mm256_cmpgt_epi8(letters, _mm256_set1_epi8(-1)));
+
+    valid = _mm256_and_si256(valid, _mm256_or_si256(is_digit, is_letter));
+
+    __m256i const values = _mm256_or_si256(
+                _mm256_and_si256(is_digit, digits),
+                _mm256_and_si256(is_letter,
+                                 _mm256_add_epi8(letters,
+                                                 _mm256_set1_epi8(10))));
+
+    return _mm256_or_si256(
+                _mm256_and_si256(_mm256_slli_epi16(values, 4),
+                                 _mm256_set1_epi16(0x00f0)),
+                _mm256_srli_epi16(values, 8));
+}
+
+__attribute__((target("avx2")))
+void
+hex_encode_avx2(unsigned char const* in, size_t no_of_bytes, char* out)
+{
+    size_t i = 0;
+
+    for (; i + 32 <= no_of_bytes; i += 32)
+    {
+        __m256i const bytes = _mm256_loadu_si256(
+                    reinterpret_cast<__m256i const*>(in + i));
+
+        __m256i const hi = nibbles_to_hex_avx2(_mm256_and_si256(
+                    _mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0f)));
+        __m256i const lo = nibbles_to_hex_avx2(_mm256_and_si256(
+                    bytes, _mm256_set1_epi8(0x0f)));
+
+        // unpacking is done within 128-bit lanes, so the
+        // halves are put back in order afterwards
+        __m256i const first = _mm256_unpacklo_epi8(hi, lo);
+        __m256i const second = _mm256_unpackhi_epi8(hi, lo);
+
+        __m256i* dst = reinterpret_cast<__m256i*>(out + 2 * i);
+
+        _mm256_storeu_si256(dst,
+                _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(dst + 1,
+                _mm256_permute2x128_si256(first, second, 0x31));
+    }
+
+    hex_encode_sse2(in + i, no_of_bytes - i, out + 2 * i);
+}
+
+__attribute__((target("avx2")))
+bool
+hex_decode_avx2(char const* in, size_t no_of_bytes, unsigned char* out)
+{
+    size_t i = 0;
+
+    for (; i + 32 <= no_of_bytes; i += 32)
+    {
+        __m256i const* src = reinterpret_cast<__m256i const*>(in + 2 * i);
+
+        __m256i valid = _mm256_set1_epi8(-1);
+
+        __m256i const first = hex_to_pairs_avx2(
+                    _mm256_loadu_si256(src), valid);
+        __m256i const second = hex_to_pairs_avx2(
+                    _mm256_loadu_si256(src + 1), valid);
+
+        if (_mm256_movemask_epi8(valid) != -1)
+            return false;
+
+        // packing is done within 128-bit lanes too
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                _mm256_permute4x64_epi64(
+                        _mm256_packus_epi16(first, second), 0xd8));
+    }
+
+    return hex_decode_sse2(in + 2 * i, no_of_bytes - i, out + i);
+}
+
+#endif
+
+vector<hex_codec_t>
+make_hex_codecs()
+{
+    vector<hex_codec_t> codecs;
+
+#ifdef XMREG_HEX_X86
+    if (__builtin_cpu_supports("avx2"))
+        codecs.push_back({"avx2", hex_encode_avx2, hex_decode_avx2});
+
+    if (__builtin_cpu_supports("sse2"))
+        codecs.push_back({"sse2", hex_encode_sse2, hex_decode_sse2});
+#endif
+
+    codecs.push_back({"scalar", hex_encode_scalar, hex_decode_scalar});
+
+    return codecs;
+}
+
+hex_codec_t const&
+hex_codec()
+{
+    static hex_codec_t const codec = get_hex_codecs().front();
+    return codec;
+}
+
+}
+
+vector<hex_codec_t> const&
+get_hex_codecs()
+{
+    static vector<hex_codec_t> const codecs = make_hex_codecs();
+    return codecs;
+}
+
+void
+bytes_to_hex(void const* bytes, size_t no_of_bytes, char* hex)
+{
+    hex_codec().encode(static_cast<unsigned char const*>(bytes),
+                       no_of_bytes, hex);
+}
+
+bool
+hex_to_bytes(char const* hex, size_t no_of_bytes, void* bytes)
+{
+    return hex_codec().decode(hex, no_of_bytes,
+                              static_cast<unsigned char*>(bytes));
+}
+
+string
+buff_to_hex(string const& buff)
+{
+    string hex(2 * buff.size(), '\0');
+
+    bytes_to_hex(buff.data(), buff.size(), &hex[0]);
+
+    return hex;
+}
+
+bool
+hex_to_buff(string const& hex, string& buff)
+{
+    buff.clear();
+
+    if (hex.size() % 2 != 0)
+        return false;
+
+    buff.resize(hex.size() / 2);
+
+    if (!hex_to_bytes(hex.data(), buff.size(), &buff[0]))
+    {
+        buff.clear();
+        return false;
+    }
+
+    return true;
+}
+
 }
 
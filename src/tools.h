@@ -27,6 +27,7 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <iterator>
 #include <random>
 
 /**
@@ -48,8 +49,79 @@ namespace bf = boost::filesystem;
 
 using json = nlohmann::json;
 
-using  epee::string_tools::pod_to_hex;
-using  epee::string_tools::hex_to_pod;
+/**
+ * Write no_of_bytes bytes as 2 * no_of_bytes lowercase
+ * hex digits into hex. Uses SSE2 or AVX2 when cpu has them.
+ */
+void
+bytes_to_hex(void const* bytes, size_t no_of_bytes, char* hex);
+
+/**
+ * Read 2 * no_of_bytes hex digits (lower or upper case)
+ * into no_of_bytes bytes. False if there is any other char.
+ */
+bool
+hex_to_bytes(char const* hex, size_t no_of_bytes, void* bytes);
+
+string
+buff_to_hex(string const& buff);
+
+bool
+hex_to_buff(string const& hex, string& buff);
+
+/**
+ * Variant of the codec used by bytes_to_hex and hex_to_bytes.
+ */
+struct hex_codec_t
+{
+    char const* name;
+
+    void (*encode)(unsigned char const* in, size_t no_of_bytes, char* out);
+
+    bool (*decode)(char const* in, size_t no_of_bytes, unsigned char* out);
+};
+
+// variants which the cpu supports, fastest first. only the
+// first one is used, so this is for testing all of them.
+vector<hex_codec_t> const&
+get_hex_codecs();
+
+/**
+ * Same as epee's pod_to_hex and hex_to_pod, but using
+ * bytes_to_hex and hex_to_bytes.
+ */
+template <typename T>
+string
+pod_to_hex(T const& pod)
+{
+    static_assert(std::is_pod<T>::value, "expected pod type");
+
+    string hex(2 * sizeof(T), '\0');
+
+    bytes_to_hex(&pod, sizeof(T), &hex[0]);
+
+    return hex;
+}
+
+template <typename T>
+bool
+hex_to_pod(string const& hex, T& pod)
+{
+    static_assert(std::is_pod<T>::value, "expected pod type");
+
+    if (hex.size() != 2 * sizeof(T))
+        return false;
+
+    // pod is left as it was if hex is not valid
+    T parsed;
+
+    if (!hex_to_bytes(hex.data(), sizeof(T), &parsed))
+        return false;
+
+    pod = parsed;
+
+    return true;
+}
 
 template <typename T>
 bool
@@ -104,11 +176,11 @@ bool
 get_blockchain_path(string& blockchain_path,
                     network_type nettype = network_type::MAINNET);
 
-array<uint64_t, 4>
-summary_of_in_out_rct(
-        const transaction& tx,
-        vector<pair<txout_to_key, uint64_t>>& output_pub_keys,
-        vector<txin_to_key>& input_key_imgs);
+// same as the json version below:
+// {xmr_outputs, xmr_inputs, no_outputs, no_inputs, mixin_no, num_nonrct_inputs}
+// no_inputs counts only inputs to keys.
+array<uint64_t, 6>
+summary_of_in_out_rct(const transaction& tx);
 
 // this version for mempool txs from json
 array<uint64_t, 6>
@@ -153,6 +225,174 @@ get_ouputs_tuple(const transaction& tx);
 vector<txin_to_key>
 get_key_images(const transaction& tx);
 
+// output to a key, as yielded by outputs_to_key
+struct output_to_key_ref
+{
+    const txout_to_key& txout_k;
+    uint64_t amount;
+    uint64_t idx_in_tx;
+};
+
+/**
+ * Range over elements of tx.vout or tx.vin of one type, e.g.,
+ * only inputs to keys. They are yielded by Accessor::get as
+ * references to the elements, without copying them.
+ *
+ * Used as outputs_to_key(tx) and inputs_to_key(tx) in range-for
+ * loops, instead of copying outputs or inputs into new vectors.
+ * The tx must outlive the range.
+ */
+template <typename Accessor>
+class tx_elements_range
+{
+public:
+
+    using base_iterator = typename Accessor::base_iterator;
+
+    class iterator
+    {
+    public:
+
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = typename Accessor::value_type;
+        using reference         = typename Accessor::reference;
+        using pointer           = void;
+        using difference_type   = std::ptrdiff_t;
+
+        iterator(base_iterator _it, base_iterator _first, base_iterator _last)
+            : it {_it}, first {_first}, last {_last}
+        {
+            skip_other_types();
+        }
+
+        reference
+        operator*() const {return Accessor::get(it, first);}
+
+        iterator&
+        operator++()
+        {
+            ++it;
+            skip_other_types();
+            return *this;
+        }
+
+        bool
+        operator==(iterator const& other) const {return it == other.it;}
+
+        bool
+        operator!=(iterator const& other) const {return it != other.it;}
+
+    private:
+
+        void
+        skip_other_types()
+        {
+            while (it != last && !Accessor::matches(*it))
+                ++it;
+        }
+
+        base_iterator it;
+        base_iterator first;
+        base_iterator last;
+    };
+
+    tx_elements_range(base_iterator _first, base_iterator _last)
+        : first {_first}, last {_last}
+    {}
+
+    iterator
+    begin() const {return {first, first, last};}
+
+    iterator
+    end() const {return {last, first, last};}
+
+private:
+
+    base_iterator first;
+    base_iterator last;
+};
+
+struct output_to_key_accessor
+{
+    using base_iterator = vector<tx_out>::const_iterator;
+    using value_type    = output_to_key_ref;
+    using reference     = output_to_key_ref;
+
+    static bool
+    matches(tx_out const& out)
+    {
+        return out.target.type() == typeid(txout_to_key);
+    }
+
+    static output_to_key_ref
+    get(base_iterator it, base_iterator first)
+    {
+        return {boost::get<txout_to_key>(it->target), it->amount,
+                static_cast<uint64_t>(it - first)};
+    }
+};
+
+struct input_to_key_accessor
+{
+    using base_iterator = vector<txin_v>::const_iterator;
+    using value_type    = txin_to_key;
+    using reference     = const txin_to_key&;
+
+    static bool
+    matches(txin_v const& in)
+    {
+        return in.type() == typeid(txin_to_key);
+    }
+
+    static const txin_to_key&
+    get(base_iterator it, base_iterator)
+    {
+        return boost::get<txin_to_key>(*it);
+    }
+};
+
+// outputs to keys of the tx, with their amounts and indices in the tx
+inline tx_elements_range<output_to_key_accessor>
+outputs_to_key(const transaction& tx)
+{
+    return {tx.vout.begin(), tx.vout.end()};
+}
+
+// inputs to keys of the tx, i.e., its key images and ring members
+inline tx_elements_range<input_to_key_accessor>
+inputs_to_key(const transaction& tx)
+{
+    return {tx.vin.begin(), tx.vin.end()};
+}
+
+// fields of tx_extra used by the backend, parsed
+// in one pass over tx_extra
+struct tx_extra_info
+{
+    // same as returned by get_tx_pub_key_from_received_outs
+    public_key tx_pub_key {null_pkey};
+
+    vector<public_key> additional_tx_pub_keys;
+
+    crypto::hash payment_id {null_hash};
+
+    // encrypted, as found in tx_extra
+    crypto::hash8 payment_id8 {null_hash8};
+
+    string nonce;
+
+    // payment_id or payment_id8 as hex, or empty
+    // if there is no payment id
+    string
+    get_payment_id_str() const;
+};
+
+// if tx_extra can be parsed only partially, fields found
+// in the parsed part are returned, except payment ids and
+// nonce, which are then left empty
+tx_extra_info
+parse_tx_extra_info(const vector<uint8_t>& extra);
+
 bool
 get_payment_id(const vector<uint8_t>& extra,
                crypto::hash& payment_id,
@@ -192,6 +432,14 @@ decode_ringct(const rct::rctSig & rv,
               rct::key & mask,
               uint64_t & amount);
 
+// same as above, for already generated derivation of pub and sec
+bool
+decode_ringct(const rct::rctSig & rv,
+              const crypto::key_derivation &derivation,
+              unsigned int i,
+              rct::key & mask,
+              uint64_t & amount);
+
 bool
 url_decode(const std::string& in, std::string& out);
 
@@ -275,6 +523,13 @@ tx_to_hex(transaction const& tx);
 string
 hex_to_tx_blob(string const& tx_hex);
 
+/**
+ * Parse date in YYYY-MM-DD format into unix timestamp
+ * of its midnight in UTC.
+ */
+bool
+parse_date(string const& date_str, uint64_t& timestamp);
+
 
 }
 
@@ -4,7 +4,9 @@
 
 #include "../src/MicroCore.h"
 #include "../src/CurrentBlockchainStatus.h"
+#include "../src/TxSearch.h"
 #include "../src/ThreadRAII.h"
+#include "../src/YourMoneroRequests.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -30,6 +32,7 @@ using ::testing::Return;
 using ::testing::Throw;
 using ::testing::DoAll;
 using ::testing::SetArgReferee;
+using ::testing::Invoke;
 using ::testing::_;
 using ::testing::internal::FilePath;
 
@@ -64,10 +67,25 @@ public:
                        tx_out_index(uint64_t const& amount,
                                     uint64_t const& index));
 
+    MOCK_CONST_METHOD3(get_output_tx_and_index,
+                       void(uint64_t const& amount,
+                            vector<uint64_t> const& offsets,
+                            vector<tx_out_index>& indices));
+
     MOCK_CONST_METHOD2(get_tx,
                        bool(crypto::hash const& tx_hash,
                             transaction& tx));
 
+    MOCK_CONST_METHOD2(get_tx_blob,
+                       bool(crypto::hash const& tx_hash,
+                            string& tx_blob));
+
+    MOCK_METHOD0(start_batch_read, void());
+
+    MOCK_METHOD0(stop_batch_read, void());
+
+    MOCK_METHOD0(renew_batch_read, void());
+
     MOCK_METHOD3(get_output_key,
                     void(const uint64_t& amount,
                          const vector<uint64_t>& absolute_offsets,
@@ -84,6 +102,12 @@ public:
                         bool(COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request const& req,
                              COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res));
 
+    MOCK_CONST_METHOD5(get_output_distribution,
+                        bool(uint64_t amount, uint64_t from_height,
+                             uint64_t& start_height,
+                             std::vector<uint64_t>& distribution,
+                             uint64_t& base));
+
     MOCK_CONST_METHOD2(get_outs,
                         bool(const COMMAND_RPC_GET_OUTPUTS_BIN::request& req,
                              COMMAND_RPC_GET_OUTPUTS_BIN::response& res));
@@ -91,6 +115,8 @@ public:
     MOCK_CONST_METHOD1(get_dynamic_per_kb_fee_estimate,
                        uint64_t(uint64_t const& grace_blocks));
 
+    MOCK_CONST_METHOD1(get_block_timestamp, uint64_t(uint64_t height));
+
     MOCK_CONST_METHOD2(get_mempool_txs,
                        bool(vector<tx_info>& tx_infos,
                             vector<spent_key_image_info>& key_image_infos));
@@ -127,11 +153,14 @@ public:
 
     MOCK_CONST_METHOD0(get_searched_blk_no, uint64_t());
 
-    MOCK_METHOD0(get_known_outputs_keys,
-                 xmreg::TxSearch::known_outputs_t());
-
     MOCK_CONST_METHOD0(get_xmr_address_viewkey,
                  xmreg::TxSearch::addr_view_t());
+
+    MOCK_CONST_METHOD0(get_txs_found_in_mempool,
+                 std::shared_ptr<json const>());
+
+    MOCK_METHOD1(find_txs_in_mempool,
+                 json(xmreg::TxSearch::mempool_txs_t const& mempool_txs));
 };
 
 
@@ -369,6 +398,150 @@ TEST_P(BCSTATUS_TEST, GetTxWithOutputFailure)
                                         tx_returned, out_idx_returned));
 }
 
+TEST_P(BCSTATUS_TEST, ConstructOutputRctFieldsNonRct)
+{
+    // for non-ringct outputs, only their commitments are needed.
+    // no txs should be read.
+    COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount outs;
+
+    outs.amount = 11110;
+    outs.outs.push_back({4, {}});
+    outs.outs.push_back({7, {}});
+
+    vector<output_data_t> outputs_data(2);
+    outputs_data[0].commitment = rct::zeroCommit(outs.amount);
+    outputs_data[1].commitment = rct::zeroCommit(outs.amount);
+
+    EXPECT_CALL(*mcore_ptr, start_batch_read()).Times(1);
+    EXPECT_CALL(*mcore_ptr, stop_batch_read()).Times(1);
+
+    EXPECT_CALL(*mcore_ptr, get_output_key(_, _, _))
+            .WillOnce(SetArgReferee<2>(outputs_data));
+
+    EXPECT_CALL(*mcore_ptr, get_tx_blob(_, _)).Times(0);
+
+    vector<vector<tuple<string, string, string>>> rct_fields;
+
+    ASSERT_TRUE(bcs->construct_output_rct_fields({outs}, rct_fields));
+
+    ASSERT_EQ(rct_fields.size(), 1);
+    ASSERT_EQ(rct_fields[0].size(), 2);
+
+    EXPECT_EQ(std::get<0>(rct_fields[0][1]),
+              pod_to_hex(outputs_data[1].commitment));
+    EXPECT_EQ(std::get<1>(rct_fields[0][1]), string(64, '0'));
+    EXPECT_EQ(std::get<2>(rct_fields[0][1]), string(64, '0'));
+}
+
+TEST_P(BCSTATUS_TEST, ConstructOutputRctFieldsRct)
+{
+    // ringct tx with two outputs. only its base (prefix, ecdhInfo
+    // and outPk) is in the blob, as that is all what is parsed.
+    transaction tx;
+
+    tx.version = 2;
+    tx.vin.push_back(txin_to_key {0, {1},
+                                  crypto::rand<crypto::key_image>()});
+
+    tx.rct_signatures.type = rct::RCTTypeFull;
+    tx.rct_signatures.txnFee = 1000;
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        tx.vout.push_back(tx_out {0, txout_to_key {
+                                crypto::rand<crypto::public_key>()}});
+
+        tx.rct_signatures.ecdhInfo.push_back(
+                    {rct::skGen(), rct::skGen(), rct::zero()});
+
+        tx.rct_signatures.outPk.push_back(
+                    {rct::zero(), rct::scalarmultBase(rct::skGen())});
+    }
+
+    std::ostringstream ss;
+    binary_archive<true> ba(ss);
+
+    ASSERT_TRUE(tx.serialize_base(ba));
+
+    string tx_blob = ss.str();
+
+    RAND_TX_HASH();
+
+    COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount outs;
+
+    outs.amount = 0;
+    outs.outs.push_back({4, {}});
+    outs.outs.push_back({7, {}});
+
+    vector<output_data_t> outputs_data(2);
+    outputs_data[0].commitment = tx.rct_signatures.outPk[1].mask;
+    outputs_data[1].commitment = tx.rct_signatures.outPk[0].mask;
+
+    vector<tx_out_index> tx_out_indices {make_pair(tx_hash, 1),
+                                         make_pair(tx_hash, 0)};
+
+    EXPECT_CALL(*mcore_ptr, start_batch_read()).Times(1);
+    EXPECT_CALL(*mcore_ptr, stop_batch_read()).Times(1);
+
+    EXPECT_CALL(*mcore_ptr, get_output_key(_, _, _))
+            .WillOnce(SetArgReferee<2>(outputs_data));
+
+    EXPECT_CALL(*mcore_ptr, get_output_tx_and_index(_, _, _))
+            .WillOnce(SetArgReferee<2>(tx_out_indices));
+
+    // both outputs are from same tx, so it is read only once
+    EXPECT_CALL(*mcore_ptr, get_tx_blob(tx_hash, _))
+            .WillOnce(DoAll(SetArgReferee<1>(tx_blob), Return(true)));
+
+    vector<vector<tuple<string, string, string>>> rct_fields;
+
+    ASSERT_TRUE(bcs->construct_output_rct_fields({outs}, rct_fields));
+
+    ASSERT_EQ(rct_fields.size(), 1);
+    ASSERT_EQ(rct_fields[0].size(), 2);
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        size_t out_idx = tx_out_indices[i].second;
+
+        EXPECT_EQ(std::get<0>(rct_fields[0][i]),
+                  pod_to_hex(tx.rct_signatures.outPk[out_idx].mask));
+        EXPECT_EQ(std::get<1>(rct_fields[0][i]),
+                  pod_to_hex(tx.rct_signatures.ecdhInfo[out_idx].mask));
+        EXPECT_EQ(std::get<2>(rct_fields[0][i]),
+                  pod_to_hex(tx.rct_signatures.ecdhInfo[out_idx].amount));
+    }
+}
+
+TEST_P(BCSTATUS_TEST, ConstructOutputRctFieldsFailure)
+{
+    RAND_TX_HASH();
+
+    COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount outs;
+
+    outs.amount = 0;
+    outs.outs.push_back({4, {}});
+
+    vector<output_data_t> outputs_data(1);
+    vector<tx_out_index> tx_out_indices {make_pair(tx_hash, 1)};
+
+    EXPECT_CALL(*mcore_ptr, start_batch_read()).Times(1);
+    EXPECT_CALL(*mcore_ptr, stop_batch_read()).Times(1);
+
+    EXPECT_CALL(*mcore_ptr, get_output_key(_, _, _))
+            .WillOnce(SetArgReferee<2>(outputs_data));
+
+    EXPECT_CALL(*mcore_ptr, get_output_tx_and_index(_, _, _))
+            .WillOnce(SetArgReferee<2>(tx_out_indices));
+
+    EXPECT_CALL(*mcore_ptr, get_tx_blob(_, _))
+            .WillOnce(Return(false));
+
+    vector<vector<tuple<string, string, string>>> rct_fields;
+
+    EXPECT_FALSE(bcs->construct_output_rct_fields({outs}, rct_fields));
+}
+
 TEST_P(BCSTATUS_TEST, GetCurrentHeight)
 {
     uint64_t mock_current_height {1619148};
@@ -487,6 +660,12 @@ TEST_P(BCSTATUS_TEST, IsTxSpendtimeUnlockedScenario2)
 
 TEST_P(BCSTATUS_TEST, GetOutputKeys)
 {
+    // outputs must be old enough to be cached
+    EXPECT_CALL(*mcore_ptr, get_current_blockchain_height())
+            .WillOnce(Return(10000));
+
+    bcs->update_current_blockchain_height();
+
     // we are going to expect two outputs
     vector<output_data_t> outputs_to_return;
 
@@ -506,7 +685,7 @@ TEST_P(BCSTATUS_TEST, GetOutputKeys)
             .WillOnce(SetArgReferee<2>(outputs_to_return));
 
     const uint64_t mock_amount {1111};
-    const vector<uint64_t> mock_absolute_offsets;
+    const vector<uint64_t> mock_absolute_offsets {4, 7};
     vector<cryptonote::output_data_t> outputs;
 
     EXPECT_TRUE(bcs->get_output_keys(mock_amount,
@@ -515,14 +694,238 @@ TEST_P(BCSTATUS_TEST, GetOutputKeys)
 
     EXPECT_EQ(outputs.back().pubkey, outputs_to_return.back().pubkey);
 
+    // second time, the outputs should come from the cache,
+    // so the mock above must not be called again
+
+    outputs.clear();
+
+    EXPECT_TRUE(bcs->get_output_keys(mock_amount,
+                                     mock_absolute_offsets,
+                                     outputs));
+
+    EXPECT_EQ(outputs.front().pubkey, outputs_to_return.front().pubkey);
+    EXPECT_EQ(outputs.back().pubkey, outputs_to_return.back().pubkey);
+
+    EXPECT_EQ(bcs->get_output_key_cache().get_no_of_hits(), 2);
+
+    // output not in the cache, and not in the blockchain
+
     EXPECT_CALL(*mcore_ptr, get_output_key(_, _, _))
             .WillOnce(ThrowOutputDNE());
 
     EXPECT_FALSE(bcs->get_output_keys(mock_amount,
-                                      mock_absolute_offsets,
+                                      {4, 8},
                                       outputs));
 }
 
+TEST_P(BCSTATUS_TEST, GetRingMembers)
+{
+    // two txs with rings sharing outputs 5 and 9 of zero amount,
+    // and one input of non-zero amount
+    auto make_input = [](uint64_t amount, vector<uint64_t> offsets)
+    {
+        txin_to_key in_key;
+        in_key.amount      = amount;
+        in_key.key_offsets = cryptonote::absolute_output_offsets_to_relative(
+                    offsets);
+        in_key.k_image     = crypto::rand<crypto::key_image>();
+        return in_key;
+    };
+
+    transaction tx1, tx2;
+
+    tx1.vin.push_back(make_input(0, {2, 5, 9}));
+    tx2.vin.push_back(make_input(0, {5, 9, 12}));
+    tx2.vin.push_back(make_input(1000, {3}));
+
+    vector<CurrentBlockchainStatus::txs_tuple_t> txs_data;
+
+    txs_data.emplace_back(crypto::rand<crypto::hash>(), tx1, 100, 0, false,
+                          0, vector<uint64_t>{}, xmreg::tx_extra_info{});
+    txs_data.emplace_back(crypto::rand<crypto::hash>(), tx2, 100, 0, false,
+                          0, vector<uint64_t>{}, xmreg::tx_extra_info{});
+
+    auto return_outputs = [](uint64_t const&,
+                             vector<uint64_t> const& offsets,
+                             vector<output_data_t>& outputs)
+    {
+        outputs.clear();
+
+        for (uint64_t offset: offsets)
+        {
+            output_data_t od {};
+            od.unlock_time = offset;
+            outputs.push_back(od);
+        }
+    };
+
+    EXPECT_CALL(*mcore_ptr, start_batch_read()).Times(1);
+    EXPECT_CALL(*mcore_ptr, stop_batch_read()).Times(1);
+
+    // each amount is read once, with sorted and unique indices
+    EXPECT_CALL(*mcore_ptr, get_output_key(0, vector<uint64_t>{2, 5, 9, 12}, _))
+            .WillOnce(Invoke(return_outputs));
+
+    EXPECT_CALL(*mcore_ptr, get_output_key(1000, vector<uint64_t>{3}, _))
+            .WillOnce(Invoke(return_outputs));
+
+    auto ring_members = bcs->get_ring_members(txs_data);
+
+    ASSERT_TRUE(ring_members);
+    ASSERT_EQ(ring_members->size(), 5);
+
+    EXPECT_EQ(ring_members->at({0, 12}).unlock_time, 12);
+    EXPECT_EQ(ring_members->at({1000, 3}).unlock_time, 3);
+
+    // same blocks analyzed by another search thread
+    // are not read again
+    EXPECT_EQ(bcs->get_ring_members(txs_data), ring_members);
+
+    // too many ring members in a range are not read at once
+    vector<uint64_t> many_offsets(200001);
+    std::iota(many_offsets.begin(), many_offsets.end(), 0);
+
+    transaction big_tx;
+
+    big_tx.vin.push_back(make_input(0, many_offsets));
+
+    txs_data.emplace_back(crypto::rand<crypto::hash>(), big_tx, 101, 0,
+                          false, 0, vector<uint64_t>{},
+                          xmreg::tx_extra_info{});
+
+    EXPECT_FALSE(bcs->get_ring_members(txs_data));
+}
+
+TEST_P(BCSTATUS_TEST, GetPrecomputedTxPubKeys)
+{
+    keypair tx_key = keypair::generate(hw::get_device("default"));
+
+    transaction tx;
+
+    add_tx_pub_key_to_extra(tx, tx_key.pub);
+
+    vector<CurrentBlockchainStatus::txs_tuple_t> txs_data;
+
+    txs_data.emplace_back(crypto::rand<crypto::hash>(), tx, 100, 0, false,
+                          0, vector<uint64_t>{},
+                          xmreg::parse_tx_extra_info(tx.extra));
+
+    auto tx_pub_keys = bcs->get_precomputed_tx_pub_keys(txs_data);
+
+    ASSERT_TRUE(tx_pub_keys);
+    ASSERT_EQ(tx_pub_keys->size(), 1);
+    ASSERT_TRUE(tx_pub_keys->front().is_initialized());
+
+    // derivations are same as without precomputation
+    for (size_t i = 0; i < 3; ++i)
+    {
+        keypair view_key = keypair::generate(hw::get_device("default"));
+
+        key_derivation expected_derivation;
+        key_derivation derivation;
+
+        ASSERT_TRUE(generate_key_derivation(tx_key.pub, view_key.sec,
+                                            expected_derivation));
+
+        ASSERT_TRUE(tx_pub_keys->front().generate_key_derivation(
+                view_key.sec, derivation));
+
+        EXPECT_EQ(pod_to_hex(derivation), pod_to_hex(expected_derivation));
+    }
+
+    // same blocks analyzed by another search thread
+    // are not precomputed again
+    EXPECT_EQ(bcs->get_precomputed_tx_pub_keys(txs_data), tx_pub_keys);
+}
+
+TEST_P(BCSTATUS_TEST, IdentifyOutputsWithAdditionalTxPubKeys)
+{
+    account_base account;
+    account.generate();
+
+    account_keys const& keys = account.get_keys();
+
+    address_parse_info address {keys.m_account_address, false, false,
+                                crypto::null_hash8};
+
+    xmreg::SubaddressTable subaddresses {address, keys.m_view_secret_key,
+                                         2, 3};
+
+    hw::device& hwdev = hw::get_device("default");
+
+    subaddress_index const index {1, 2};
+
+    account_public_address const subaddress
+            = hwdev.get_subaddress(keys, index);
+
+    // tx with two outputs to the subaddress, each with its own
+    // additional tx pub key, as wallet2 makes them
+    transaction tx;
+    tx.version = 1;
+
+    add_tx_pub_key_to_extra(tx, keypair::generate(hwdev).pub);
+
+    vector<public_key> additional_tx_pub_keys;
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        keypair additional_tx_key = keypair::generate(hwdev);
+
+        // r * D, where D is the subaddress's spend public key
+        additional_tx_pub_keys.push_back(rct::rct2pk(rct::scalarmultKey(
+                rct::pk2rct(subaddress.m_spend_public_key),
+                rct::sk2rct(additional_tx_key.sec))));
+
+        key_derivation derivation;
+
+        ASSERT_TRUE(generate_key_derivation(subaddress.m_view_public_key,
+                                            additional_tx_key.sec,
+                                            derivation));
+
+        txout_to_key out_to_key;
+
+        ASSERT_TRUE(derive_public_key(derivation, i,
+                                      subaddress.m_spend_public_key,
+                                      out_to_key.key));
+
+        tx.vout.push_back(tx_out {1000 * (i + 1), out_to_key});
+    }
+
+    ASSERT_TRUE(add_additional_tx_pub_keys_to_extra(tx.extra,
+                                                    additional_tx_pub_keys));
+
+    xmreg::OutputInputIdentification oi {&address, &keys.m_view_secret_key,
+                                         &tx, get_transaction_hash(tx),
+                                         false, nullptr, nullptr,
+                                         &subaddresses};
+
+    oi.identify_outputs();
+
+    ASSERT_EQ(oi.identified_outputs.size(), 2);
+    EXPECT_EQ(oi.total_received, 3000);
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        auto const& out_info = oi.identified_outputs[i];
+
+        EXPECT_EQ(out_info.idx_in_tx, i);
+        EXPECT_EQ(out_info.amount, 1000 * (i + 1));
+        EXPECT_EQ(pod_to_hex(out_info.tx_pub_key),
+                  pod_to_hex(additional_tx_pub_keys[i]));
+        EXPECT_EQ(out_info.subaddr_index.major, index.major);
+        EXPECT_EQ(out_info.subaddr_index.minor, index.minor);
+    }
+
+    // without subaddresses, only the main address is checked
+    xmreg::OutputInputIdentification oi2 {&address, &keys.m_view_secret_key,
+                                          &tx, get_transaction_hash(tx),
+                                          false, nullptr};
+
+    oi2.identify_outputs();
+
+    EXPECT_TRUE(oi2.identified_outputs.empty());
+}
+
 TEST_P(BCSTATUS_TEST, GetAccountIntegratedAddressAsStr)
 {
     // bcs->get_account_integrated_address_as_str only forwards
@@ -631,6 +1034,129 @@ TEST_P(BCSTATUS_TEST, GetRandomOutputs)
                     found_outputs));
 }
 
+TEST_P(BCSTATUS_TEST, GetRandomRctOutputsFromDistribution)
+{
+    // 2000 blocks with 5 ringct outputs each, starting at height 100
+    const uint64_t mock_start_height {100};
+    const vector<uint64_t> mock_distribution(2000, 5);
+
+    EXPECT_CALL(*mcore_ptr, get_current_blockchain_height())
+            .WillRepeatedly(Return(mock_start_height
+                                   + mock_distribution.size()));
+
+    bcs->update_current_blockchain_height();
+
+    EXPECT_FALSE(bcs->is_rct_output_distribution_ready());
+
+    EXPECT_CALL(*mcore_ptr, get_output_distribution(0, 0, _, _, _))
+            .WillOnce(DoAll(SetArgReferee<2>(mock_start_height),
+                            SetArgReferee<3>(mock_distribution),
+                            SetArgReferee<4>(0),
+                            Return(true)));
+
+    ASSERT_TRUE(bcs->update_rct_output_distribution());
+    ASSERT_TRUE(bcs->is_rct_output_distribution_ready());
+
+    // no new blocks, so nothing is read again
+    EXPECT_TRUE(bcs->update_rct_output_distribution());
+
+    // all picked outputs are old enough to be unlocked
+    EXPECT_CALL(*mcore_ptr, get_output_key(0, _, _))
+            .WillOnce(Invoke([&](uint64_t const&,
+                                 vector<uint64_t> const& offsets,
+                                 vector<output_data_t>& outputs)
+                             {
+                                 output_data_t od {};
+                                 od.height = mock_start_height;
+                                 outputs.assign(offsets.size(), od);
+                             }));
+
+    vector<vector<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry>>
+            rings;
+
+    const uint64_t mock_outs_count {11};
+
+    ASSERT_TRUE(bcs->get_random_rct_outputs(2, mock_outs_count, rings));
+
+    ASSERT_EQ(rings.size(), 2);
+
+    // only outputs at least 10 blocks old can be picked
+    const uint64_t max_index = (mock_distribution.size()
+                                - CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE + 1) * 5;
+
+    for (auto const& ring: rings)
+    {
+        ASSERT_EQ(ring.size(), mock_outs_count);
+
+        for (size_t i = 0; i < ring.size(); ++i)
+        {
+            EXPECT_LT(ring[i].global_amount_index, max_index);
+
+            // sorted and unique
+            if (i > 0)
+                EXPECT_LT(ring[i - 1].global_amount_index,
+                          ring[i].global_amount_index);
+        }
+    }
+
+    // two new blocks. the distribution is not read from monero
+    // again. instead, outputs are counted in the new blocks, and
+    // in the top blocks of the cached distribution.
+    const uint64_t new_height {mock_start_height
+                               + mock_distribution.size() + 2};
+
+    EXPECT_CALL(*mcore_ptr, get_current_blockchain_height())
+            .WillRepeatedly(Return(new_height));
+
+    bcs->update_current_blockchain_height();
+
+    transaction tx;
+
+    tx.version = 2;
+    tx.vin.push_back(txin_to_key {0, {1},
+                                  crypto::rand<crypto::key_image>()});
+    tx.vout.resize(2);
+
+    string tx_blob = t_serializable_object_to_blob(tx);
+
+    block blk;
+
+    blk.miner_tx.version = 2;
+    blk.miner_tx.vin.push_back(txin_gen {1000});
+    blk.miner_tx.vout.resize(1);
+    blk.tx_hashes.push_back(crypto::rand<crypto::hash>());
+
+    const uint64_t from_height {new_height - 2
+                                - CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE};
+
+    EXPECT_CALL(*mcore_ptr, get_blocks_range(from_height, new_height - 1))
+            .WillOnce(Return(vector<block>(new_height - from_height, blk)));
+
+    EXPECT_CALL(*mcore_ptr, get_tx_blob(blk.tx_hashes[0], _))
+            .Times(new_height - from_height)
+            .WillRepeatedly(DoAll(SetArgReferee<1>(tx_blob),
+                                  Return(true)));
+
+    EXPECT_CALL(*mcore_ptr, start_batch_read()).Times(1);
+    EXPECT_CALL(*mcore_ptr, stop_batch_read()).Times(1);
+
+    EXPECT_TRUE(bcs->update_rct_output_distribution());
+    EXPECT_TRUE(bcs->is_rct_output_distribution_ready());
+
+    // blocks cant be read, e.g., blockchain got popped. so cached
+    // distribution is dropped, to be read again from scratch.
+    EXPECT_CALL(*mcore_ptr, get_current_blockchain_height())
+            .WillRepeatedly(Return(new_height + 1));
+
+    bcs->update_current_blockchain_height();
+
+    EXPECT_CALL(*mcore_ptr, get_blocks_range(_, _))
+            .WillOnce(Return(vector<block>{}));
+
+    EXPECT_FALSE(bcs->update_rct_output_distribution());
+    EXPECT_FALSE(bcs->is_rct_output_distribution_ready());
+}
+
 TEST_P(BCSTATUS_TEST, GetOutput)
 {
     using outkey = COMMAND_RPC_GET_OUTPUTS_BIN::outkey;
@@ -674,6 +1200,231 @@ TEST_P(BCSTATUS_TEST, GetDynamicPerKbFeeEstimate)
     EXPECT_EQ(bcs->get_dynamic_per_kb_fee_estimate(), 3333);
 }
 
+TEST_P(BCSTATUS_TEST, UpdateBlockchainSnapshot)
+{
+    EXPECT_FALSE(bcs->get_blockchain_snapshot());
+
+    block tip {};
+    tip.timestamp = 1530000000;
+
+    EXPECT_CALL(*mcore_ptr, get_block_from_height(_, _))
+            .WillRepeatedly(DoAll(SetArgReferee<1>(tip), Return(true)));
+
+    // fee is read only once for the same top block
+    EXPECT_CALL(*mcore_ptr, get_dynamic_per_kb_fee_estimate(_))
+            .WillOnce(Return(3333));
+
+    EXPECT_TRUE(bcs->update_blockchain_snapshot());
+    EXPECT_TRUE(bcs->update_blockchain_snapshot());
+
+    auto snapshot = bcs->get_blockchain_snapshot();
+
+    ASSERT_TRUE(snapshot);
+
+    EXPECT_EQ(snapshot->tip_hash, get_block_hash(tip));
+
+    // now served from the snapshot, without calling mcore
+    EXPECT_EQ(bcs->get_dynamic_per_kb_fee_estimate(), 3333);
+
+    EXPECT_CALL(*mcore_ptr, get_block_from_height(_, _))
+            .WillOnce(Return(false));
+
+    EXPECT_FALSE(bcs->update_blockchain_snapshot());
+
+    // old snapshot is kept
+    EXPECT_EQ(bcs->get_blockchain_snapshot(), snapshot);
+}
+
+TEST_P(BCSTATUS_TEST, GetTxsInBlocks)
+{
+    block blk;
+
+    blk.timestamp = 1530000000;
+    blk.miner_tx.version = 2;
+    blk.miner_tx.vin.push_back(txin_gen {1000});
+
+    transaction tx;
+
+    tx.version = 1;
+    tx.vin.push_back(txin_to_key {0, {1, 2, 3},
+                                  crypto::rand<crypto::key_image>()});
+
+    public_key tx_pub_key = crypto::rand<public_key>();
+
+    add_tx_pub_key_to_extra(tx, tx_pub_key);
+
+    string tx_blob = t_serializable_object_to_blob(tx);
+
+    crypto::hash tx_hash = crypto::rand<crypto::hash>();
+
+    blk.tx_hashes.push_back(tx_hash);
+
+    EXPECT_CALL(*mcore_ptr, start_batch_read()).Times(1);
+    EXPECT_CALL(*mcore_ptr, stop_batch_read()).Times(1);
+
+    // coinbase tx is taken from the block, so only
+    // the other tx should be read
+    EXPECT_CALL(*mcore_ptr, get_tx_blob(tx_hash, _))
+            .WillOnce(DoAll(SetArgReferee<1>(tx_blob), Return(true)));
+
+    vector<CurrentBlockchainStatus::txs_tuple_t> txs_data;
+
+    ASSERT_TRUE(bcs->get_txs_in_blocks({blk}, txs_data));
+
+    ASSERT_EQ(txs_data.size(), 2);
+
+    EXPECT_TRUE(std::get<4>(txs_data[0]));
+    EXPECT_EQ(std::get<2>(txs_data[0]), 1000);
+    EXPECT_EQ(std::get<1>(txs_data[0]).vin.size(), 1);
+
+    EXPECT_EQ(std::get<0>(txs_data[1]), tx_hash);
+    EXPECT_FALSE(std::get<4>(txs_data[1]));
+    EXPECT_EQ(std::get<3>(txs_data[1]), blk.timestamp);
+    EXPECT_EQ(boost::get<txin_to_key>(std::get<1>(txs_data[1]).vin[0])
+                .key_offsets.size(), 3);
+
+    // tx_extra is parsed, so that its users dont parse it again
+    EXPECT_EQ(std::get<7>(txs_data[0]).tx_pub_key, null_pkey);
+    EXPECT_EQ(pod_to_hex(std::get<7>(txs_data[1]).tx_pub_key),
+              pod_to_hex(tx_pub_key));
+
+    EXPECT_CALL(*mcore_ptr, start_batch_read()).Times(1);
+    EXPECT_CALL(*mcore_ptr, stop_batch_read()).Times(1);
+
+    EXPECT_CALL(*mcore_ptr, get_tx_blob(_, _))
+            .WillOnce(Return(false));
+
+    txs_data.clear();
+
+    EXPECT_FALSE(bcs->get_txs_in_blocks({blk}, txs_data));
+
+    // output indices are not filled in, but read only on
+    // demand, and only once
+    EXPECT_CALL(*mcore_ptr, start_batch_read()).Times(1);
+    EXPECT_CALL(*mcore_ptr, stop_batch_read()).Times(1);
+
+    EXPECT_CALL(*mcore_ptr, get_tx_blob(tx_hash, _))
+            .WillOnce(DoAll(SetArgReferee<1>(tx_blob), Return(true)));
+
+    EXPECT_CALL(*mcore_ptr, tx_exists(_, _)).Times(0);
+
+    txs_data.clear();
+
+    ASSERT_TRUE(bcs->get_txs_in_blocks({blk}, txs_data));
+
+    EXPECT_TRUE(std::get<6>(txs_data[1]).empty());
+
+    EXPECT_CALL(*mcore_ptr, tx_exists(std::get<0>(txs_data[1]), _))
+            .WillOnce(DoAll(SetArgReferee<1>(21), Return(true)));
+
+    EXPECT_CALL(*mcore_ptr, get_tx_amount_output_indices(21))
+            .WillOnce(Return(vector<uint64_t>{6, 7}));
+
+    ASSERT_TRUE(bcs->get_tx_output_indices(txs_data[1]));
+    ASSERT_TRUE(bcs->get_tx_output_indices(txs_data[1]));
+
+    EXPECT_EQ(std::get<5>(txs_data[1]), 21);
+    EXPECT_EQ(std::get<6>(txs_data[1]), (vector<uint64_t>{6, 7}));
+
+    EXPECT_CALL(*mcore_ptr, tx_exists(std::get<0>(txs_data[0]), _))
+            .WillOnce(Return(false));
+
+    EXPECT_FALSE(bcs->get_tx_output_indices(txs_data[0]));
+}
+
+TEST_P(BCSTATUS_TEST, KnownOutputsIndex)
+{
+    KnownOutputsIndex& index = bcs->get_known_outputs_index();
+
+    public_key out_pk = crypto::rand<public_key>();
+
+    KnownOutputsIndex::known_output_t known_output;
+
+    EXPECT_FALSE(index.find(out_pk, known_output));
+
+    index.insert(out_pk, {3, 44, 1000});
+
+    ASSERT_TRUE(index.find(out_pk, known_output));
+    EXPECT_EQ(known_output.account_id, 3);
+    EXPECT_EQ(known_output.output_id, 44);
+    EXPECT_EQ(known_output.amount, 1000);
+
+    // same output found again by rescan was inserted into
+    // mysql again, so its old id is not valid anymore
+    index.insert(out_pk, {3, 0, 1000});
+
+    ASSERT_TRUE(index.find(out_pk, known_output));
+    EXPECT_EQ(known_output.output_id, 0);
+
+    EXPECT_EQ(index.size(), 1);
+    EXPECT_GT(index.memory_usage(), 0);
+
+    // output of other account
+    public_key out_pk2 = crypto::rand<public_key>();
+
+    index.acquire(4);
+    index.insert(out_pk2, {4, 45, 2000});
+
+    // account 3 has two search threads, e.g., new one started
+    // before the stopped one was destroyed
+    index.acquire(3);
+    index.acquire(3);
+
+    index.release(3);
+
+    EXPECT_TRUE(index.find(out_pk, known_output));
+
+    // last thread of the account removes its outputs only
+    index.release(3);
+
+    EXPECT_FALSE(index.find(out_pk, known_output));
+    EXPECT_TRUE(index.find(out_pk2, known_output));
+
+    // releasing not acquired account does nothing
+    index.release(3);
+
+    EXPECT_TRUE(index.find(out_pk2, known_output));
+    EXPECT_EQ(index.size(), 1);
+}
+
+TEST_P(BCSTATUS_TEST, GetHeightForTimestamp)
+{
+    uint64_t height {0};
+
+    // index not built yet
+    EXPECT_FALSE(bcs->get_height_for_timestamp(1000, height));
+
+    EXPECT_CALL(*mcore_ptr, get_current_blockchain_height())
+            .WillOnce(Return(5));
+
+    bcs->update_current_blockchain_height();
+
+    // timestamps of blocks 0 to 4 are not monotonic
+    vector<uint64_t> block_timestamps {100, 300, 200, 400, 500};
+
+    EXPECT_CALL(*mcore_ptr, start_batch_read()).Times(1);
+    EXPECT_CALL(*mcore_ptr, stop_batch_read()).Times(1);
+
+    EXPECT_CALL(*mcore_ptr, get_block_timestamp(_))
+            .WillRepeatedly(Invoke([&](uint64_t h)
+                                   {return block_timestamps.at(h);}));
+
+    ASSERT_TRUE(bcs->update_block_timestamp_index());
+
+    EXPECT_TRUE(bcs->get_height_for_timestamp(250, height));
+    EXPECT_EQ(height, 1);
+
+    EXPECT_TRUE(bcs->get_height_for_timestamp(50, height));
+    EXPECT_EQ(height, 0);
+
+    EXPECT_TRUE(bcs->get_height_for_timestamp(450, height));
+    EXPECT_EQ(height, 4);
+
+    // newer than the top block
+    EXPECT_TRUE(bcs->get_height_for_timestamp(1000, height));
+    EXPECT_EQ(height, 5);
+}
+
 TEST_P(BCSTATUS_TEST, CommitTx)
 {
     EXPECT_CALL(*rpc_ptr, commit_tx(_, _, _))
@@ -705,7 +1456,7 @@ TEST_P(BCSTATUS_TEST, ReadMempool)
     mempool_txs_to_return.back().tx_blob = tx_blob;
 
     EXPECT_CALL(*mcore_ptr, get_mempool_txs(_, _))
-            .WillOnce(DoAll(
+            .WillRepeatedly(DoAll(
                           SetArgReferee<0>(mempool_txs_to_return),
                           Return(true)));
 
@@ -719,6 +1470,22 @@ TEST_P(BCSTATUS_TEST, ReadMempool)
 
     EXPECT_EQ(get_transaction_hash(mempool_txs[0].second),
             tx_hash);
+
+    auto mempool_snapshot = bcs->get_mempool_txs_snapshot();
+
+    // same txs, so search threads get the same snapshot
+    // and dont search it again
+    EXPECT_TRUE(bcs->read_mempool());
+    EXPECT_EQ(bcs->get_mempool_txs_snapshot(), mempool_snapshot);
+
+    EXPECT_CALL(*mcore_ptr, get_mempool_txs(_, _))
+            .WillRepeatedly(DoAll(
+                          SetArgReferee<0>(vector<tx_info>{}),
+                          Return(true)));
+
+    EXPECT_TRUE(bcs->read_mempool());
+    EXPECT_NE(bcs->get_mempool_txs_snapshot(), mempool_snapshot);
+    EXPECT_TRUE(bcs->get_mempool_txs_snapshot()->empty());
 }
 
 
@@ -838,9 +1605,21 @@ TEST_P(BCSTATUS_TEST, SearchIfPaymentMade)
 
     ASSERT_TRUE(bcs->read_mempool());
 
-
     string tx_hash_with_payment;
 
+    // payments are not searched for on request,
+    // so nothing can be found before the watcher runs
+    EXPECT_FALSE(bcs->search_if_payment_made(expected_payment_id_str,
+                                             desired_amount,
+                                             tx_hash_with_payment));
+
+    // blocks cant be read, but mempool
+    // txs should have been scanned anyway
+    EXPECT_CALL(*mcore_ptr, get_blocks_range(_, _))
+            .WillRepeatedly(Return(vector<block>{}));
+
+    EXPECT_FALSE(bcs->update_import_payments());
+
     EXPECT_TRUE(bcs->search_if_payment_made(expected_payment_id_str,
                                             desired_amount,
                                             tx_hash_with_payment));
@@ -853,24 +1632,36 @@ TEST_P(BCSTATUS_TEST, SearchIfPaymentMade)
                                             desired_amount*2,
                                             tx_hash_with_payment));
 
-    EXPECT_CALL(*mcore_ptr, get_block_from_height(_, _))
-            .WillRepeatedly(DoAll(SetArgReferee<1>(mock_blk),
-                            Return(false)));
+    // unknown payment id
+    EXPECT_FALSE(bcs->search_if_payment_made("0000000000000000",
+                                            desired_amount,
+                                            tx_hash_with_payment));
 
-    EXPECT_FALSE(bcs->search_if_payment_made(expected_payment_id_str,
+    // second scan of the same mempool txs should
+    // not change anything
+    EXPECT_FALSE(bcs->update_import_payments());
+
+    EXPECT_TRUE(bcs->search_if_payment_made(expected_payment_id_str,
                                             desired_amount,
                                             tx_hash_with_payment));
 
-    EXPECT_CALL(*mcore_ptr, get_block_from_height(_, _))
-            .WillRepeatedly(DoAll(SetArgReferee<1>(mock_blk),
-                            Return(true)));
+    // the tx left the mempool, but it is not in any block,
+    // so its payment is forgotten
+    EXPECT_CALL(*mcore_ptr, get_mempool_txs(_, _))
+            .WillRepeatedly(DoAll(
+                          SetArgReferee<0>(vector<tx_info>{}),
+                          Return(true)));
 
-    EXPECT_CALL(*mcore_ptr, get_transactions(_, _, _))
-            .WillRepeatedly(Return(false));
+    ASSERT_TRUE(bcs->read_mempool());
+
+    EXPECT_CALL(*mcore_ptr, get_blocks_range(_, _))
+            .WillRepeatedly(Return(vector<block>{mock_blk}));
+
+    EXPECT_TRUE(bcs->update_import_payments());
 
     EXPECT_FALSE(bcs->search_if_payment_made(expected_payment_id_str,
-                                            desired_amount,
-                                            tx_hash_with_payment));
+                                             desired_amount,
+                                             tx_hash_with_payment));
 }
 
 TEST_P(BCSTATUS_TEST, GetOutputKey)
@@ -900,6 +1691,14 @@ TEST_P(BCSTATUS_TEST, StartTxSearchThread)
 {
     xmreg::XmrAccount acc; // empty, mock account
 
+    acc.address = "whatever mock address";
+
+    // search threads are kept by parsed addresses
+    EXPECT_FALSE(bcs->start_tx_search_thread(
+                     acc, std::make_unique<MockTxSearch>()));
+
+    acc.address = bcs->get_bc_setup().import_payment_address_str;
+
     auto tx_search = std::make_unique<MockTxSearch>();
 
     EXPECT_CALL(*tx_search, operator_fcall()) // mock operator()
@@ -928,7 +1727,10 @@ TEST_P(BCSTATUS_TEST, PingSearchThread)
 {
     xmreg::XmrAccount acc; // empty, mock account
 
-    acc.address = "whatever mock address";
+    acc.address = bcs->get_bc_setup().import_payment_address_str;
+
+    account_public_address const& address
+            = bcs->get_bc_setup().import_payment_address.address;
 
     auto tx_search = std::make_unique<MockTxSearch>();
 
@@ -942,9 +1744,9 @@ TEST_P(BCSTATUS_TEST, PingSearchThread)
 
     ASSERT_TRUE(bcs->start_tx_search_thread(acc, std::move(tx_search)));
 
-    EXPECT_TRUE(bcs->ping_search_thread(acc.address));         
+    EXPECT_TRUE(bcs->ping_search_thread(address));
 
-    while(bcs->search_thread_exist(acc.address))
+    while(bcs->search_thread_exist(address))
     {
         cout << "\nsearch thread still exists\n";
         std::this_thread::sleep_for(1s);
@@ -954,7 +1756,70 @@ TEST_P(BCSTATUS_TEST, PingSearchThread)
     // once we removed the search thread as it finshed,
     // we should be getting false now
 
-    EXPECT_FALSE(bcs->ping_search_thread(acc.address));
+    EXPECT_FALSE(bcs->ping_search_thread(address));
+
+    // no new thread for the address until the stopped one
+    // is joined
+    EXPECT_FALSE(bcs->start_tx_search_thread(
+                     acc, std::make_unique<MockTxSearch>()));
+
+    // removed thread is joined by the reaper, not when removed
+    EXPECT_EQ(bcs->reap_search_threads(), 1);
+
+    auto tx_search2 = std::make_unique<MockTxSearch>();
+
+    EXPECT_CALL(*tx_search2, operator_fcall()).WillOnce(Return());
+
+    EXPECT_TRUE(bcs->start_tx_search_thread(acc, std::move(tx_search2)));
+}
+
+TEST_P(BCSTATUS_TEST, FindTxsInMempool)
+{
+    xmreg::XmrAccount acc; // empty, mock account
+
+    acc.address = bcs->get_bc_setup().import_payment_address_str;
+
+    account_public_address const& address
+            = bcs->get_bc_setup().import_payment_address.address;
+
+    auto tx_search = std::make_unique<MockTxSearch>();
+
+    EXPECT_CALL(*tx_search, operator_fcall()) // mock operator()
+            .WillOnce(MockSearchWhile2());
+
+    EXPECT_CALL(*tx_search, still_searching())
+            .WillRepeatedly(Return(false));
+
+    json searched_txs = json::array({json {{"hash", "searched"}}});
+    json found_txs = json::array({json {{"hash", "found"}}});
+
+    // the thread has not searched the mempool yet,
+    // so it is searched on request
+    EXPECT_CALL(*tx_search, get_txs_found_in_mempool())
+            .WillOnce(Return(nullptr))
+            .WillOnce(Return(std::make_shared<json const>(found_txs)));
+
+    EXPECT_CALL(*tx_search, find_txs_in_mempool(_))
+            .WillOnce(Return(searched_txs));
+
+    ASSERT_TRUE(bcs->start_tx_search_thread(acc, std::move(tx_search)));
+
+    json transactions;
+
+    EXPECT_TRUE(bcs->find_txs_in_mempool(address, transactions));
+    EXPECT_EQ(transactions, searched_txs);
+
+    EXPECT_TRUE(bcs->find_txs_in_mempool(address, transactions));
+    EXPECT_EQ(transactions, found_txs);
+
+    while(bcs->search_thread_exist(address))
+    {
+        cout << "\nsearch thread still exists\n";
+        std::this_thread::sleep_for(1s);
+        bcs->clean_search_thread_map();
+    }
+
+    EXPECT_FALSE(bcs->find_txs_in_mempool(address, transactions));
 }
 
 
@@ -963,7 +1828,10 @@ TEST_P(BCSTATUS_TEST, GetSearchedBlkOutputsAndAddrViewkey)
 {
     xmreg::XmrAccount acc; // empty, mock account
 
-    acc.address = "whatever mock address";
+    acc.address = bcs->get_bc_setup().import_payment_address_str;
+
+    account_public_address const& address
+            = bcs->get_bc_setup().import_payment_address.address;
 
     auto tx_search = std::make_unique<MockTxSearch>();
 
@@ -973,15 +1841,6 @@ TEST_P(BCSTATUS_TEST, GetSearchedBlkOutputsAndAddrViewkey)
     EXPECT_CALL(*tx_search, get_searched_blk_no())
             .WillOnce(Return(123));
 
-    xmreg::TxSearch::known_outputs_t outputs_to_return;
-
-    outputs_to_return.insert({crypto::rand<crypto::public_key>(), 33});
-    outputs_to_return.insert({crypto::rand<crypto::public_key>(), 44});
-    outputs_to_return.insert({crypto::rand<crypto::public_key>(), 55});
-
-    EXPECT_CALL(*tx_search, get_known_outputs_keys())
-            .WillOnce(Return(outputs_to_return));
-
     xmreg::TxSearch::addr_view_t mock_address = std::make_pair(
                 bcs->get_bc_setup().import_payment_address,
                 bcs->get_bc_setup().import_payment_viewkey);
@@ -996,18 +1855,14 @@ TEST_P(BCSTATUS_TEST, GetSearchedBlkOutputsAndAddrViewkey)
 
     uint64_t searched_blk_no {0};
 
-    EXPECT_TRUE(bcs->get_searched_blk_no(acc.address, searched_blk_no));
-
-    xmreg::TxSearch::known_outputs_t outputs_returned;
+    EXPECT_TRUE(bcs->get_searched_blk_no(address, searched_blk_no));
 
-    EXPECT_TRUE(bcs->get_known_outputs_keys(acc.address, outputs_returned));
-
-    EXPECT_EQ(outputs_returned.size(), outputs_to_return.size());
+    EXPECT_EQ(searched_blk_no, 123);
 
     address_parse_info address_returned;
     crypto::secret_key viewkey_returned;
 
-    EXPECT_TRUE(bcs->get_xmr_address_viewkey(acc.address,
+    EXPECT_TRUE(bcs->get_xmr_address_viewkey(address,
                                              address_returned,
                                              viewkey_returned));
 
@@ -1023,7 +1878,7 @@ TEST_P(BCSTATUS_TEST, GetSearchedBlkOutputsAndAddrViewkey)
     EXPECT_EQ(address_returned_str, mock_address_str);
     EXPECT_EQ(viewkey_returned, mock_address.second);
 
-    while(bcs->search_thread_exist(acc.address))
+    while(bcs->search_thread_exist(address))
     {
         cout << "\nsearch thread still exists\n";
         std::this_thread::sleep_for(1s);
@@ -1033,14 +1888,31 @@ TEST_P(BCSTATUS_TEST, GetSearchedBlkOutputsAndAddrViewkey)
     // once we removed the search thread as it finshed,
     // we should be getting false now
 
-    EXPECT_FALSE(bcs->get_searched_blk_no(acc.address, searched_blk_no));
-    EXPECT_FALSE(bcs->get_known_outputs_keys(acc.address, outputs_returned));
-    EXPECT_FALSE(bcs->get_xmr_address_viewkey(acc.address,
+    EXPECT_FALSE(bcs->get_searched_blk_no(address, searched_blk_no));
+    EXPECT_FALSE(bcs->get_xmr_address_viewkey(address,
                                              address_returned,
                                              viewkey_returned));
 
 }
 
+TEST_P(BCSTATUS_TEST, TxSearchStateSnapshot)
+{
+    xmreg::TxSearch tx_search;
+
+    tx_search.set_searched_blk_no(10);
+
+    std::shared_ptr<xmreg::TxSearch::state_t const> old_state
+            = tx_search.get_state();
+
+    tx_search.set_searched_blk_no(20);
+
+    // readers keep what they got, while new state is published
+    EXPECT_EQ(old_state->searched_blk_no, 10);
+    EXPECT_EQ(tx_search.get_searched_blk_no(), 20);
+
+    EXPECT_EQ(tx_search.get_txs_found_in_mempool(), nullptr);
+}
+
 
 INSTANTIATE_TEST_CASE_P(
         DifferentMoneroNetworks, BCSTATUS_TEST,
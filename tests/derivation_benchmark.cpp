@@ -0,0 +1,113 @@
+//
+// Compares generating key derivations of one tx pub key for
+// many accounts, with crypto::generate_key_derivation and with
+// PrecomputedTxPubKey, which decompresses the key and builds
+// the table of its multiples once, instead of for each account.
+//
+// Not a test, so it is not run by ctest. Usage:
+//
+//   ./derivation_benchmark [max_no_of_accounts]
+//
+
+#include "../src/PrecomputedTxPubKey.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+
+using namespace std;
+using namespace cryptonote;
+using namespace crypto;
+
+using benchmark_clock = std::chrono::steady_clock;
+
+double
+ns_per_account(benchmark_clock::time_point start,
+               benchmark_clock::time_point stop,
+               size_t no_of_accounts)
+{
+    return std::chrono::duration<double, std::nano>(stop - start).count()
+           / no_of_accounts;
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+    size_t max_no_of_accounts = argc > 1 ? std::atoi(argv[1]) : 10000;
+
+    cout << setw(10) << "accounts"
+         << setw(18) << "plain [ns/acc]"
+         << setw(18) << "precomp [ns/acc]"
+         << setw(10) << "speedup" << '\n';
+
+    for (size_t no_of_accounts = 1;
+         no_of_accounts <= max_no_of_accounts;
+         no_of_accounts *= 10)
+    {
+        vector<secret_key> viewkeys(no_of_accounts);
+
+        for (secret_key& viewkey: viewkeys)
+        {
+            public_key pub_viewkey;
+            generate_keys(pub_viewkey, viewkey);
+        }
+
+        public_key tx_pub_key;
+        secret_key tx_prv_key;
+
+        generate_keys(tx_pub_key, tx_prv_key);
+
+        vector<key_derivation> plain(no_of_accounts);
+        vector<key_derivation> precomputed(no_of_accounts);
+
+        auto start = benchmark_clock::now();
+
+        for (size_t i = 0; i < no_of_accounts; ++i)
+            generate_key_derivation(tx_pub_key, viewkeys[i], plain[i]);
+
+        auto middle = benchmark_clock::now();
+
+        // precomputation is part of the measured time, as it
+        // is done for each tx
+        xmreg::PrecomputedTxPubKey precomputed_tx_pub_key;
+
+        precomputed_tx_pub_key.init(tx_pub_key);
+
+        for (size_t i = 0; i < no_of_accounts; ++i)
+            precomputed_tx_pub_key.generate_key_derivation(
+                    viewkeys[i], precomputed[i]);
+
+        auto stop = benchmark_clock::now();
+
+        for (size_t i = 0; i < no_of_accounts; ++i)
+        {
+            if (std::memcmp(&plain[i], &precomputed[i],
+                            sizeof(key_derivation)) != 0)
+            {
+                cerr << "Derivations differ for account " << i << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+
+        double const plain_ns
+                = ns_per_account(start, middle, no_of_accounts);
+
+        double const precomputed_ns
+                = ns_per_account(middle, stop, no_of_accounts);
+
+        cout << setw(10) << no_of_accounts
+             << setw(18) << fixed << setprecision(0) << plain_ns
+             << setw(18) << precomputed_ns
+             << setw(10) << setprecision(2) << plain_ns / precomputed_ns
+             << '\n';
+    }
+
+    return EXIT_SUCCESS;
+}
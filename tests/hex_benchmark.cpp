@@ -0,0 +1,181 @@
+//
+// Compares converting keys and tx blobs to and from hex
+// with epee::string_tools and with xmreg's hex codec.
+//
+// Not a test, so it is not run by ctest. Usage:
+//
+//   ./hex_benchmark [no_of_repetitions]
+//
+
+#include "../src/tools.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+
+using namespace std;
+using namespace cryptonote;
+using namespace crypto;
+
+using benchmark_clock = std::chrono::steady_clock;
+
+// keeps results alive, so that conversions are not optimized out
+size_t checksum {0};
+
+double
+ns_per_conversion(benchmark_clock::time_point start,
+                  benchmark_clock::time_point stop,
+                  size_t no_of_conversions)
+{
+    return std::chrono::duration<double, std::nano>(stop - start).count()
+           / no_of_conversions;
+}
+
+void
+print_row(string const& name, double epee_ns, double xmreg_ns)
+{
+    cout << setw(20) << name
+         << setw(16) << fixed << setprecision(1) << epee_ns
+         << setw(16) << xmreg_ns
+         << setw(10) << setprecision(2) << epee_ns / xmreg_ns
+         << '\n';
+}
+
+// pod_to_hex and hex_to_pod of a key sized pod
+template <typename T>
+bool
+benchmark_pod(string const& name, size_t no_of_repetitions)
+{
+    T const pod = crypto::rand<T>();
+
+    auto start = benchmark_clock::now();
+
+    for (size_t i = 0; i < no_of_repetitions; ++i)
+        checksum += epee::string_tools::pod_to_hex(pod)[i % 8];
+
+    auto middle = benchmark_clock::now();
+
+    for (size_t i = 0; i < no_of_repetitions; ++i)
+        checksum += xmreg::pod_to_hex(pod)[i % 8];
+
+    auto stop = benchmark_clock::now();
+
+    print_row(name + " to hex",
+              ns_per_conversion(start, middle, no_of_repetitions),
+              ns_per_conversion(middle, stop, no_of_repetitions));
+
+    string const hex = epee::string_tools::pod_to_hex(pod);
+
+    if (xmreg::pod_to_hex(pod) != hex)
+    {
+        cerr << "Hex of " << name << " differs\n";
+        return false;
+    }
+
+    T parsed;
+
+    start = benchmark_clock::now();
+
+    for (size_t i = 0; i < no_of_repetitions; ++i)
+        checksum += epee::string_tools::hex_to_pod(hex, parsed);
+
+    middle = benchmark_clock::now();
+
+    for (size_t i = 0; i < no_of_repetitions; ++i)
+        checksum += xmreg::hex_to_pod(hex, parsed);
+
+    stop = benchmark_clock::now();
+
+    print_row(name + " from hex",
+              ns_per_conversion(start, middle, no_of_repetitions),
+              ns_per_conversion(middle, stop, no_of_repetitions));
+
+    return parsed == pod;
+}
+
+// buff_to_hex and hex_to_buff of a tx sized blob
+bool
+benchmark_blob(size_t blob_size, size_t no_of_repetitions)
+{
+    string blob(blob_size, '\0');
+
+    for (char& c: blob)
+        c = static_cast<char>(crypto::rand<uint8_t>());
+
+    auto start = benchmark_clock::now();
+
+    for (size_t i = 0; i < no_of_repetitions; ++i)
+        checksum += epee::string_tools::buff_to_hex_nodelimer(blob)[i % 8];
+
+    auto middle = benchmark_clock::now();
+
+    for (size_t i = 0; i < no_of_repetitions; ++i)
+        checksum += xmreg::buff_to_hex(blob)[i % 8];
+
+    auto stop = benchmark_clock::now();
+
+    string const name = "blob " + std::to_string(blob_size) + " B";
+
+    print_row(name + " to hex",
+              ns_per_conversion(start, middle, no_of_repetitions),
+              ns_per_conversion(middle, stop, no_of_repetitions));
+
+    string const hex = epee::string_tools::buff_to_hex_nodelimer(blob);
+
+    if (xmreg::buff_to_hex(blob) != hex)
+    {
+        cerr << "Hex of " << name << " differs\n";
+        return false;
+    }
+
+    string parsed;
+
+    start = benchmark_clock::now();
+
+    for (size_t i = 0; i < no_of_repetitions; ++i)
+        checksum += epee::string_tools::parse_hexstr_to_binbuff(hex, parsed);
+
+    middle = benchmark_clock::now();
+
+    for (size_t i = 0; i < no_of_repetitions; ++i)
+        checksum += xmreg::hex_to_buff(hex, parsed);
+
+    stop = benchmark_clock::now();
+
+    print_row(name + " from hex",
+              ns_per_conversion(start, middle, no_of_repetitions),
+              ns_per_conversion(middle, stop, no_of_repetitions));
+
+    return parsed == blob;
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+    size_t no_of_repetitions = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    cout << setw(20) << "conversion"
+         << setw(16) << "epee [ns]"
+         << setw(16) << "xmreg [ns]"
+         << setw(10) << "speedup" << '\n';
+
+    if (!benchmark_pod<hash8>("payment id", no_of_repetitions)
+            || !benchmark_pod<public_key>("public key", no_of_repetitions)
+            || !benchmark_pod<key_image>("key image", no_of_repetitions)
+            || !benchmark_blob(2000, no_of_repetitions / 10)
+            || !benchmark_blob(15000, no_of_repetitions / 100))
+    {
+        cerr << "Conversions differ\n";
+        return EXIT_FAILURE;
+    }
+
+    cout << "checksum: " << checksum << '\n';
+
+    return EXIT_SUCCESS;
+}
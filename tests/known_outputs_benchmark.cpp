@@ -0,0 +1,181 @@
+//
+// Compares memory used by, and lookups in, known outputs
+// kept in std::unordered_map, in KnownOutputsMap, and in
+// KnownOutputsIndex, which splits them into shards, each
+// with its own KnownOutputsMap and lock, as search threads
+// use them.
+//
+// Not a test, so it is not run by ctest. Usage:
+//
+//   ./known_outputs_benchmark [max_no_of_outputs]
+//
+
+#include "../src/KnownOutputsIndex.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+
+namespace
+{
+
+using namespace std;
+using namespace cryptonote;
+using namespace crypto;
+
+using benchmark_clock = std::chrono::steady_clock;
+
+// counts bytes allocated by unordered_map, including its nodes
+size_t allocated_bytes {0};
+
+template <typename T>
+struct counting_allocator
+{
+    using value_type = T;
+
+    counting_allocator() = default;
+
+    template <typename U>
+    counting_allocator(counting_allocator<U> const&) {}
+
+    T*
+    allocate(size_t n)
+    {
+        allocated_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void
+    deallocate(T* p, size_t n)
+    {
+        allocated_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+};
+
+template <typename T, typename U>
+bool
+operator==(counting_allocator<T> const&, counting_allocator<U> const&)
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool
+operator!=(counting_allocator<T> const&, counting_allocator<U> const&)
+{
+    return false;
+}
+
+using known_output_t = xmreg::KnownOutputsMap::known_output_t;
+
+using unordered_known_outputs_t
+    = std::unordered_map<public_key, known_output_t,
+                         std::hash<public_key>,
+                         std::equal_to<public_key>,
+                         counting_allocator<
+                                 std::pair<public_key const, known_output_t>>>;
+
+double
+ns_per_lookup(benchmark_clock::time_point start,
+              benchmark_clock::time_point stop,
+              size_t no_of_lookups)
+{
+    return std::chrono::duration<double, std::nano>(stop - start).count()
+           / no_of_lookups;
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+    size_t max_no_of_outputs = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    // ring members are mostly not ours, so lookups are mostly misses
+    size_t const no_of_lookups {1000000};
+
+    cout << setw(10) << "outputs"
+         << setw(14) << "map [kB]"
+         << setw(14) << "flat [kB]"
+         << setw(16) << "map [ns/look]"
+         << setw(16) << "flat [ns/look]"
+         << setw(14) << "index [kB]"
+         << setw(16) << "index [ns/look]" << '\n';
+
+    for (size_t no_of_outputs = 10;
+         no_of_outputs <= max_no_of_outputs;
+         no_of_outputs *= 10)
+    {
+        vector<public_key> out_pks(no_of_outputs);
+
+        for (public_key& out_pk: out_pks)
+            out_pk = rand<public_key>();
+
+        // every 10th lookup is one of ours
+        vector<public_key> lookups(no_of_lookups);
+
+        for (size_t i = 0; i < no_of_lookups; ++i)
+            lookups[i] = i % 10 == 0 ? out_pks[i % no_of_outputs]
+                                     : rand<public_key>();
+
+        allocated_bytes = 0;
+
+        unordered_known_outputs_t unordered_known_outputs;
+        xmreg::KnownOutputsMap flat_known_outputs;
+        xmreg::KnownOutputsIndex known_outputs_index;
+
+        for (size_t i = 0; i < no_of_outputs; ++i)
+        {
+            known_output_t const known_output {i % 100, i, i};
+
+            unordered_known_outputs.insert({out_pks[i], known_output});
+            flat_known_outputs.insert(out_pks[i], known_output);
+            known_outputs_index.insert(out_pks[i], known_output);
+        }
+
+        size_t found_in_unordered {0};
+        size_t found_in_flat {0};
+        size_t found_in_index {0};
+
+        auto start = benchmark_clock::now();
+
+        for (public_key const& lookup: lookups)
+            found_in_unordered += unordered_known_outputs.count(lookup);
+
+        auto middle = benchmark_clock::now();
+
+        known_output_t known_output;
+
+        for (public_key const& lookup: lookups)
+            found_in_flat += flat_known_outputs.find(lookup, known_output);
+
+        auto stop = benchmark_clock::now();
+
+        for (public_key const& lookup: lookups)
+            found_in_index += known_outputs_index.find(lookup, known_output);
+
+        auto stop_index = benchmark_clock::now();
+
+        if (found_in_unordered != found_in_flat
+                || found_in_unordered != found_in_index)
+        {
+            cerr << "Maps found different number of outputs\n";
+            return EXIT_FAILURE;
+        }
+
+        cout << setw(10) << no_of_outputs
+             << setw(14) << allocated_bytes / 1024
+             << setw(14) << flat_known_outputs.memory_usage() / 1024
+             << setw(16) << fixed << setprecision(1)
+             << ns_per_lookup(start, middle, no_of_lookups)
+             << setw(16) << ns_per_lookup(middle, stop, no_of_lookups)
+             << setw(14) << known_outputs_index.memory_usage() / 1024
+             << setw(16) << ns_per_lookup(stop, stop_index, no_of_lookups)
+             << '\n';
+    }
+
+    return EXIT_SUCCESS;
+}
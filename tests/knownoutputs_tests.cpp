@@ -0,0 +1,81 @@
+//
+// Tests of KnownOutputsMap, which dont need the blockchain
+// or mysql.
+//
+
+#include "../src/KnownOutputsMap.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace
+{
+
+using namespace std;
+using namespace cryptonote;
+
+using xmreg::KnownOutputsMap;
+
+TEST(KNOWN_OUTPUTS_MAP, InsertFindAndErase)
+{
+    KnownOutputsMap known_outputs;
+
+    KnownOutputsMap::known_output_t known_output;
+
+    EXPECT_FALSE(known_outputs.find(crypto::rand<public_key>(), known_output));
+
+    // enough to rehash few times
+    vector<public_key> out_pks(100);
+
+    for (size_t i = 0; i < out_pks.size(); ++i)
+    {
+        out_pks[i] = crypto::rand<public_key>();
+        known_outputs.insert(out_pks[i], {i % 3, i, i * 10});
+    }
+
+    EXPECT_EQ(known_outputs.size(), out_pks.size());
+
+    for (size_t i = 0; i < out_pks.size(); ++i)
+    {
+        ASSERT_TRUE(known_outputs.find(out_pks[i], known_output));
+        EXPECT_EQ(known_output.account_id, i % 3);
+        EXPECT_EQ(known_output.output_id, i);
+        EXPECT_EQ(known_output.amount, i * 10);
+    }
+
+    EXPECT_FALSE(known_outputs.find(crypto::rand<public_key>(), known_output));
+
+    known_outputs.insert(out_pks[0], {0, 0, 1000});
+
+    ASSERT_TRUE(known_outputs.find(out_pks[0], known_output));
+    EXPECT_EQ(known_output.amount, 1000);
+    EXPECT_EQ(known_outputs.size(), out_pks.size());
+
+    size_t no_visited {0};
+
+    known_outputs.for_each([&no_visited](public_key const&,
+                                         KnownOutputsMap::known_output_t const&)
+                           {
+                               ++no_visited;
+                           });
+
+    EXPECT_EQ(no_visited, out_pks.size());
+
+    // erasing moves later outputs of probe sequences back,
+    // so all the other outputs must still be found
+    for (size_t i = 0; i < out_pks.size(); i += 2)
+        EXPECT_TRUE(known_outputs.erase(out_pks[i]));
+
+    EXPECT_FALSE(known_outputs.erase(out_pks[0]));
+    EXPECT_EQ(known_outputs.size(), out_pks.size() / 2);
+
+    for (size_t i = 0; i < out_pks.size(); ++i)
+    {
+        EXPECT_EQ(known_outputs.find(out_pks[i], known_output), i % 2 == 1);
+
+        if (i % 2 == 1)
+            EXPECT_EQ(known_output.output_id, i);
+    }
+}
+
+}
@@ -276,6 +276,34 @@ TEST_F(MICROCORE_TEST, InitializationSuccess)
     EXPECT_TRUE(mcore.get_core().get_db().is_read_only());
 }
 
+class MockBatchReadMicroCore : public xmreg::MicroCore
+{
+public:
+    MOCK_METHOD0(start_batch_read, void());
+
+    MOCK_METHOD0(stop_batch_read, void());
+
+    MOCK_METHOD0(renew_batch_read, void());
+};
+
+TEST(BATCH_READ, StartsAndStopsOnce)
+{
+    MockBatchReadMicroCore mcore;
+
+    EXPECT_CALL(mcore, start_batch_read()).Times(1);
+    EXPECT_CALL(mcore, renew_batch_read()).Times(1);
+    EXPECT_CALL(mcore, stop_batch_read()).Times(1);
+
+    {
+        xmreg::BatchRead batch_read {&mcore};
+
+        // moved from batch read must not stop the transaction
+        xmreg::BatchRead moved_batch_read {std::move(batch_read)};
+
+        moved_batch_read.renew();
+    }
+}
+
 //template <bool open_success>
 //class MockBlockchainDB : public BlockchainLMDB
 //{
@@ -655,6 +655,195 @@ INSTANTIATE_TEST_CASE_P(
                 ));
 
 
+TEST_F(MYSQL_TEST, SelectTxsPagesForAnAccount)
+{
+    ACC_FROM_HEX(owner_addr_5Ajfk);
+
+    vector<xmreg::XmrTransaction> all_txs;
+
+    ASSERT_TRUE(xmr_accounts->select(acc.id.data, all_txs));
+
+    vector<xmreg::XmrTransaction> paged_txs;
+    vector<xmreg::XmrTransaction> txs;
+
+    uint64_t before_id {std::numeric_limits<uint64_t>::max()};
+
+    // 16 txs in 5 tx pages
+    for (size_t i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(xmr_accounts->select_txs_page(acc.id.data, before_id, 5, txs));
+
+        EXPECT_EQ(txs.size(), i < 3 ? 5 : 1);
+
+        for (auto const& tx: txs)
+        {
+            // newest first
+            EXPECT_LT(tx.blockchain_tx_id, before_id);
+            before_id = tx.blockchain_tx_id;
+            paged_txs.push_back(tx);
+        }
+    }
+
+    EXPECT_TRUE(xmr_accounts->select_txs_page(acc.id.data, before_id, 5, txs));
+    EXPECT_TRUE(txs.empty());
+
+    ASSERT_EQ(paged_txs.size(), all_txs.size());
+    EXPECT_EQ(paged_txs.front().hash, all_txs.back().hash);
+    EXPECT_EQ(paged_txs.back().hash , all_txs.front().hash);
+
+    xmr_accounts->disconnect();
+    EXPECT_FALSE(xmr_accounts->select_txs_page(acc.id.data, before_id, 5, txs));
+}
+
+TEST_F(MYSQL_TEST, GetTxsSummaryForAnAccount)
+{
+    ACC_FROM_HEX(owner_addr_5Ajfk);
+
+    uint64_t total_received {0};
+    uint64_t total_received_unlocked {0};
+
+    EXPECT_TRUE(xmr_accounts->get_txs_summary(acc.id.data, total_received,
+                                              total_received_unlocked));
+
+    EXPECT_EQ(total_received, 697348926585540ull);
+    EXPECT_LE(total_received_unlocked, total_received);
+
+    // account without any txs
+    EXPECT_TRUE(xmr_accounts->get_txs_summary(0, total_received,
+                                              total_received_unlocked));
+    EXPECT_EQ(total_received, 0);
+    EXPECT_EQ(total_received_unlocked, 0);
+
+    xmr_accounts->disconnect();
+    EXPECT_FALSE(xmr_accounts->get_txs_summary(acc.id.data, total_received,
+                                               total_received_unlocked));
+}
+
+TEST_F(MYSQL_TEST, TxsSummaryFollowsChangesOfTxs)
+{
+    TX_AND_ACC_FROM_HEX(tx_fc4_hex, owner_addr_5Ajfk);
+
+    xmreg::XmrTransaction tx_data;
+
+    ASSERT_TRUE(xmr_accounts->tx_exists(acc.id.data, tx_hash_str, tx_data));
+    ASSERT_TRUE(static_cast<bool>(tx_data.spendable));
+
+    uint64_t total_received {0};
+    uint64_t total_received_unlocked {0};
+
+    ASSERT_TRUE(xmr_accounts->get_txs_summary(acc.id.data, total_received,
+                                              total_received_unlocked));
+
+    // summary is kept up to date by triggers on Transactions
+    ASSERT_EQ(xmr_accounts->mark_tx_nonspendable(tx_data.id.data), 1);
+
+    uint64_t new_total_received {0};
+    uint64_t new_total_received_unlocked {0};
+
+    ASSERT_TRUE(xmr_accounts->get_txs_summary(acc.id.data,
+                                              new_total_received,
+                                              new_total_received_unlocked));
+
+    EXPECT_EQ(new_total_received, total_received);
+    EXPECT_EQ(new_total_received_unlocked,
+              total_received_unlocked - tx_data.total_received);
+
+    ASSERT_EQ(xmr_accounts->delete_tx(tx_data.id.data), 1);
+
+    ASSERT_TRUE(xmr_accounts->get_txs_summary(acc.id.data,
+                                              new_total_received,
+                                              new_total_received_unlocked));
+
+    EXPECT_EQ(new_total_received, total_received - tx_data.total_received);
+    EXPECT_EQ(new_total_received_unlocked,
+              total_received_unlocked - tx_data.total_received);
+
+    // inserting it back restores the totals
+    tx_data.spendable = true;
+
+    ASSERT_GT(xmr_accounts->insert(tx_data), 0);
+
+    ASSERT_TRUE(xmr_accounts->get_txs_summary(acc.id.data,
+                                              new_total_received,
+                                              new_total_received_unlocked));
+
+    EXPECT_EQ(new_total_received, total_received);
+    EXPECT_EQ(new_total_received_unlocked, total_received_unlocked);
+}
+
+TEST_F(MYSQL_TEST, SelectDataOfManyAccountsInBatch)
+{
+    ACC_FROM_HEX(owner_addr_5Ajfk);
+
+    vector<xmreg::XmrAccount> accounts;
+
+    // not existing addresses are not returned
+    ASSERT_TRUE(xmr_accounts->select(
+            vector<string>{owner_addr_5Ajfk, addr_55Zb, "'not_existing"},
+            accounts));
+
+    ASSERT_EQ(accounts.size(), 2);
+
+    vector<uint64_t> account_ids;
+
+    for (auto const& account: accounts)
+        account_ids.push_back(account.id.data);
+
+    unordered_map<uint64_t, xmreg::XmrTxsSummary> summaries;
+
+    ASSERT_TRUE(xmr_accounts->get_txs_summaries(account_ids, summaries));
+
+    // batch summary must match summary of individual account
+    uint64_t total_received {0};
+    uint64_t total_received_unlocked {0};
+
+    ASSERT_TRUE(xmr_accounts->get_txs_summary(acc.id.data, total_received,
+                                              total_received_unlocked));
+
+    ASSERT_EQ(summaries.count(acc.id.data), 1);
+    EXPECT_EQ(summaries[acc.id.data].total_received, total_received);
+    EXPECT_EQ(summaries[acc.id.data].total_received_unlocked,
+              total_received_unlocked);
+
+    vector<xmreg::XmrTransaction> txs;
+
+    ASSERT_TRUE(xmr_accounts->select(acc.id.data, txs));
+    ASSERT_GT(txs.size(), 2);
+
+    // the cursor is the id of the newest tx
+    EXPECT_EQ(summaries[acc.id.data].last_tx_id, txs.back().id.data);
+
+    vector<xmreg::XmrTransaction> new_txs;
+
+    ASSERT_TRUE(xmr_accounts->select_txs_after(
+            {{acc.id.data, txs.at(txs.size() - 3).id.data}}, new_txs));
+
+    ASSERT_EQ(new_txs.size(), 2);
+    EXPECT_EQ(new_txs.back().hash, txs.back().hash);
+
+    vector<xmreg::XmrInput> inputs;
+
+    ASSERT_TRUE(xmr_accounts->select_inputs_for_accounts(account_ids, inputs));
+    ASSERT_FALSE(inputs.empty());
+
+    vector<uint64_t> output_ids;
+
+    for (auto const& input: inputs)
+        output_ids.push_back(input.output_id);
+
+    vector<xmreg::XmrOutput> outputs;
+
+    ASSERT_TRUE(xmr_accounts->select_outputs_by_ids(output_ids, outputs));
+    EXPECT_FALSE(outputs.empty());
+
+    // empty lists dont execute any query
+    EXPECT_TRUE(xmr_accounts->get_txs_summaries({}, summaries));
+    EXPECT_TRUE(summaries.empty());
+
+    xmr_accounts->disconnect();
+    EXPECT_FALSE(xmr_accounts->get_txs_summaries(account_ids, summaries));
+}
+
 auto
 make_mock_output_data(string last_char_pub_key = "4")
 {
@@ -674,6 +863,8 @@ make_mock_output_data(string last_char_pub_key = "4")
     mock_output_data.rct_amount   = "f02e6d9dd504e6b428170d37b79344cad5538a4ad32f3f7dcebd5b96ac522e07";
     mock_output_data.global_index = 64916;
     mock_output_data.mixin        = 7;
+    mock_output_data.subaddr_major = 1;
+    mock_output_data.subaddr_minor = 2;
     mock_output_data.timestamp    = mysqlpp::DateTime(static_cast<time_t>(44434554));;
 
     return mock_output_data;
@@ -763,6 +954,8 @@ TEST_F(MYSQL_TEST, InsertOneOutput)
     EXPECT_EQ(out_data2.rct_amount, mock_output_data.rct_amount);
     EXPECT_EQ(out_data2.global_index, mock_output_data.global_index);
     EXPECT_EQ(out_data2.mixin, mock_output_data.mixin);
+    EXPECT_EQ(out_data2.subaddr_major, mock_output_data.subaddr_major);
+    EXPECT_EQ(out_data2.subaddr_minor, mock_output_data.subaddr_minor);
     EXPECT_EQ(out_data2.timestamp, mock_output_data.timestamp);
 
     xmr_accounts->disconnect();
@@ -1245,7 +1438,7 @@ TEST_F(MYSQL_TEST, SelectTxsIfAllAreSpendableAndExist)
     txs.clear();
     ASSERT_TRUE(this->xmr_accounts->select(acc.id.data, txs));
 
-    EXPECT_TRUE(this->xmr_accounts->select_txs_for_account_spendability_check(acc.id.data, txs));
+    EXPECT_TRUE(this->xmr_accounts->select_txs_for_account_spendability_check(txs));
 
     // we check if non of the input txs got filtere out
     EXPECT_EQ(txs.size(), no_of_original_txs);
@@ -1293,7 +1486,7 @@ TEST_F(MYSQL_TEST, SelectTxsIfAllAreNonspendableButUnlockedAndExist)
     for (auto const& tx: txs)
         ASSERT_FALSE(bool {tx.spendable});
 
-    EXPECT_TRUE(this->xmr_accounts->select_txs_for_account_spendability_check(acc.id.data, txs));
+    EXPECT_TRUE(this->xmr_accounts->select_txs_for_account_spendability_check(txs));
 
     // we check if non of the input txs got filtere out
     EXPECT_EQ(txs.size(), no_of_original_txs);
@@ -1364,7 +1557,7 @@ TEST_F(MYSQL_TEST, SelectTxsIfAllAreNonspendableLockedButExist)
             ASSERT_EQ(tx.unlock_time, 0);
     }
 
-    EXPECT_TRUE(this->xmr_accounts->select_txs_for_account_spendability_check(acc.id.data, txs));
+    EXPECT_TRUE(this->xmr_accounts->select_txs_for_account_spendability_check(txs));
 
     // we check if non of the input txs got filtere out
     EXPECT_EQ(txs.size(), no_of_original_txs);
@@ -1418,7 +1611,7 @@ TEST_F(MYSQL_TEST, SelectTxsIfAllAreNonspendableUnlockedAndDontExist)
     for (auto const& tx: txs)
         ASSERT_FALSE(bool {tx.spendable});
 
-    EXPECT_TRUE(this->xmr_accounts->select_txs_for_account_spendability_check(acc.id.data, txs));
+    EXPECT_TRUE(this->xmr_accounts->select_txs_for_account_spendability_check(txs));
 
     // after the call to select_txs_for_account_spendability_check
     // all txs should be filted out
@@ -1468,14 +1661,56 @@ TEST_F(MYSQL_TEST, SelectTxsFailureDueToSpendabilityAndTxDeletion)
     }
 
     // the non-exisiting ids should result in failure
-    EXPECT_FALSE(this->xmr_accounts->select_txs_for_account_spendability_check(acc.id.data, txs));
+    EXPECT_FALSE(this->xmr_accounts->select_txs_for_account_spendability_check(txs));
 
     // now repeat if all txs are locked and dont exisit in blockchain
     mock_bc_status->tx_unlock_state = false;
 
     // also should lead to false
-    EXPECT_FALSE(this->xmr_accounts->select_txs_for_account_spendability_check(acc.id.data, txs));
+    EXPECT_FALSE(this->xmr_accounts->select_txs_for_account_spendability_check(txs));
+
+}
+
+TEST_F(MYSQL_TEST, SelectTxsOfManyAccountsForSpendabilityCheck)
+{
+    auto mock_bc_status = make_shared<MockCurrentBlockchainStatus1>();
+
+    // all txs are locked and dont exist in blockchain
+    mock_bc_status->tx_unlock_state = false;
+    mock_bc_status->tx_exist_state = false;
+
+    xmr_accounts->set_bc_status_provider(mock_bc_status);
+
+    vector<xmreg::XmrAccount> accounts;
+
+    ASSERT_TRUE(xmr_accounts->select(
+            vector<string>{owner_addr_5Ajfk, addr_55Zb}, accounts));
+    ASSERT_EQ(accounts.size(), 2);
+
+    vector<uint64_t> account_ids;
+    vector<xmreg::XmrTransaction> txs;
+
+    for (auto const& account: accounts)
+    {
+        vector<xmreg::XmrTransaction> account_txs;
+
+        ASSERT_TRUE(xmr_accounts->select(account.id.data, account_txs));
+        ASSERT_FALSE(account_txs.empty());
+
+        xmr_accounts->mark_tx_nonspendable(account_txs.front().id.data);
+
+        account_ids.push_back(account.id.data);
+    }
+
+    ASSERT_TRUE(xmr_accounts->select_nonspendable_txs(account_ids, txs));
+    ASSERT_GE(txs.size(), 2);
+
+    // orphaned txs of both accounts are deleted at once
+    EXPECT_TRUE(xmr_accounts->select_txs_for_spendability_check(txs));
+    EXPECT_TRUE(txs.empty());
 
+    ASSERT_TRUE(xmr_accounts->select_nonspendable_txs(account_ids, txs));
+    EXPECT_TRUE(txs.empty());
 }
 
 
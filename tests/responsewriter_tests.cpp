@@ -0,0 +1,152 @@
+//
+// Tests of ResponseWriter, which writes responses without
+// building json objects first.
+//
+
+#include "../src/ResponseWriter.h"
+#include "../src/tools.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace
+{
+
+using json = nlohmann::json;
+using namespace std;
+
+TEST(RESPONSE_WRITER, Json)
+{
+    string buffer;
+
+    xmreg::ResponseWriter writer {buffer};
+
+    writer.begin_object()
+          .key("text").value("quote\" backslash\\ newline\n tab\t \x01")
+          .key("numbers").begin_array()
+                .value(0).value(-1).value(uint64_t {18446744073709551615ull})
+                .value(int64_t {-9223372036854775807ll - 1})
+          .end_array()
+          .key("flags").begin_array().value(true).value(false).null()
+          .end_array()
+          .key("empty").begin_object().end_object()
+          .key("tx").value(json {{"hash", "ab"}})
+          .end_object();
+
+    EXPECT_EQ(buffer,
+              R"({"text":"quote\" backslash\\ newline\n tab\t \u0001",)"
+              R"("numbers":[0,-1,18446744073709551615,-9223372036854775808],)"
+              R"("flags":[true,false,null],"empty":{},"tx":{"hash":"ab"}})");
+
+    // what is written is valid json
+    json const j = json::parse(buffer);
+
+    EXPECT_EQ(j["text"], "quote\" backslash\\ newline\n tab\t \x01");
+
+    // too deep nesting and closing more than was opened throw
+    xmreg::ResponseWriter deep_writer {buffer};
+
+    for (size_t i = 0; i < xmreg::ResponseWriter::MAX_DEPTH; ++i)
+        deep_writer.begin_array();
+
+    EXPECT_THROW(deep_writer.begin_array(), std::runtime_error);
+
+    xmreg::ResponseWriter unbalanced_writer {buffer};
+
+    EXPECT_THROW(unbalanced_writer.end_object(), std::runtime_error);
+
+    // default writers reuse thread local buffer, which is
+    // cleared for each new writer
+    string const* thread_buffer {nullptr};
+
+    {
+        xmreg::ResponseWriter thread_writer;
+        thread_writer.begin_array().value(1).end_array();
+
+        EXPECT_EQ(thread_writer.str(), "[1]");
+
+        thread_buffer = &thread_writer.str();
+    }
+
+    {
+        xmreg::ResponseWriter thread_writer;
+
+        EXPECT_EQ(&thread_writer.str(), thread_buffer);
+        EXPECT_TRUE(thread_writer.str().empty());
+
+        // too large buffers are not kept for the next writer
+        string const large(xmreg::ResponseWriter::MAX_RETAINED_CAPACITY + 1,
+                           'x');
+        thread_writer.value(large);
+
+        EXPECT_GT(thread_writer.str().capacity(),
+                  xmreg::ResponseWriter::MAX_RETAINED_CAPACITY);
+    }
+
+    xmreg::ResponseWriter thread_writer;
+
+    EXPECT_LE(thread_writer.str().capacity(),
+              xmreg::ResponseWriter::MAX_RETAINED_CAPACITY);
+}
+
+TEST(RESPONSE_WRITER, BinaryFormats)
+{
+    json const j_plain {{"height", 5}, {"status", "success"},
+                        {"outputs", {1, -2, 300}}, {"mempool", false},
+                        {"reason", nullptr}};
+
+    // without hex fields, output is same as that of json.hpp
+    for (auto format: {xmreg::ResponseWriter::Format::CBOR,
+                       xmreg::ResponseWriter::Format::MSGPACK})
+    {
+        string buffer;
+        xmreg::ResponseWriter writer {buffer, format};
+
+        writer.value(j_plain);
+
+        vector<uint8_t> expected
+                = format == xmreg::ResponseWriter::Format::CBOR
+                  ? json::to_cbor(j_plain) : json::to_msgpack(j_plain);
+
+        EXPECT_EQ(buffer, string(expected.begin(), expected.end()));
+    }
+
+    string buffer;
+
+    xmreg::ResponseWriter cbor_writer {buffer, xmreg::ResponseWriter::Format::CBOR};
+
+    cbor_writer.begin_object()
+               .key("payment_id").value("0123456789abcdef")
+               .key("tx_pub_key").value("")
+               .key("hash").value("not hex")
+               .key("spend_key_images").begin_array()
+                    .value("ff00")
+               .end_array()
+               .end_object();
+
+    // keys and hashes are byte strings (major type 2),
+    // other strings are text (major type 3)
+    EXPECT_EQ(xmreg::buff_to_hex(buffer),
+              "bf"
+              "6a7061796d656e745f6964" "480123456789abcdef"
+              "6a74785f7075625f6b6579" "40"
+              "6468617368" "676e6f7420686578"
+              "707370656e645f6b65795f696d61676573" "9f" "42ff00" "ff"
+              "ff");
+
+    xmreg::ResponseWriter msgpack_writer {buffer,
+                                      xmreg::ResponseWriter::Format::MSGPACK};
+
+    msgpack_writer.begin_object()
+                  .key("key_image").value("ff00")
+                  .key("amount").value(-3)
+                  .end_object();
+
+    // streamed maps and arrays have 32-bit sizes
+    EXPECT_EQ(xmreg::buff_to_hex(buffer),
+              "df00000002"
+              "a96b65795f696d616765" "c402ff00"
+              "a6616d6f756e74" "fd");
+}
+
+}
@@ -0,0 +1,61 @@
+//
+// Tests of SessionTokens, which dont need the blockchain
+// or mysql.
+//
+
+#include "../src/SessionTokens.h"
+#include "../src/TxSearch.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace
+{
+
+using namespace std;
+
+using ::testing::Return;
+
+class MockTxSearch : public xmreg::TxSearch
+{
+public:
+    MOCK_METHOD0(operator_fcall, void());
+    void operator()() override {operator_fcall();}
+
+    MOCK_CONST_METHOD0(still_searching, bool());
+};
+
+TEST(SESSION_TOKENS, ExpireWithSearchThread)
+{
+    string const address {"mock address"};
+
+    auto tx_search = std::make_unique<MockTxSearch>();
+
+    EXPECT_CALL(*tx_search, operator_fcall()) // mock operator()
+            .WillOnce(Return());
+
+    EXPECT_CALL(*tx_search, still_searching())
+            .WillOnce(Return(true))
+            .WillRepeatedly(Return(false));
+
+    auto search_thread = std::make_shared<
+            xmreg::SessionTokens::search_thread_t>(std::move(tx_search));
+
+    xmreg::SessionTokens session_tokens;
+
+    string token = session_tokens.insert(address, search_thread);
+
+    EXPECT_EQ(token.size(), 64);
+
+    EXPECT_NE(session_tokens.find(token, address), nullptr);
+
+    // tokens are only for accounts they were issued for
+    EXPECT_EQ(session_tokens.find(token, "other address"), nullptr);
+    EXPECT_EQ(session_tokens.find("unknown token", address), nullptr);
+
+    // expires once the search thread stops searching
+    EXPECT_EQ(session_tokens.find(token, address), nullptr);
+    EXPECT_EQ(session_tokens.size(), 0);
+}
+
+}
@@ -0,0 +1,68 @@
+//
+// Tests of SubaddressTable, which dont need the blockchain
+// or mysql.
+//
+
+#include "../src/SubaddressTable.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace
+{
+
+using namespace std;
+using namespace cryptonote;
+
+TEST(SUBADDRESS_TABLE, FindsSubaddressesWithinLookahead)
+{
+    account_base account;
+    account.generate();
+
+    account_keys const& keys = account.get_keys();
+
+    address_parse_info address {keys.m_account_address, false, false,
+                                crypto::null_hash8};
+
+    xmreg::SubaddressTable subaddresses {address, keys.m_view_secret_key,
+                                         2, 3};
+
+    EXPECT_EQ(subaddresses.size(), 6);
+
+    hw::device& hwdev = hw::get_device("default");
+
+    subaddress_index found_index;
+
+    for (uint32_t major = 0; major < 2; ++major)
+    {
+        for (uint32_t minor = 0; minor < 3; ++minor)
+        {
+            public_key spend_public_key
+                    = hwdev.get_subaddress_spend_public_key(
+                            keys, subaddress_index {major, minor});
+
+            ASSERT_TRUE(subaddresses.find(spend_public_key, found_index));
+
+            EXPECT_EQ(found_index.major, major);
+            EXPECT_EQ(found_index.minor, minor);
+        }
+    }
+
+    // (0, 0) is the main address
+    ASSERT_TRUE(subaddresses.find(keys.m_account_address.m_spend_public_key,
+                                  found_index));
+
+    EXPECT_EQ(found_index.major, 0);
+    EXPECT_EQ(found_index.minor, 0);
+
+    // subaddresses beyond lookahead are not there
+    EXPECT_FALSE(subaddresses.find(
+            hwdev.get_subaddress_spend_public_key(keys, {2, 0}),
+            found_index));
+
+    EXPECT_FALSE(subaddresses.find(
+            hwdev.get_subaddress_spend_public_key(keys, {0, 3}),
+            found_index));
+}
+
+}
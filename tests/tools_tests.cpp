@@ -0,0 +1,278 @@
+//
+// Tests of helper functions in tools.h, which dont need
+// the blockchain or mysql.
+//
+
+#include "../src/tools.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <array>
+
+namespace
+{
+
+using namespace std;
+using namespace cryptonote;
+using namespace epee::string_tools;
+
+TEST(PARSE_DATE, ValidDates)
+{
+    uint64_t timestamp {0};
+
+    EXPECT_TRUE(xmreg::parse_date("1970-01-01", timestamp));
+    EXPECT_EQ(timestamp, 0);
+
+    EXPECT_TRUE(xmreg::parse_date("2018-07-15", timestamp));
+    EXPECT_EQ(timestamp, 1531612800);
+
+    // leap years
+    EXPECT_TRUE(xmreg::parse_date("2016-02-29", timestamp));
+    EXPECT_EQ(timestamp, 1456704000);
+
+    EXPECT_TRUE(xmreg::parse_date("2000-02-29", timestamp));
+    EXPECT_EQ(timestamp, 951782400);
+}
+
+TEST(PARSE_DATE, InvalidDates)
+{
+    uint64_t timestamp {0};
+
+    EXPECT_FALSE(xmreg::parse_date("", timestamp));
+    EXPECT_FALSE(xmreg::parse_date("2018-07", timestamp));
+    EXPECT_FALSE(xmreg::parse_date("2018-07-15x", timestamp));
+    EXPECT_FALSE(xmreg::parse_date("1969-12-31", timestamp));
+    EXPECT_FALSE(xmreg::parse_date("2018-13-01", timestamp));
+    EXPECT_FALSE(xmreg::parse_date("2018-00-01", timestamp));
+    EXPECT_FALSE(xmreg::parse_date("2018-07-00", timestamp));
+    EXPECT_FALSE(xmreg::parse_date("2018-04-31", timestamp));
+    EXPECT_FALSE(xmreg::parse_date("2018-02-29", timestamp));
+    EXPECT_FALSE(xmreg::parse_date("2100-02-29", timestamp));
+    EXPECT_FALSE(xmreg::parse_date("2016-02-30", timestamp));
+}
+
+TEST(TX_EXTRA, ParseTxExtraInfo)
+{
+    public_key tx_pub_key1 = crypto::rand<public_key>();
+    public_key tx_pub_key2 = crypto::rand<public_key>();
+
+    vector<public_key> additional_tx_pub_keys {crypto::rand<public_key>(),
+                                               crypto::rand<public_key>()};
+
+    crypto::hash payment_id = crypto::rand<crypto::hash>();
+    crypto::hash8 payment_id8 = crypto::rand<crypto::hash8>();
+
+    // empty extra
+    xmreg::tx_extra_info info = xmreg::parse_tx_extra_info({});
+
+    EXPECT_EQ(info.tx_pub_key, null_pkey);
+    EXPECT_TRUE(info.additional_tx_pub_keys.empty());
+    EXPECT_TRUE(info.get_payment_id_str().empty());
+
+    // with two pub keys, the second one is used, as in wallet2
+    vector<uint8_t> extra;
+
+    ASSERT_TRUE(add_tx_pub_key_to_extra(extra, tx_pub_key1));
+    ASSERT_TRUE(add_tx_pub_key_to_extra(extra, tx_pub_key2));
+    ASSERT_TRUE(add_additional_tx_pub_keys_to_extra(extra,
+                                                    additional_tx_pub_keys));
+
+    string nonce;
+    set_payment_id_to_tx_extra_nonce(nonce, payment_id);
+    ASSERT_TRUE(add_extra_nonce_to_tx_extra(extra, nonce));
+
+    info = xmreg::parse_tx_extra_info(extra);
+
+    EXPECT_EQ(pod_to_hex(info.tx_pub_key), pod_to_hex(tx_pub_key2));
+    ASSERT_EQ(info.additional_tx_pub_keys.size(), 2);
+    EXPECT_EQ(pod_to_hex(info.additional_tx_pub_keys[1]),
+              pod_to_hex(additional_tx_pub_keys[1]));
+
+    // plain payment id
+    EXPECT_EQ(info.payment_id, payment_id);
+    EXPECT_EQ(info.payment_id8, null_hash8);
+    EXPECT_EQ(info.get_payment_id_str(), pod_to_hex(payment_id));
+
+    // third pub key does not replace the second one
+    ASSERT_TRUE(add_tx_pub_key_to_extra(extra, tx_pub_key1));
+
+    info = xmreg::parse_tx_extra_info(extra);
+
+    EXPECT_EQ(pod_to_hex(info.tx_pub_key), pod_to_hex(tx_pub_key2));
+
+    // encrypted payment id
+    extra.clear();
+
+    ASSERT_TRUE(add_tx_pub_key_to_extra(extra, tx_pub_key1));
+
+    nonce.clear();
+    set_encrypted_payment_id_to_tx_extra_nonce(nonce, payment_id8);
+    ASSERT_TRUE(add_extra_nonce_to_tx_extra(extra, nonce));
+
+    info = xmreg::parse_tx_extra_info(extra);
+
+    EXPECT_EQ(pod_to_hex(info.tx_pub_key), pod_to_hex(tx_pub_key1));
+    EXPECT_EQ(info.payment_id, null_hash);
+    EXPECT_EQ(info.payment_id8, payment_id8);
+    EXPECT_EQ(info.get_payment_id_str(), pod_to_hex(payment_id8));
+
+    // partially parsed extra, i.e., with unknown field at
+    // its end, keeps pub keys but not the payment id
+    extra.push_back(0xff);
+    extra.push_back(0x01);
+
+    info = xmreg::parse_tx_extra_info(extra);
+
+    EXPECT_EQ(pod_to_hex(info.tx_pub_key), pod_to_hex(tx_pub_key1));
+    EXPECT_TRUE(info.nonce.empty());
+    EXPECT_EQ(info.payment_id8, null_hash8);
+    EXPECT_TRUE(info.get_payment_id_str().empty());
+
+    // extra cut in the middle of the pub key field
+    extra.resize(10);
+
+    info = xmreg::parse_tx_extra_info(extra);
+
+    EXPECT_EQ(info.tx_pub_key, null_pkey);
+}
+
+TEST(TX_OUTPUTS_INPUTS, OutputsAndInputsToKey)
+{
+    transaction tx;
+
+    txout_to_key out_to_key1 {crypto::rand<public_key>()};
+    txout_to_key out_to_key2 {crypto::rand<public_key>()};
+
+    tx.vout.push_back(tx_out {100, out_to_key1});
+    tx.vout.push_back(tx_out {200, txout_to_scripthash {}});
+    tx.vout.push_back(tx_out {300, out_to_key2});
+
+    // outputs of other types are skipped, but indices of
+    // outputs to keys are still their indices in the tx
+    vector<xmreg::output_to_key_ref> outputs;
+
+    for (xmreg::output_to_key_ref const& out: xmreg::outputs_to_key(tx))
+        outputs.push_back(out);
+
+    ASSERT_EQ(outputs.size(), 2);
+
+    EXPECT_EQ(pod_to_hex(outputs[0].txout_k.key),
+              pod_to_hex(out_to_key1.key));
+    EXPECT_EQ(outputs[0].amount, 100);
+    EXPECT_EQ(outputs[0].idx_in_tx, 0);
+
+    EXPECT_EQ(pod_to_hex(outputs[1].txout_k.key),
+              pod_to_hex(out_to_key2.key));
+    EXPECT_EQ(outputs[1].amount, 300);
+    EXPECT_EQ(outputs[1].idx_in_tx, 2);
+
+    // references to the tx, not copies
+    EXPECT_EQ(&outputs[1].txout_k,
+              &boost::get<txout_to_key>(tx.vout[2].target));
+
+    // no outputs to keys at all
+    transaction tx2;
+
+    tx2.vout.push_back(tx_out {200, txout_to_scripthash {}});
+
+    EXPECT_TRUE(xmreg::outputs_to_key(tx2).begin()
+                == xmreg::outputs_to_key(tx2).end());
+
+    // inputs
+    tx.vin.push_back(txin_gen {1000});
+    tx.vin.push_back(txin_to_key {0, {1, 2, 3},
+                                  crypto::rand<crypto::key_image>()});
+    tx.vin.push_back(txin_to_scripthash {});
+
+    size_t no_of_inputs {0};
+
+    for (txin_to_key const& in_key: xmreg::inputs_to_key(tx))
+    {
+        EXPECT_EQ(&in_key, &boost::get<txin_to_key>(tx.vin[1]));
+        EXPECT_EQ(in_key.key_offsets.size(), 3);
+        ++no_of_inputs;
+    }
+
+    EXPECT_EQ(no_of_inputs, 1);
+}
+
+TEST(HEX_CODEC, AllVariants)
+{
+    // long enough for avx2, sse2 and scalar parts to be used
+    std::array<crypto::hash, 3> hashes {
+            crypto::rand<crypto::hash>(),
+            crypto::rand<crypto::hash>(),
+            crypto::rand<crypto::hash>()};
+
+    string const hex = xmreg::pod_to_hex(hashes);
+
+    EXPECT_EQ(hex, epee::string_tools::pod_to_hex(hashes));
+
+    std::array<crypto::hash, 3> parsed;
+
+    ASSERT_TRUE(xmreg::hex_to_pod(boost::to_upper_copy(hex), parsed));
+    EXPECT_EQ(parsed, hashes);
+
+    string bad_hex = hex;
+    bad_hex[70] = 'g';
+
+    EXPECT_FALSE(xmreg::hex_to_pod(bad_hex, parsed));
+    EXPECT_FALSE(xmreg::hex_to_pod(hex.substr(1), parsed));
+    EXPECT_EQ(parsed, hashes);
+
+    string buff;
+
+    EXPECT_TRUE(xmreg::hex_to_buff(hex.substr(0, 10), buff));
+    EXPECT_EQ(xmreg::buff_to_hex(buff), hex.substr(0, 10));
+    EXPECT_FALSE(xmreg::hex_to_buff(hex.substr(0, 11), buff));
+
+    // only the fastest variant is used above, so each one is
+    // tested with lengths which end in their scalar, sse2
+    // or avx2 parts
+    for (xmreg::hex_codec_t const& codec: xmreg::get_hex_codecs())
+    {
+        for (size_t no_of_bytes: {0, 1, 15, 16, 17, 31, 33, 51})
+        {
+            SCOPED_TRACE(string {codec.name} + ", "
+                         + std::to_string(no_of_bytes) + " bytes");
+
+            string const bytes(reinterpret_cast<char const*>(hashes.data()),
+                               no_of_bytes);
+
+            string codec_hex(2 * no_of_bytes, '\0');
+
+            codec.encode(reinterpret_cast<unsigned char const*>(bytes.data()),
+                         no_of_bytes, &codec_hex[0]);
+
+            EXPECT_EQ(codec_hex,
+                      epee::string_tools::buff_to_hex_nodelimer(bytes));
+
+            string const upper_hex = boost::to_upper_copy(codec_hex);
+
+            string decoded(no_of_bytes, '\0');
+
+            EXPECT_TRUE(codec.decode(
+                            upper_hex.data(), no_of_bytes,
+                            reinterpret_cast<unsigned char*>(&decoded[0])));
+
+            EXPECT_EQ(decoded, bytes);
+
+            if (no_of_bytes == 0)
+                continue;
+
+            // bad chars in the first vector and in the tail
+            for (size_t bad_pos: {size_t {0}, codec_hex.size() - 1})
+            {
+                string bad_codec_hex = codec_hex;
+                bad_codec_hex[bad_pos] = 'g';
+
+                EXPECT_FALSE(codec.decode(
+                            bad_codec_hex.data(), no_of_bytes,
+                            reinterpret_cast<unsigned char*>(&decoded[0])));
+            }
+        }
+    }
+}
+
+}
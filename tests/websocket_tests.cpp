@@ -0,0 +1,95 @@
+//
+// Tests of websocket subscriptions to account events,
+// which dont need the blockchain or mysql.
+//
+
+#include "../src/AccountEvents.h"
+#include "../src/YourMoneroRequests.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+namespace
+{
+
+using json = nlohmann::json;
+using namespace std;
+
+TEST(ACCOUNT_EVENTS, Subscriptions)
+{
+    xmreg::AccountEvents account_events;
+
+    auto socket1 = std::make_shared<restbed::WebSocket>();
+    auto socket2 = std::make_shared<restbed::WebSocket>();
+
+    socket1->set_key("socket1");
+    socket2->set_key("socket2");
+
+    account_events.subscribe("address1", socket1);
+    account_events.subscribe("address1", socket2);
+
+    EXPECT_TRUE(account_events.has_subscribers("address1"));
+    EXPECT_FALSE(account_events.has_subscribers("address2"));
+    EXPECT_EQ(account_events.no_of_subscribers(), 2);
+
+    // socket can be subscribed to one address only
+    account_events.subscribe("address2", socket2);
+
+    EXPECT_EQ(account_events.no_of_subscribers(), 2);
+    EXPECT_TRUE(account_events.has_subscribers("address2"));
+
+    vector<string> addresses = account_events.get_subscribed_addresses();
+    std::sort(addresses.begin(), addresses.end());
+
+    EXPECT_EQ(addresses, (vector<string>{"address1", "address2"}));
+
+    account_events.unsubscribe(socket1);
+
+    EXPECT_FALSE(account_events.has_subscribers("address1"));
+    EXPECT_EQ(account_events.no_of_subscribers(), 1);
+
+    // sockets which no longer exist are removed when publishing
+    socket2.reset();
+
+    account_events.publish("address2", {{"event", "scan_progress"}});
+
+    EXPECT_FALSE(account_events.has_subscribers("address2"));
+    EXPECT_EQ(account_events.no_of_subscribers(), 0);
+
+    // nothing to do for addresses without subscribers
+    account_events.publish("address3", {{"event", "scan_progress"}});
+
+    // closing subscriptions removes them, even if their
+    // sockets no longer exist
+    auto socket3 = std::make_shared<restbed::WebSocket>();
+    socket3->set_key("socket3");
+
+    account_events.subscribe("address3", socket3);
+    socket3.reset();
+
+    account_events.close_subscriptions("address3", {{"event", "unsubscribed"}});
+
+    EXPECT_FALSE(account_events.has_subscribers("address3"));
+    EXPECT_EQ(account_events.no_of_subscribers(), 0);
+}
+
+TEST(WEBSOCKET, HandshakeHeaders)
+{
+    auto request = std::make_shared<restbed::Request>();
+
+    // example from RFC 6455
+    request->set_header("Sec-WebSocket-Key", "dGhlIHNhbXBsZSBub25jZQ==");
+
+    auto headers = xmreg::YourMoneroRequests
+            ::make_websocket_handshake_headers(request);
+
+    ASSERT_EQ(headers.count("Sec-WebSocket-Accept"), 1);
+    EXPECT_EQ(headers.find("Sec-WebSocket-Accept")->second,
+              "s3pPLMBiTxaQ9kYGB3zDo5dR0pE=");
+    EXPECT_EQ(headers.find("Upgrade")->second, "websocket");
+    EXPECT_EQ(headers.find("Connection")->second, "Upgrade");
+}
+
+}